@@ -2,6 +2,7 @@
 #define ZWUtils_LocalComm_H
 
 #include "Misc/TString.h"
+#include "Misc/Histogram.h"
 #include "Debug/Exception.h"
 #include "Memory/ManagedRef.h"
 #include "Threading/SyncElements.h"
@@ -30,6 +31,14 @@ public:
 	virtual THandle const& Handle(void) const {
 		FAIL(_T("Abstract Function"));
 	}
+	// Time from starting to completing each transmission
+	virtual THistogram::TSnapshot SendLatency(void) const {
+		FAIL(_T("Abstract Function"));
+	}
+	// Time each Receive() call waited
+	virtual THistogram::TSnapshot ReceiveLatency(void) const {
+		FAIL(_T("Abstract Function"));
+	}
 };
 
 typedef ManagedRef<ILocalCommEndPoint> MRLocalCommEndPoint;
@@ -2,6 +2,8 @@
 
 #ifdef WINDOWS
 
+#include "Debug/FlightRecorder.h"
+
 #include "Threading/SyncContainers.h"
 #include "Threading/WorkerThread.h"
 
@@ -25,7 +27,7 @@ class TNamedPipeServer : public INamedPipeServer {
 
 		TServRec(TString const &Path, DWORD BufferSize, FLocalCommClientConnect const &OnConnect,
 				 THandleWaitable &TermSignal, TString const &DACL)
-			: _Name(TStringCast(NAMEDPIPE_SERVER_NAMEPFX << _T('<') << Path << _T('>')))
+			: _Name(TStringFmt(NAMEDPIPE_SERVER_NAMEPFX << _T('<') << Path << _T('>')))
 			, _Path(Path), _BufferSize(BufferSize), _OnConnect(OnConnect)
 			, _TermSignal(TermSignal), _DACL(DACL), _IntTermSignal(true)
 		{}
@@ -88,17 +90,20 @@ class TNamedPipeEndPoint : public ILocalCommEndPoint {
 		TCommBufferQueue _OutQueue;
 		THandleWaitable &_TermSignal;
 		TEvent _IntTermSignal;
+		THistogram _SendLatency;
+		THistogram _ReceiveLatency;
 
 		TServRec(TString && Name, THandle && Pipe, DWORD BufferSize, THandleWaitable &TermSignal)
 			: _Name(std::move(Name)), _Pipe(std::move(Pipe)), _BufferSize(BufferSize)
-			, _InQueue(TStringCast(_Name << _T("-InQ")))
-			, _OutQueue(TStringCast(_Name << _T("-OutQ")))
+			, _InQueue(TStringFmt(_Name << _T("-InQ")))
+			, _OutQueue(TStringFmt(_Name << _T("-OutQ")))
 			, _TermSignal(TermSignal), _IntTermSignal(true)
 		{}
 	};
 
 	class TServRunnable : public TRunnable {
 		ManagedRef<TServRec> _ServRec;
+		TMonotonicStamp _WriteStart;
 	protected:
 		bool __Handle_AsyncReadInitiate(TDynBuffer &InBuffer, OVERLAPPED &AsyncRead, THandle &ReadSignalHandle, TWorkerThread & WorkerThread);
 		bool __Handle_AsyncReadCompletion(TDynBuffer &InBuffer, OVERLAPPED &AsyncRead, TEvent &ReadEvent, TWorkerThread &WorkerThread);
@@ -138,6 +143,7 @@ public:
 	}
 
 	virtual bool Receive(TDynBuffer & Buffer, WAITTIME Timeout = FOREVER) override {
+		THistogram::TScopedTimer ReceiveTimer(&_ServRec->_ReceiveLatency);
 		return isConnected() && _ServRec->_InQueue.Pop_Front(Buffer, Timeout,
 															 &_ServRec->_IntTermSignal);
 	}
@@ -158,13 +164,23 @@ public:
 		return _ServRec->_Pipe;
 	}
 
+	virtual THistogram::TSnapshot SendLatency(void) const override {
+		return _ServRec->_SendLatency.Snapshot();
+	}
+
+	virtual THistogram::TSnapshot ReceiveLatency(void) const override {
+		return _ServRec->_ReceiveLatency.Snapshot();
+	}
+
 };
 
 #define NPLogHeader _T("{%s} ")
 
-#define NPLOG(s, ...)		LOG(NPLogHeader s, _ServRec->_Name.c_str(), __VA_ARGS__)
-#define NPLOGV(s, ...)		LOGV(NPLogHeader s, _ServRec->_Name.c_str(), __VA_ARGS__)
-#define NPLOGVV(s, ...)		LOGVV(NPLogHeader s, _ServRec->_Name.c_str(), __VA_ARGS__)
+LOGMODULE_DEFINE(LOGMODULE_NPIPE, _T("NPipe"));
+
+#define NPLOG(s, ...)		MLOG(LOGMODULE_NPIPE, NPLogHeader s, _ServRec->_Name.c_str(), __VA_ARGS__)
+#define NPLOGV(s, ...)		MLOGV(LOGMODULE_NPIPE, NPLogHeader s, _ServRec->_Name.c_str(), __VA_ARGS__)
+#define NPLOGVV(s, ...)		MDLOGVV(LOGMODULE_NPIPE, NPLogHeader s, _ServRec->_Name.c_str(), __VA_ARGS__)
 #define NPERRLOG(e, s, ...)		ERRLOG(e, NPLogHeader s, _ServRec->_Name.c_str(), __VA_ARGS__)
 #define NPSYSERRLOG(s, ...)		SYSERRLOG(NPLogHeader s, _ServRec->_Name.c_str(), __VA_ARGS__)
 #define NPFAIL(s, ...)			FAIL(NPLogHeader s, _ServRec->_Name.c_str(), __VA_ARGS__)
@@ -192,21 +208,28 @@ case 1:																\
 	NPLOGV(_T("Detected internal termination signal"));				\
 	continue;
 
-#define __GEN_ASYNCERRROR_HANDLE												\
-switch (ErrCode) {																\
-	case ERROR_MORE_DATA:														\
-		NPLOG(_T("ERROR: Excessive data size"));								\
-		break;																	\
-	case ERROR_BROKEN_PIPE:														\
-		NPLOGV(_T("ERROR: Pipe disconnected from the other end"));				\
-		break;																	\
-	default:																	\
-		NPERRLOG(ErrCode, _T("ERROR: Unexpected asynchronous error status"));	\
-}																				\
+// Asynchronous errors tend to repeat on every pipe instance at once
+#define NAMEDPIPE_ERRLOG_RATE	10
+
+#define __GEN_ASYNCERRROR_HANDLE																	\
+FLIGHTREC("NPipe Error", &_ServRec, ErrCode);														\
+switch (ErrCode) {																					\
+	case ERROR_MORE_DATA:																			\
+		MLOG_THROTTLED(LOGMODULE_NPIPE, TLogLevel::Normal, RATE_LIMITED(NAMEDPIPE_ERRLOG_RATE),		\
+					   NPLOG(_T("ERROR: Excessive data size")));									\
+		break;																						\
+	case ERROR_BROKEN_PIPE:																			\
+		MLOG_THROTTLED(LOGMODULE_NPIPE, TLogLevel::Verbose, RATE_LIMITED(NAMEDPIPE_ERRLOG_RATE),	\
+					   NPLOGV(_T("ERROR: Pipe disconnected from the other end")));					\
+		break;																						\
+	default:																						\
+		LOG_THROTTLED(RATE_LIMITED(NAMEDPIPE_ERRLOG_RATE),											\
+					  NPERRLOG(ErrCode, _T("ERROR: Unexpected asynchronous error status")));		\
+}																									\
 WorkerThread.SignalTerminate();
 
 TFixedBuffer TNamedPipeServer::TServRunnable::Run(TWorkerThread &WorkerThread, TFixedBuffer &Arg) {
-	TString FullPath = TStringCast(NAMEDPIPE_PATHPFX << _ServRec->_Path);
+	TString FullPath = TStringFmt(NAMEDPIPE_PATHPFX << _ServRec->_Path);
 	NPLOGV(_T("Starting serving (%s)"), FullPath.c_str());
 
 	TEvent ConnectEvent(true);
@@ -294,7 +317,7 @@ TFixedBuffer TNamedPipeServer::TServRunnable::Run(TWorkerThread &WorkerThread, T
 					{
 						auto ClientIdx = _ClientCnt.Increment();
 						NPLOGV(_T("Client #%d connected"), ClientIdx);
-						TString ClientName = TStringCast(_ServRec->_Name << _T('#') << ClientIdx);
+						TString ClientName = TStringFmt(_ServRec->_Name << _T('#') << ClientIdx);
 						_ServRec->_OnConnect({
 							DEFAULT_NEW(TNamedPipeEndPoint, std::move(ClientName),
 								std::move(_Pipe), _ServRec->_BufferSize, _ServRec->_TermSignal),
@@ -341,6 +364,7 @@ bool TNamedPipeEndPoint::TServRunnable::__Handle_AsyncReadCompletion(TDynBuffer
 		__GEN_ASYNCERRROR_HANDLE;
 		return false;
 	}
+	FLIGHTREC("NPipe Read", &_ServRec, cbRead);
 	AsyncRead = { 0 };
 	ReadEvent.Reset();
 	InBuffer.SetSize(cbRead);
@@ -351,6 +375,8 @@ bool TNamedPipeEndPoint::TServRunnable::__Handle_AsyncReadCompletion(TDynBuffer
 bool TNamedPipeEndPoint::TServRunnable::__Handle_AsyncWriteInitiate(TDynBuffer &OutBuffer, OVERLAPPED &AsyncWrite, THandle &WriteSignalHandle, TWorkerThread & WorkerThread)
 {
 	AsyncWrite.hEvent = *WriteSignalHandle;
+	_WriteStart = TMonotonicStamp::Now();
+	FLIGHTREC("NPipe Write", &_ServRec, OutBuffer.GetSize());
 	if (!WriteFile(*_ServRec->_Pipe, &OutBuffer, (DWORD)OutBuffer.GetSize(), NULL, &AsyncWrite)) {
 		DWORD ErrCode = GetLastError();
 		if (ErrCode != ERROR_IO_PENDING) {
@@ -372,9 +398,11 @@ bool TNamedPipeEndPoint::TServRunnable::__Handle_AsyncWriteCompletion(TDynBuffer
 		__GEN_ASYNCERRROR_HANDLE;
 		return false;
 	}
+	FLIGHTREC("NPipe Written", &_ServRec, cbWrite);
 	if (cbWrite != OutBuffer.GetSize()) {
 		NPLOGV(_T("WARNING: Unexpected written data size (%d, expect %d)"), cbWrite, OutBuffer.GetSize());
 	}
+	_ServRec->_SendLatency.Record(TMonotonicStamp::Now().Since(_WriteStart));
 	OutBuffer.Deallocate();
 	AsyncWrite = { 0 };
 	WriteEvent.Reset();
@@ -485,10 +513,10 @@ MRLocalCommServer INamedPipeServer::Create(TString const &xPath, DWORD BufferSiz
 }
 
 MRLocalCommEndPoint INamedPipeClient::Connect(TString const &xPath, DWORD BufferSize, THandleWaitable &TermSignal) {
-	TString FullPath = TStringCast(NAMEDPIPE_PATHPFX << xPath);
+	TString FullPath = TStringFmt(NAMEDPIPE_PATHPFX << xPath);
 	LOGVV(_T("Connecting to %s"), FullPath.c_str());
 
-	TString ClientName = TStringCast(NAMEDPIPE_CLIENT_NAMEPFX << _T('<') << xPath << _T('>'));
+	TString ClientName = TStringFmt(NAMEDPIPE_CLIENT_NAMEPFX << _T('<') << xPath << _T('>'));
 	THandle PipeHandle(
 		[&] {
 			HANDLE Ret = CreateFile(FullPath.c_str(), GENERIC_READ | GENERIC_WRITE,
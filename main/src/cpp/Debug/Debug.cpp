@@ -54,6 +54,11 @@ PCTCHAR __RelPath(PCTCHAR Path) {
 	return Path;
 }
 
+PCTCHAR __TimeStamp(void) {
+	static thread_local TTimeStampFormatter __IoFU;
+	return __IoFU.Format(TimeStamp::Now());
+}
+
 PCTCHAR __PTID(void) {
 	__declspec(thread) static TCHAR PTID[12]{ NullWChar };
 	if (PTID[0] == NullWChar)
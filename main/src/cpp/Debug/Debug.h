@@ -47,6 +47,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Misc/Types.h"
 #include "Misc/TString.h"
 #include "Misc/Timing.h"
+#include "Misc/Format.h"
 
 #ifdef WINDOWS
 #include <Windows.h>
@@ -110,11 +111,14 @@ TCHAR __ErrorMsg[len];								\
 
 #define STACK_ERRMSGFMT(fmt,...)	STACK_MSGFMT(ERRMSG_BUFLEN, fmt, __VA_ARGS__)
 
-#define STR_MSGFMT(pstr,len,fmt,...) { 					\
-ENFORCE_TYPE(decltype(pstr), TString*);					\
-(pstr)->resize(len);									\
-BUFFMT((PTCHAR)(pstr)->data(), len, fmt, __VA_ARGS__);	\
-(pstr)->resize(__Len >= 0 ? __Len : 0);					\
+// Format on stack, so the string only allocates what the message needs
+// Note: len sizes a stack array, so it must be a compile-time constant
+#define STR_MSGFMT(pstr,len,fmt,...) {										\
+ENFORCE_TYPE(decltype(pstr), TString*);										\
+static_assert((len) > 0, "Buffer length must be a positive constant");		\
+TCHAR __MsgBuf[len];														\
+BUFFMT(&__MsgBuf[0], len, fmt, __VA_ARGS__);								\
+(pstr)->assign(__MsgBuf, __Len >= 0 ? (size_t)__Len : _tcslen(__MsgBuf));	\
 }
 
 #define STR_ERRMSGFMT(pstr,fmt,...)	STR_MSGFMT(pstr, ERRMSG_BUFLEN, fmt, __VA_ARGS__)
@@ -129,16 +133,10 @@ PCTCHAR __RelPath(PCTCHAR Path);
 #define __REL_FILE__	__RelPath(_T(__FILE__))
 
 //! Allocate buffer and print current source information
-#define SOURCEMARK														\
-TString __SrcMark;														\
-{																		\
-	PCTCHAR __RelFile = __REL_FILE__;									\
-	/* '(' + LineNum + ')' + \0 */										\
-	size_t __Size = _tcslen(__RelFile) + 10 + 1 + 1 + 1;				\
-	STR_MSGFMT(&__SrcMark, __Size, _T("%s(%d)"), __RelFile, __LINE__);	\
-}
+#define SOURCEMARK	TString __SrcMark = TStringFmt(__REL_FILE__ << _T('(') << __LINE__ << _T(')'));
 
-inline TString __TimeStamp(void) { return TimeStamp::Now().toString(); }
+//! Format the current time, valid until the next call on the same thread
+PCTCHAR __TimeStamp(void);
 
 PCTCHAR __PTID(void);
 
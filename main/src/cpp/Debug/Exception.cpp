@@ -170,33 +170,33 @@ TString SEHException::STR_ExceptCode(PEXCEPTION_RECORD ExcRecord) {
 				case 1: SUBTYPE = AccessOp_Write; break;
 				case 8: SUBTYPE = AccessOp_Execute; break;
 			}
-			return TStringCast(_T("ACCESS VIOLATION, ") << SUBTYPE << _T(" OF ADDRESS ")
-							   << (PVOID)ExcRecord->ExceptionInformation[1]);
+			return TStringFmt(_T("ACCESS VIOLATION, ") << SUBTYPE << _T(" OF ADDRESS ")
+							  << (PVOID)ExcRecord->ExceptionInformation[1]);
 		}
 		case EXCEPTION_ARRAY_BOUNDS_EXCEEDED:
-			return TStringCast(_T("ARRAY BOUND EXCEEDED"));
+			return _T("ARRAY BOUND EXCEEDED");
 		case EXCEPTION_BREAKPOINT:
-			return TStringCast(_T("BREAKPOINT"));
+			return _T("BREAKPOINT");
 		case EXCEPTION_DATATYPE_MISALIGNMENT:
-			return TStringCast(_T("DATATYPE MISALIGNMENT"));
+			return _T("DATATYPE MISALIGNMENT");
 		case EXCEPTION_FLT_DENORMAL_OPERAND:
-			return TStringCast(_T("FLOATING-POINT OPERAND IS DENORMAL"));
+			return _T("FLOATING-POINT OPERAND IS DENORMAL");
 		case EXCEPTION_FLT_DIVIDE_BY_ZERO:
-			return TStringCast(_T("FLOATING-POINT DIVISION BY ZERO"));
+			return _T("FLOATING-POINT DIVISION BY ZERO");
 		case EXCEPTION_FLT_INEXACT_RESULT:
-			return TStringCast(_T("FLOATING-POINT RESULT IS INEXACT"));
+			return _T("FLOATING-POINT RESULT IS INEXACT");
 		case EXCEPTION_FLT_INVALID_OPERATION:
-			return TStringCast(_T("FLOATING-POINT INVALID OPERATION"));
+			return _T("FLOATING-POINT INVALID OPERATION");
 		case EXCEPTION_FLT_OVERFLOW:
-			return TStringCast(_T("FLOATING-POINT VALUE OVERFLOW"));
+			return _T("FLOATING-POINT VALUE OVERFLOW");
 		case EXCEPTION_FLT_STACK_CHECK:
-			return TStringCast(_T("FLOATING-POINT STACK ERROR"));
+			return _T("FLOATING-POINT STACK ERROR");
 		case EXCEPTION_FLT_UNDERFLOW:
-			return TStringCast(_T("FLOATING-POINT VALUE UNDERFLOW"));
+			return _T("FLOATING-POINT VALUE UNDERFLOW");
 		case EXCEPTION_GUARD_PAGE:
-			return TStringCast(_T("GUARD PAGE ACCESS"));
+			return _T("GUARD PAGE ACCESS");
 		case EXCEPTION_ILLEGAL_INSTRUCTION:
-			return TStringCast(_T("ILLEGAL INSTRUCTION"));
+			return _T("ILLEGAL INSTRUCTION");
 		case EXCEPTION_IN_PAGE_ERROR:
 		{
 			LPCTSTR SUBTYPE = AccessOp_Unknown;
@@ -205,28 +205,28 @@ TString SEHException::STR_ExceptCode(PEXCEPTION_RECORD ExcRecord) {
 				case 1: SUBTYPE = AccessOp_Write; break;
 				case 8: SUBTYPE = AccessOp_Execute; break;
 			}
-			return TStringCast(_T("PAGE-IN ERROR, ") << SUBTYPE << _T(" OF ADDRESS ")
-							   << (PVOID)ExcRecord->ExceptionInformation[1] << _T(" DUE TO ")
-							   << std::hex << ExcRecord->ExceptionInformation[2]);
+			return TStringFmt(_T("PAGE-IN ERROR, ") << SUBTYPE << _T(" OF ADDRESS ")
+							  << (PVOID)ExcRecord->ExceptionInformation[1] << _T(" DUE TO ")
+							  << FmtHex(ExcRecord->ExceptionInformation[2], 0, false));
 		}
 		case EXCEPTION_INT_DIVIDE_BY_ZERO:
-			return TStringCast(_T("INTEGER DIVISION BY ZERO"));
+			return _T("INTEGER DIVISION BY ZERO");
 		case EXCEPTION_INT_OVERFLOW:
-			return TStringCast(_T("INTEGER VALUE OVERFLOW"));
+			return _T("INTEGER VALUE OVERFLOW");
 		case EXCEPTION_INVALID_DISPOSITION:
-			return TStringCast(_T("INVALID EXCEPTION DISPOSITION"));
+			return _T("INVALID EXCEPTION DISPOSITION");
 		case EXCEPTION_INVALID_HANDLE:
-			return TStringCast(_T("INVALID HANDLE"));
+			return _T("INVALID HANDLE");
 		case EXCEPTION_NONCONTINUABLE_EXCEPTION:
-			return TStringCast(_T("EXCEPTION IS NON-CONTINUABLE"));
+			return _T("EXCEPTION IS NON-CONTINUABLE");
 		case EXCEPTION_PRIV_INSTRUCTION:
-			return TStringCast(_T("PRIVILEGED INSTRUCTION"));
+			return _T("PRIVILEGED INSTRUCTION");
 		case EXCEPTION_SINGLE_STEP:
-			return TStringCast(_T("SINGLE STEP TRAP"));
+			return _T("SINGLE STEP TRAP");
 		case EXCEPTION_STACK_OVERFLOW:
-			return TStringCast(_T("STACK OVERFLOW"));
+			return _T("STACK OVERFLOW");
 		default:
-			return TStringCast(std::hex << ExcRecord->ExceptionCode << _T('(') << ExcRecord->ExceptionFlags << _T(')'));
+			return TStringFmt(FmtHex(ExcRecord->ExceptionCode, 0, false) << _T('(') << FmtHex(ExcRecord->ExceptionFlags, 0, false) << _T(')'));
 	}
 }
 
@@ -61,7 +61,7 @@ protected:
 	TString mutable rWhy;
 
 	template<typename... Params>
-	static TString PopulateReason(PCTCHAR ReasonFmt, Params&&... xParams) {
+	static TString PopulateReason(_Printf_format_string_ PCTCHAR ReasonFmt, Params&&... xParams) {
 		TString Ret;
 		if (ReasonFmt) STR_ERRMSGFMT(&Ret, ReasonFmt, std::forward<Params>(xParams)...);
 		return Ret;
@@ -71,13 +71,15 @@ public:
 	TString const Source;
 	TString const Reason;
 
+	// Reason formats are checked against their arguments by code analysis (/analyze)
+
 	template<typename... Params>
-	Exception(TString const &xSource, PCTCHAR ReasonFmt, Params&&... xParams) :
+	Exception(TString const &xSource, _Printf_format_string_ PCTCHAR ReasonFmt, Params&&... xParams) :
 		Exception(TString(xSource), ReasonFmt, std::forward<Params>(xParams)...) {
 	}
 
 	template<typename... Params>
-	Exception(TString &&xSource, PCTCHAR ReasonFmt, Params&&... xParams) :
+	Exception(TString &&xSource, _Printf_format_string_ PCTCHAR ReasonFmt, Params&&... xParams) :
 		Source(std::move(xSource)),
 		Reason(PopulateReason(ReasonFmt, std::forward<Params>(xParams)...)),
 		std::exception(STR_STD_EXCEPTION_WHAT, 0) {
@@ -0,0 +1,241 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// [Utilities] Crash-surviving flight recorder
+
+#include "FlightRecorder.h"
+
+#include "Exception.h"
+#include "SysError.h"
+
+#include "Memory/Resource.h"
+
+#include "Threading/SyncObjects.h"
+
+#include <algorithm>
+#include <vector>
+
+#ifdef WINDOWS
+
+#include <share.h>
+
+#define FLIGHTREC_MAGIC		0x52465A57	// "ZWFR"
+#define FLIGHTREC_VERSION	1
+
+struct alignas(64) TFlightHeader {
+	UINT32 Magic;
+	UINT16 Version;
+	UINT16 CharSize;
+	UINT32 ProcessID;
+	UINT32 Slots;
+	UINT32 Entries;
+	UINT32 Sites;
+	LONG volatile SiteCount;
+	LONG volatile Dropped;	// Threads without a slot
+	INT64 Frequency;
+	FILETIME StartTime;
+	INT64 StartStamp;
+};
+
+typedef TCHAR TFlightSiteName[FLIGHTREC_NAMELEN];
+
+bool volatile __FlightActive = false;
+thread_local TFlightSlot *__FlightSlot = nullptr;
+
+struct TFlightRecorder {
+	TFlightHeader *Header = nullptr;
+	TFlightSiteName *Names = nullptr;
+	BYTE *Slots = nullptr;
+	size_t SlotSize = 0;
+};
+
+static TFlightRecorder __FlightRecorder;
+
+TSyncObj<TFlightRecorder*>& FLIGHTRECORDER(void) {
+	static TSyncObj<TFlightRecorder*> __IoFU(nullptr);
+	return __IoFU;
+}
+
+// Releases the slot when the owner thread exits
+class TFlightSlotRef {
+public:
+	bool Attempted = false;
+
+	~TFlightSlotRef(void) {
+		if (__FlightSlot) {
+			InterlockedExchange(&__FlightSlot->Owner, 0);
+			__FlightSlot = nullptr;
+		}
+	}
+};
+
+static thread_local TFlightSlotRef __FlightSlotRef;
+
+TFlightSlot* __FlightAttach(void) {
+	// Only try once per thread, so threads without a slot stay cheap
+	if (__FlightSlotRef.Attempted) return nullptr;
+	__FlightSlotRef.Attempted = true;
+
+	LONG ThreadID = (LONG)GetCurrentThreadId();
+	for (UINT32 i = 0; i < __FlightRecorder.Header->Slots; i++) {
+		auto Slot = (TFlightSlot*)(__FlightRecorder.Slots + i * __FlightRecorder.SlotSize);
+		if (InterlockedCompareExchange(&Slot->Owner, ThreadID, 0) == 0) {
+			return __FlightSlot = Slot;
+		}
+	}
+	InterlockedIncrement(&__FlightRecorder.Header->Dropped);
+	return nullptr;
+}
+
+UINT32 __FlightRegister(TFlightSite &Site) {
+	// Stop counting once the names are exhausted, so the count never runs past them (or wraps)
+	LONG Count = __FlightRecorder.Header->SiteCount;
+	LONG ID;
+	do {
+		// Exhausted sites stay unregistered, and are not recorded
+		if ((UINT32)Count >= __FlightRecorder.Header->Sites) return 0;
+		ID = Count + 1;
+	} while ((Count = InterlockedCompareExchange(&__FlightRecorder.Header->SiteCount, ID, Count)) != ID - 1);
+	_tcsncpy_s(__FlightRecorder.Names[ID - 1], Site.Name, _TRUNCATE);
+
+	// A concurrent registration may win, leaving a harmless duplicate name
+	UINT32 Expected = 0;
+	if (!Site.ID.compare_exchange_strong(Expected, (UINT32)ID)) return Expected;
+	return (UINT32)ID;
+}
+
+void STARTFLIGHTRECORDER(TString const &Path, size_t Slots, size_t Entries) {
+	if (!Slots || Entries < 2 || (Entries & (Entries - 1)))
+		FAIL(_T("Invalid flight recorder geometry (%Iu slots, %Iu entries)"), Slots, Entries);
+
+	auto Recorder(FLIGHTRECORDER().Pickup());
+	if (*Recorder) FAIL(_T("Flight recorder already started"));
+
+	// Keep the previous recording, which may hold the last moments before a crash
+	MoveFileEx(Path.c_str(), (Path + _T(".prev")).c_str(), MOVEFILE_REPLACE_EXISTING);
+
+	size_t SlotSize = sizeof(TFlightSlot) + Entries * sizeof(TFlightEntry);
+	UINT64 Size = sizeof(TFlightHeader) + FLIGHTREC_SITES * sizeof(TFlightSiteName) + Slots * SlotSize;
+	HANDLE File = CreateFile(Path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+							 CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (File == INVALID_HANDLE_VALUE) SYSFAIL(_T("Unable to create flight recorder file '%s'"), Path.c_str());
+	TInitResource<HANDLE> FileRes(File, [](HANDLE &X) { CloseHandle(X); });
+
+	// The mapping extends the file with zeros, and the view outlives both handles
+	HANDLE Mapping = CreateFileMapping(File, nullptr, PAGE_READWRITE, (DWORD)(Size >> 32), (DWORD)Size, nullptr);
+	if (!Mapping) SYSFAIL(_T("Unable to map flight recorder file '%s'"), Path.c_str());
+	TInitResource<HANDLE> MappingRes(Mapping, [](HANDLE &X) { CloseHandle(X); });
+	BYTE *View = (BYTE*)MapViewOfFile(Mapping, FILE_MAP_WRITE, 0, 0, 0);
+	if (!View) SYSFAIL(_T("Unable to map flight recorder file '%s'"), Path.c_str());
+
+	__FlightRecorder.Header = (TFlightHeader*)View;
+	__FlightRecorder.Names = (TFlightSiteName*)(View + sizeof(TFlightHeader));
+	__FlightRecorder.Slots = View + sizeof(TFlightHeader) + FLIGHTREC_SITES * sizeof(TFlightSiteName);
+	__FlightRecorder.SlotSize = SlotSize;
+	for (size_t i = 0; i < Slots; i++) {
+		auto Slot = (TFlightSlot*)(__FlightRecorder.Slots + i * SlotSize);
+		Slot->Mask = (UINT32)(Entries - 1);
+	}
+
+	TFlightHeader &Header = *__FlightRecorder.Header;
+	Header.Version = FLIGHTREC_VERSION;
+	Header.CharSize = sizeof(TCHAR);
+	Header.ProcessID = GetCurrentProcessId();
+	Header.Slots = (UINT32)Slots;
+	Header.Entries = (UINT32)Entries;
+	Header.Sites = FLIGHTREC_SITES;
+	LARGE_INTEGER Value;
+	QueryPerformanceFrequency(&Value);
+	Header.Frequency = Value.QuadPart;
+	GetSystemTimeAsFileTime(&Header.StartTime);
+	QueryPerformanceCounter(&Value);
+	Header.StartStamp = Value.QuadPart;
+	MemoryBarrier();
+	Header.Magic = FLIGHTREC_MAGIC;
+
+	*Recorder = &__FlightRecorder;
+	__FlightActive = true;
+}
+
+void FLUSHFLIGHTRECORDER(void) {
+	auto Recorder(FLIGHTRECORDER().Pickup());
+	if (*Recorder && !FlushViewOfFile((*Recorder)->Header, 0))
+		SYSFAIL(_T("Unable to flush flight recorder"));
+}
+
+size_t DUMPFLIGHTRECORDER(TString const &Path, FILE *Target) {
+	// The recording may still be mapped by a live process
+	FILE *Source = _tfsopen(Path.c_str(), _T("rb"), _SH_DENYNO);
+	if (!Source) FAIL(_T("Unable to open flight recorder file '%s' (runtime error %d)"), Path.c_str(), errno);
+	TInitResource<FILE*> SourceRes(Source, [](FILE *&X) { fclose(X); });
+
+	TFlightHeader Header;
+	if (fread(&Header, sizeof(Header), 1, Source) != 1 || Header.Magic != FLIGHTREC_MAGIC)
+		FAIL(_T("Not a flight recorder file"));
+	if (Header.Version != FLIGHTREC_VERSION || Header.CharSize != sizeof(TCHAR))
+		FAIL(_T("Unsupported flight recorder file (version %d, character size %d)"), Header.Version, Header.CharSize);
+
+	std::vector<TFlightSiteName> Names(Header.Sites);
+	std::vector<TFlightEntry> Entries;
+	if (fread(Names.data(), sizeof(TFlightSiteName), Names.size(), Source) != Names.size())
+		FAIL(_T("Truncated flight recorder file"));
+	UINT32 SiteCount = std::min((UINT32)Header.SiteCount, Header.Sites);
+
+	std::vector<TFlightEntry> Buffer(Header.Entries);
+	for (UINT32 i = 0; i < Header.Slots; i++) {
+		TFlightSlot Slot;
+		if (fread(&Slot, sizeof(Slot), 1, Source) != 1 ||
+			fread(Buffer.data(), sizeof(TFlightEntry), Buffer.size(), Source) != Buffer.size())
+			FAIL(_T("Truncated flight recorder file"));
+		// Skip unused and half-written entries
+		for (auto &Entry : Buffer) {
+			if (Entry.Stamp && Entry.SiteID && Entry.SiteID <= SiteCount) Entries.push_back(Entry);
+		}
+	}
+	std::sort(Entries.begin(), Entries.end(),
+			  [](TFlightEntry const &A, TFlightEntry const &B) { return A.Stamp < B.Stamp; });
+
+	SYSTEMTIME Start;
+	FileTimeToSystemTime(&Header.StartTime, &Start);
+	_ftprintf(Target, _T("Flight recorder of process %d, started %04d-%02d-%02d %02d:%02d:%02d.%03d UTC (%d threads dropped)") TNewLine,
+			  Header.ProcessID, Start.wYear, Start.wMonth, Start.wDay, Start.wHour, Start.wMinute, Start.wSecond,
+			  Start.wMilliseconds, Header.Dropped);
+	// Time relative to the last event, which is usually the point of interest
+	INT64 Last = Entries.empty() ? 0 : Entries.back().Stamp;
+	for (auto &Entry : Entries) {
+		double Offset = (double)(Entry.Stamp - Last) / Header.Frequency;
+		_ftprintf(Target, _T("%+.6f [%5d] %s 0x%llx 0x%llx") TNewLine, Offset, Entry.ThreadID,
+				  Names[Entry.SiteID - 1], Entry.Arg[0], Entry.Arg[1]);
+	}
+	fflush(Target);
+	return Entries.size();
+}
+
+#endif
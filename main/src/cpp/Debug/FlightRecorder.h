@@ -0,0 +1,133 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @addtogroup Utilities Basic Supporting Utilities
+ * @file
+ * @brief Crash-surviving flight recorder
+ **/
+
+#ifndef ZWUtils_FlightRecorder_H
+#define ZWUtils_FlightRecorder_H
+
+ // Project global control 
+#include "Misc/Global.h"
+
+#include "Misc/TString.h"
+
+#include <atomic>
+
+#ifdef WINDOWS
+#include <Windows.h>
+#endif
+
+#define FLIGHTREC_SLOTS		64		// Threads recorded concurrently
+#define FLIGHTREC_ENTRIES	4096	// Entries per thread (power of 2)
+#define FLIGHTREC_SITES		1024	// Distinct recording sites
+#define FLIGHTREC_NAMELEN	64		// Characters per site name
+
+//! A recording site, registered into the recorder on first use
+class TFlightSite {
+public:
+	PCTCHAR const Name;
+	std::atomic<UINT32> ID;
+
+	constexpr TFlightSite(PCTCHAR xName) : Name(xName), ID(0) {}
+};
+
+//! A recorded event (32 bytes)
+struct TFlightEntry {
+	INT64 volatile Stamp;	// Performance counter ticks, zero while being written
+	UINT32 SiteID;
+	UINT32 ThreadID;
+	UINT64 Arg[2];
+};
+
+//! A per-thread circular buffer, followed by its entries
+struct alignas(64) TFlightSlot {
+	LONG volatile Owner;	// Thread ID, zero if free
+	UINT32 Mask;
+	UINT64 Head;
+
+	TFlightEntry* Entries(void) {
+		return reinterpret_cast<TFlightEntry*>(this + 1);
+	}
+};
+
+extern bool volatile __FlightActive;
+extern thread_local TFlightSlot *__FlightSlot;
+
+TFlightSlot* __FlightAttach(void);
+UINT32 __FlightRegister(TFlightSite &Site);
+
+inline void __FLIGHTREC_DO(TFlightSite &Site, UINT64 Arg1, UINT64 Arg2) {
+	if (!__FlightActive) return;
+	TFlightSlot *Slot = __FlightSlot;
+	if (!Slot && !(Slot = __FlightAttach())) return;
+	UINT32 SiteID = Site.ID.load(std::memory_order_relaxed);
+	if (!SiteID && !(SiteID = __FlightRegister(Site))) return;
+
+	LARGE_INTEGER Stamp;
+	QueryPerformanceCounter(&Stamp);
+	// Only the owner thread writes to the slot, the stamp marks the entry complete
+	TFlightEntry &Entry = Slot->Entries()[Slot->Head++ & Slot->Mask];
+	Entry.Stamp = 0;
+	std::atomic_signal_fence(std::memory_order_release);
+	Entry.SiteID = SiteID;
+	Entry.ThreadID = (UINT32)Slot->Owner;
+	Entry.Arg[0] = Arg1;
+	Entry.Arg[1] = Arg2;
+	std::atomic_signal_fence(std::memory_order_release);
+	Entry.Stamp = Stamp.QuadPart;
+}
+
+/**
+ * Record an event with two numeric arguments into the flight recorder
+ * - Costs a counter read and a few stores, a no-op until the recorder is started
+ **/
+#define FLIGHTREC(name, a, b) {												\
+	static TFlightSite __FRSite(_T(name));									\
+	__FLIGHTREC_DO(__FRSite, (UINT64)(a), (UINT64)(b));						\
+}
+
+/**
+ * Start recording into a memory-mapped file, which survives a process crash
+ * - An existing recording at Path is kept as Path.prev
+ * - The recorder stays mapped until the process exits
+ **/
+void STARTFLIGHTRECORDER(TString const &Path, size_t Slots = FLIGHTREC_SLOTS, size_t Entries = FLIGHTREC_ENTRIES);
+
+//! Write the recording to disk, needed only to survive a system crash
+void FLUSHFLIGHTRECORDER(void);
+
+//! Decode a recording in time order, returns the number of entries
+size_t DUMPFLIGHTRECORDER(TString const &Path, FILE *Target);
+
+#endif
@@ -0,0 +1,361 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// [Utilities] Rotating log file target
+
+#include "LogFile.h"
+
+#include "SysError.h"
+
+#include "Memory/Resource.h"
+
+#include "Threading/SyncObjects.h"
+#include "Threading/WorkerThread.h"
+
+#include <algorithm>
+
+#ifdef WINDOWS
+
+#include <io.h>
+#include <fcntl.h>
+#include <compressapi.h>
+
+#pragma comment(lib, "Cabinet.lib")
+
+#define LOGFILE_CHECKINTERVAL	1000	// Milliseconds
+#define LOGSEGMENT_SUFFIX		_T(".xpress")
+#define LOGSEGMENT_MAGIC		0x5A4C575A	// "ZWLZ"
+#define LOGSEGMENT_VERSION		1
+#define LOGSEGMENT_BLOCKSIZE	0x100000	// 1MB
+
+#ifdef UNICODE
+#define LOGFILE_TEXTMODE	_O_U16TEXT
+#define LOGFILE_EMPTYSIZE	sizeof(WCHAR)
+#else
+#define LOGFILE_TEXTMODE	_O_TEXT
+#define LOGFILE_EMPTYSIZE	0
+#endif
+
+void __SETLOGTARGET(TString const &Name, FILE *xTarget, size_t BufferSize);
+
+struct TLogFile {
+	TString Name;
+	TString Path;
+	TLogRotation Rotation;
+	FILE *File;
+	TimeStamp Opened;
+};
+
+// A replaced file, which may still be in use by readers of an older log target list
+struct TLogFileRetired {
+	FILE *File;
+	__int64 Retired;
+	TString Segment;	// Empty if not a rotated segment
+	TLogRotation Rotation;
+	TString Path;
+};
+
+struct TLogFiles {
+	std::vector<TLogFile> Active;
+	std::vector<TLogFileRetired> Retired;
+};
+
+TSyncObj<TLogFiles>& LOGFILES(void) {
+	static TSyncObj<TLogFiles> __IoFU;
+	return __IoFU;
+}
+
+TSyncObj<MRWorkerThread>& LOGFILEROTATOR(void) {
+	static TSyncObj<MRWorkerThread> __IoFU;
+	return __IoFU;
+}
+
+static FILE* __OpenLogFile(TString const &Path) {
+	// Allow renaming while open, so the active segment can be rotated in place
+	HANDLE Handle = CreateFile(Path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+							   nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (Handle == INVALID_HANDLE_VALUE) SYSFAIL(_T("Unable to open log file '%s'"), Path.c_str());
+	LARGE_INTEGER Size;
+	if (!GetFileSizeEx(Handle, &Size)) Size.QuadPart = 0;
+
+	int FD = _open_osfhandle((intptr_t)Handle, _O_APPEND | LOGFILE_TEXTMODE);
+	if (FD == -1) {
+		CloseHandle(Handle);
+		FAIL(_T("Unable to associate log file '%s' (runtime error %d)"), Path.c_str(), errno);
+	}
+	FILE *Ret = _tfdopen(FD, _T("a"));
+	if (!Ret) {
+		_close(FD);
+		FAIL(_T("Unable to open log file '%s' stream (runtime error %d)"), Path.c_str(), errno);
+	}
+#ifdef UNICODE
+	// Same encoding as "ccs=UNICODE"
+	if (!Size.QuadPart) fputwc(0xFEFF, Ret);
+#endif
+	return Ret;
+}
+
+static long long __LogFileSize(FILE *File) {
+	LARGE_INTEGER Size;
+	if (!GetFileSizeEx((HANDLE)_get_osfhandle(_fileno(File)), &Size)) return 0;
+	return Size.QuadPart;
+}
+
+static TString __LogSegmentName(TString const &Path) {
+	SYSTEMTIME Now;
+	GetSystemTime(&Now);
+	TCHAR Suffix[32];
+	_stprintf_s(Suffix, _T(".%04d%02d%02d-%02d%02d%02d-%03d"), Now.wYear, Now.wMonth, Now.wDay,
+				Now.wHour, Now.wMinute, Now.wSecond, Now.wMilliseconds);
+	return Path + Suffix;
+}
+
+static void __RotateLogFile(TLogFiles &LogFiles, TLogFile &LogFile) {
+	TString Segment = __LogSegmentName(LogFile.Path);
+	if (!MoveFileEx(LogFile.Path.c_str(), Segment.c_str(), 0)) {
+		LOG_THROTTLED(RATE_LIMITED(1), SYSERRLOG(_T("Unable to rotate log file '%s'"), LogFile.Path.c_str()));
+		return;
+	}
+	FILE *File = __OpenLogFile(LogFile.Path);
+	__SETLOGTARGET(LogFile.Name, File, LOGFILE_BUFSIZE);
+	LogFiles.Retired.push_back({ LogFile.File, TRCUDomain::Retire(), std::move(Segment), LogFile.Rotation, LogFile.Path });
+	LogFile.File = File;
+	LogFile.Opened = TimeStamp::Now();
+}
+
+static void __CompressLogSegment(TString const &Source, TString const &Target) {
+	COMPRESSOR_HANDLE Compressor;
+	if (!CreateCompressor(COMPRESS_ALGORITHM_XPRESS | COMPRESS_RAW, nullptr, &Compressor))
+		SYSFAIL(_T("Unable to create compressor"));
+	TInitResource<COMPRESSOR_HANDLE> CompressorRes(Compressor, [](COMPRESSOR_HANDLE &X) { CloseCompressor(X); });
+
+	FILE *In, *Out;
+	if (_tfopen_s(&In, Source.c_str(), _T("rb")) != 0)
+		FAIL(_T("Unable to open log segment '%s'"), Source.c_str());
+	TInitResource<FILE*> InRes(In, [](FILE *&X) { fclose(X); });
+	if (_tfopen_s(&Out, Target.c_str(), _T("wb")) != 0)
+		FAIL(_T("Unable to create compressed log segment '%s'"), Target.c_str());
+	TInitResource<FILE*> OutRes(Out, [](FILE *&X) { fclose(X); });
+
+	UINT32 Header[2] = { LOGSEGMENT_MAGIC, LOGSEGMENT_VERSION };
+	fwrite(Header, sizeof(Header), 1, Out);
+	std::vector<BYTE> Raw(LOGSEGMENT_BLOCKSIZE);
+	std::vector<BYTE> Packed(LOGSEGMENT_BLOCKSIZE);
+	while (size_t RawSize = fread(Raw.data(), 1, Raw.size(), In)) {
+		SIZE_T PackedSize;
+		// Incompressible blocks are stored as-is
+		if (!Compress(Compressor, Raw.data(), RawSize, Packed.data(), Packed.size(), &PackedSize) || PackedSize >= RawSize) {
+			PackedSize = RawSize;
+			memcpy(Packed.data(), Raw.data(), RawSize);
+		}
+		UINT32 Block[2] = { (UINT32)RawSize, (UINT32)PackedSize };
+		fwrite(Block, sizeof(Block), 1, Out);
+		fwrite(Packed.data(), 1, PackedSize, Out);
+	}
+	if (ferror(In) || ferror(Out)) FAIL(_T("Unable to compress log segment '%s'"), Source.c_str());
+}
+
+void DECOMPRESSLOGSEGMENT(TString const &Source, TString const &Target) {
+	DECOMPRESSOR_HANDLE Decompressor;
+	if (!CreateDecompressor(COMPRESS_ALGORITHM_XPRESS | COMPRESS_RAW, nullptr, &Decompressor))
+		SYSFAIL(_T("Unable to create decompressor"));
+	TInitResource<DECOMPRESSOR_HANDLE> DecompressorRes(Decompressor, [](DECOMPRESSOR_HANDLE &X) { CloseDecompressor(X); });
+
+	FILE *In, *Out;
+	if (_tfopen_s(&In, Source.c_str(), _T("rb")) != 0)
+		FAIL(_T("Unable to open compressed log segment '%s'"), Source.c_str());
+	TInitResource<FILE*> InRes(In, [](FILE *&X) { fclose(X); });
+	UINT32 Header[2];
+	if (fread(Header, sizeof(Header), 1, In) != 1 || Header[0] != LOGSEGMENT_MAGIC)
+		FAIL(_T("Not a compressed log segment '%s'"), Source.c_str());
+	if (Header[1] != LOGSEGMENT_VERSION)
+		FAIL(_T("Unsupported compressed log segment version %d"), Header[1]);
+	if (_tfopen_s(&Out, Target.c_str(), _T("wb")) != 0)
+		FAIL(_T("Unable to create log segment '%s'"), Target.c_str());
+	TInitResource<FILE*> OutRes(Out, [](FILE *&X) { fclose(X); });
+
+	std::vector<BYTE> Raw;
+	std::vector<BYTE> Packed;
+	UINT32 Block[2];
+	while (fread(Block, sizeof(Block), 1, In) == 1) {
+		if (Block[0] > LOGSEGMENT_BLOCKSIZE || Block[1] > Block[0])
+			FAIL(_T("Malformed compressed log segment '%s'"), Source.c_str());
+		Packed.resize(Block[1]);
+		if (fread(Packed.data(), 1, Block[1], In) != Block[1])
+			FAIL(_T("Truncated compressed log segment '%s'"), Source.c_str());
+		if (Block[1] == Block[0]) {
+			fwrite(Packed.data(), 1, Block[1], Out);
+			continue;
+		}
+		Raw.resize(Block[0]);
+		SIZE_T RawSize;
+		if (!Decompress(Decompressor, Packed.data(), Block[1], Raw.data(), Raw.size(), &RawSize) || RawSize != Block[0])
+			SYSFAIL(_T("Unable to decompress log segment '%s'"), Source.c_str());
+		fwrite(Raw.data(), 1, RawSize, Out);
+	}
+}
+
+// Check the file name is "<Base>.YYYYMMDD-HHMMSS-mmm", optionally followed by the compressed suffix
+static bool __IsLogSegmentName(TString const &Base, TCHAR const *Name) {
+	static TCHAR const Pattern[] = _T(".########-######-###");
+	size_t NameLen = _tcslen(Name);
+	size_t SegmentLen = Base.length() + _countof(Pattern) - 1;
+	if ((NameLen != SegmentLen) && (NameLen != SegmentLen + _countof(LOGSEGMENT_SUFFIX) - 1))
+		return false;
+	if (_tcsnicmp(Name, Base.c_str(), Base.length()) != 0)
+		return false;
+	for (size_t i = 0; Pattern[i]; i++) {
+		TCHAR X = Name[Base.length() + i];
+		if ((Pattern[i] == _T('#')) ? !_istdigit(X) : (X != Pattern[i]))
+			return false;
+	}
+	return (NameLen == SegmentLen) || (_tcsicmp(Name + SegmentLen, LOGSEGMENT_SUFFIX) == 0);
+}
+
+// Delete the oldest rotated segments beyond the retention count
+static void __PruneLogSegments(TString const &Path, unsigned int Retain, std::vector<TString> const &Pending) {
+	WIN32_FIND_DATA FindData;
+	HANDLE Find = FindFirstFile((Path + _T(".*")).c_str(), &FindData);
+	if (Find == INVALID_HANDLE_VALUE) return;
+	TInitResource<HANDLE> FindRes(Find, [](HANDLE &X) { FindClose(X); });
+
+	size_t BaseOfs = Path.find_last_of(_T("\\/")) + 1;
+	TString Dir = Path.substr(0, BaseOfs);
+	TString Base = Path.substr(BaseOfs);
+	std::vector<TString> Segments;
+	do {
+		// The wildcard also matches the active file and unrelated names, only take what rotation produced
+		if (!__IsLogSegmentName(Base, FindData.cFileName)) continue;
+		TString Segment = Dir + FindData.cFileName;
+		if (std::find(Pending.begin(), Pending.end(), Segment) == Pending.end())
+			Segments.emplace_back(std::move(Segment));
+	} while (FindNextFile(Find, &FindData));
+
+	// Segment names sort chronologically
+	if (Segments.size() <= Retain) return;
+	std::sort(Segments.begin(), Segments.end());
+	for (size_t i = 0; i < Segments.size() - Retain; i++) {
+		if (!DeleteFile(Segments[i].c_str()))
+			LOG_THROTTLED(RATE_LIMITED(1), SYSERRLOG(_T("Unable to delete log segment '%s'"), Segments[i].c_str()));
+	}
+}
+
+static void __ProcessLogFiles(void) {
+	std::vector<TLogFileRetired> Closed;
+	std::vector<TString> Pending;
+	{
+		auto LogFiles(LOGFILES().Pickup());
+		for (auto &LogFile : LogFiles->Active) {
+			long long Size = __LogFileSize(LogFile.File);
+			bool Expired = (TimeStamp::Now() - LogFile.Opened) >= LogFile.Rotation.MaxAge;
+			// Do not rotate out a segment that holds nothing beyond the BOM
+			if ((Size >= (long long)LogFile.Rotation.MaxSize) || (Expired && Size > (long long)LOGFILE_EMPTYSIZE)) {
+				try {
+					__RotateLogFile(*LogFiles, LogFile);
+				} catch (_ECR_ e) {
+					LOG_THROTTLED(RATE_LIMITED(1), LOG(_T("WARNING: Unable to rotate log file '%s' - %s"), LogFile.Path.c_str(), e.Why().c_str()));
+				}
+			}
+		}
+
+		__int64 Horizon = TRCUDomain::Horizon();
+		auto Iter = LogFiles->Retired.begin();
+		while (Iter != LogFiles->Retired.end()) {
+			if (Iter->Retired <= Horizon) {
+				fclose(Iter->File);
+				if (!Iter->Segment.empty()) Closed.push_back(std::move(*Iter));
+				Iter = LogFiles->Retired.erase(Iter);
+			} else {
+				if (!Iter->Segment.empty()) Pending.push_back(Iter->Segment);
+				Iter++;
+			}
+		}
+	}
+
+	// Compress without holding the registry, so adding and removing targets is not delayed
+	for (auto &Segment : Closed) {
+		if (Segment.Rotation.Compress) {
+			try {
+				__CompressLogSegment(Segment.Segment, Segment.Segment + LOGSEGMENT_SUFFIX);
+				DeleteFile(Segment.Segment.c_str());
+			} catch (_ECR_ e) {
+				LOG(_T("WARNING: Unable to compress log segment '%s' - %s"), Segment.Segment.c_str(), e.Why().c_str());
+				DeleteFile((Segment.Segment + LOGSEGMENT_SUFFIX).c_str());
+			}
+		}
+		__PruneLogSegments(Segment.Path, Segment.Rotation.Retain, Pending);
+	}
+}
+
+class TLogFileRotator : public TRunnable {
+	typedef TLogFileRotator _this;
+
+protected:
+	TEvent _Wakeup;
+	bool volatile _Stop = false;
+
+public:
+	TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &Arg) override {
+		while (!_Stop) {
+			_Wakeup.WaitFor(LOGFILE_CHECKINTERVAL);
+			__ProcessLogFiles();
+		}
+		return {};
+	}
+
+	void StopNotify(TWorkerThread &WorkerThread) override {
+		_Stop = true;
+		_Wakeup.Set();
+	}
+};
+
+void SETLOGFILETARGET(TString const &Name, TString const &Path, TLogRotation const &Rotation) {
+	{
+		auto Rotator(LOGFILEROTATOR().Pickup());
+		if (Rotator->Empty()) {
+			*Rotator = { TWorkerThread::Create(_T("LogFileRotator"),
+				{ DEFAULT_NEW(TLogFileRotator), CONSTRUCTION::HANDOFF }), CONSTRUCTION::HANDOFF };
+			(*Rotator)->Start();
+		}
+	}
+
+	auto LogFiles(LOGFILES().Pickup());
+	auto Iter = std::find_if(LogFiles->Active.begin(), LogFiles->Active.end(),
+							 [&](TLogFile const &LogFile) { return LogFile.Name == Name; });
+	FILE *File = Path.empty() ? nullptr : __OpenLogFile(Path);
+	__SETLOGTARGET(Name, File, LOGFILE_BUFSIZE);
+	if (Iter != LogFiles->Active.end()) {
+		LogFiles->Retired.push_back({ Iter->File, TRCUDomain::Retire(), TString(), Iter->Rotation, Iter->Path });
+		LogFiles->Active.erase(Iter);
+	}
+	if (File) LogFiles->Active.push_back({ Name, Path, Rotation, File, TimeStamp::Now() });
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @addtogroup Utilities Basic Supporting Utilities
+ * @file
+ * @brief Rotating log file target
+ **/
+
+#ifndef ZWUtils_LogFile_H
+#define ZWUtils_LogFile_H
+
+ // Project global control 
+#include "Misc/Global.h"
+
+#include "Misc/TString.h"
+#include "Misc/Timing.h"
+
+#include "Logging.h"
+
+#define LOGFILE_MAXSIZE		0x4000000	// 64MB per segment
+#define LOGFILE_MAXAGE		86400000	// Milliseconds (1 day)
+#define LOGFILE_RETAIN		10			// Rotated segments to keep
+#define LOGFILE_BUFSIZE		0x40000		// 256KB write buffer
+
+struct TLogRotation {
+	size_t MaxSize;
+	TimeSpan MaxAge;
+	unsigned int Retain;
+	bool Compress;
+
+	TLogRotation(size_t xMaxSize = LOGFILE_MAXSIZE, TimeSpan const &xMaxAge = TimeSpan(LOGFILE_MAXAGE),
+				 unsigned int xRetain = LOGFILE_RETAIN, bool xCompress = true) :
+		MaxSize(xMaxSize), MaxAge(xMaxAge), Retain(xRetain), Compress(xCompress) {}
+};
+
+/**
+ * Add a rotating file log target, or remove it with an empty path
+ * - Writes go through a large buffer, pair with STARTASYNCLOG to keep disk I/O off the logging threads
+ * - The active segment is always at Path, rotated segments are renamed to Path.<YYYYMMDD-HHMMSS-mmm>
+ * - Rotation, compression and retention all happen on a background thread
+ * - Rotated segments are compressed with XPRESS (restore with DECOMPRESSLOGSEGMENT)
+ **/
+void SETLOGFILETARGET(TString const &Name, TString const &Path, TLogRotation const &Rotation = TLogRotation());
+
+//! Restore a compressed log segment
+void DECOMPRESSLOGSEGMENT(TString const &Source, TString const &Target);
+
+#endif
@@ -35,6 +35,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Memory/Resource.h"
 
 #include "Threading/SyncObjects.h"
+#include "Threading/WorkerThread.h"
 
 #ifdef WINDOWS
 #include <Windows.h>
@@ -44,13 +45,109 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 TString const LOGTARGET_CONSOLE(_T("Console"));
 
-typedef std::vector<std::pair<TString, FILE*>> TLogTargets;
+struct TLogTarget {
+	TString Name;
+	FILE *File;
+	TLogLevel Level;
 
-TSyncObj<TLogTargets>& LOGTARGETS(void) {
-	static TSyncObj<TLogTargets> __IoFU(TLogTargets({ {LOGTARGET_CONSOLE, stderr} }));
+	TLogTarget(TString const &xName, FILE *xFile, TLogLevel xLevel = TLogLevel::VeryVerbose) :
+		Name(xName), File(xFile), Level(xLevel) {}
+
+	bool Accepts(TString const *Target, TLogLevel xLevel) const {
+		if (xLevel > Level) return false;
+		return Target ? Name == *Target : Name.at(0) != _T('.');
+	}
+};
+
+typedef std::vector<TLogTarget> TLogTargets;
+
+TRCUObj<TLogTargets>& LOGTARGETS(void) {
+	static TRCUObj<TLogTargets> __IoFU(TLogTargets({ {LOGTARGET_CONSOLE, stderr} }));
 	return __IoFU;
 }
 
+// --- Log modules
+
+struct TLogModules {
+	std::vector<TLogModule*> Modules;
+	TLogLevel Level = LOGLEVEL_DEFAULT;
+};
+
+TSyncObj<TLogModules>& LOGMODULES(void) {
+	static TSyncObj<TLogModules> __IoFU;
+	return __IoFU;
+}
+
+LOGMODULE_DEFINE(LOGMODULE_DEFAULT, _T("Default"));
+
+TLogModule::TRegistration::TRegistration(TLogModule &Module) {
+	auto Modules(LOGMODULES().Pickup());
+	// The global level may have changed before this module got registered
+	if (!Module.Override) Module.SetLevel(Modules->Level);
+	Modules->Modules.push_back(&Module);
+}
+
+static TLogModule& __LogModule(TLogModules &Modules, TString const &Name) {
+	for (auto Module : Modules.Modules) {
+		if (Name.compare(Module->Name) == 0) return *Module;
+	}
+	FAIL(_T("Log module '%s' not found"), Name.c_str());
+}
+
+void SETLOGLEVEL(TLogLevel Level) {
+	auto Modules(LOGMODULES().Pickup());
+	Modules->Level = Level;
+	for (auto Module : Modules->Modules) {
+		if (!Module->Override) Module->SetLevel(Level);
+	}
+}
+
+void SETLOGLEVEL(TString const &Module, TLogLevel Level) {
+	auto Modules(LOGMODULES().Pickup());
+	TLogModule &LogModule = __LogModule(*Modules, Module);
+	LogModule.Override = true;
+	LogModule.SetLevel(Level);
+}
+
+void RESETLOGLEVEL(TString const &Module) {
+	auto Modules(LOGMODULES().Pickup());
+	TLogModule &LogModule = __LogModule(*Modules, Module);
+	LogModule.Override = false;
+	LogModule.SetLevel(Modules->Level);
+}
+
+TLogLevel GETLOGLEVEL(TString const &Module) {
+	auto Modules(LOGMODULES().Pickup());
+	return __LogModule(*Modules, Module).Level();
+}
+
+static PCTCHAR const __LogLevelNames[] = {
+	_T("Off"), _T("Normal"), _T("Verbose"), _T("VeryVerbose")
+};
+
+static TLogLevel __ParseLogLevel(TString const &Str) {
+	for (size_t i = 0; i < sizeof(__LogLevelNames) / sizeof(PCTCHAR); i++) {
+		if (_tcsicmp(Str.c_str(), __LogLevelNames[i]) == 0) return (TLogLevel)i;
+	}
+	if (Str.length() == 1 && Str[0] >= _T('0') && Str[0] <= _T('3')) return (TLogLevel)(Str[0] - _T('0'));
+	FAIL(_T("Unrecognized log level '%s'"), Str.c_str());
+}
+
+void SETLOGLEVELS(TString const &Spec) {
+	size_t Pos = 0;
+	while (Pos <= Spec.length()) {
+		size_t End = Spec.find(_T(','), Pos);
+		if (End == TString::npos) End = Spec.length();
+		TString Item = Spec.substr(Pos, End - Pos);
+		Pos = End + 1;
+		if (Item.empty()) continue;
+
+		size_t Sep = Item.find(_T('='));
+		if (Sep == TString::npos) SETLOGLEVEL(__ParseLogLevel(Item));
+		else SETLOGLEVEL(Item.substr(0, Sep), __ParseLogLevel(Item.substr(Sep + 1)));
+	}
+}
+
 #define MESSAGE_LOGTARGET_START	"Start of log"
 #define MESSAGE_LOGTARGET_END	"End of log"
 
@@ -63,44 +160,63 @@ void LOG_WRITE(FILE *Target, PCTCHAR Fmt, ...) {
 	__LOG_WRITE(Target, Fmt, params);
 }
 
-void SETLOGTARGET(TString const &Name, FILE *xTarget) {
-	auto LogTargets(LOGTARGETS().Pickup());
-	if (xTarget) {
-		if (setvbuf(xTarget, nullptr, _IOLBF, 4096) != 0) {
-			LOG(_T("WARNING: Unable to turn off file buffering for log target '%s'"), Name);
-		}
-		LOG_WRITE(xTarget, _T(MESSAGE_LOGTARGET_START)TNewLine);
+#define LOGTARGET_BUFSIZE	4096
 
-		for (auto entry : *LogTargets) {
-			if (entry.first.compare(Name) == 0) {
-				LOG_WRITE(entry.second, _T(MESSAGE_LOGTARGET_END)TNewLine);
-				entry.second = xTarget;
-				xTarget = nullptr;
-				break;
+void __SETLOGTARGET(TString const &Name, FILE *xTarget, size_t BufferSize) {
+	{
+		auto LogTargets(LOGTARGETS().Pickup());
+		if (xTarget) {
+			// Fully buffered, the asynchronous writer flushes after each batch
+			if (setvbuf(xTarget, nullptr, _IOFBF, BufferSize) != 0) {
+				LOG(_T("WARNING: Unable to set up file buffering for log target '%s'"), Name.c_str());
+			}
+			LOG_WRITE(xTarget, _T(MESSAGE_LOGTARGET_START)TNewLine);
+
+			for (auto &entry : *LogTargets) {
+				if (entry.Name.compare(Name) == 0) {
+					LOG_WRITE(entry.File, _T(MESSAGE_LOGTARGET_END)TNewLine);
+					entry.File = xTarget;
+					xTarget = nullptr;
+					break;
+				}
+			}
+			if (xTarget) LogTargets->emplace_back(Name, xTarget);
+		} else {
+			auto Iter = LogTargets->begin();
+			while (Iter != LogTargets->end()) {
+				if (Iter->Name.compare(Name) == 0) {
+					LOG_WRITE(Iter->File, _T(MESSAGE_LOGTARGET_END)TNewLine);
+					LogTargets->erase(Iter);
+					break;
+				} else Iter++;
 			}
-		}
-		if (xTarget) LogTargets->emplace_back(Name, xTarget);
-	} else {
-		auto Iter = LogTargets->begin();
-		while (Iter != LogTargets->end()) {
-			if (Iter->first.compare(Name) == 0) {
-				LOG_WRITE(Iter->second, _T(MESSAGE_LOGTARGET_END)TNewLine);
-				LogTargets->erase(Iter);
-				break;
-			} else Iter++;
 		}
 	}
+	// Readers may still write to the replaced target, wait for them before the caller closes it
+	TRCUDomain::Synchronize();
+}
+
+void SETLOGTARGET(TString const &Name, FILE *xTarget) {
+	__SETLOGTARGET(Name, xTarget, LOGTARGET_BUFSIZE);
 }
 
 FILE * GETLOGTARGET(TString const &Name) {
+	auto LogTargets(LOGTARGETS().Read());
+	for (auto &entry : *LogTargets) {
+		if (entry.Name.compare(Name) == 0) return entry.File;
+	}
+	return nullptr;
+}
+
+void SETLOGTARGETLEVEL(TString const &Name, TLogLevel Level) {
 	auto LogTargets(LOGTARGETS().Pickup());
-	auto Iter = LogTargets->begin();
-	while (Iter != LogTargets->end()) {
-		if (Iter->first.compare(Name) == 0) {
-			return Iter->second;
+	for (auto &entry : *LogTargets) {
+		if (entry.Name.compare(Name) == 0) {
+			entry.Level = Level;
+			return;
 		}
 	}
-	return nullptr;
+	FAIL(_T("Log target '%s' not found"), Name.c_str());
 }
 
 #ifdef WINDOWS
@@ -117,16 +233,22 @@ void __LocaleInit(void) {
 	}
 }
 
-void __LOG_DO(TString const* Target, PCTCHAR Fmt, ...) {
+bool __ASYNCLOG_DO(TString const* Target, TLogLevel Level, PCTCHAR Fmt, va_list params);
+extern bool volatile __AsyncLogActive;
+extern thread_local bool __AsyncLogWriter;
+
+void __LOG_DO(TString const* Target, TLogLevel Level, PCTCHAR Fmt, ...) {
 	va_list params;
 	va_start(params, Fmt);
 	TInitResource<va_list> Params(params, [](va_list &X) {va_end(X); });
-	auto LogTargets(LOGTARGETS().Pickup());
 	__LocaleInit();
+	if (__AsyncLogActive && !__AsyncLogWriter && __ASYNCLOG_DO(Target, Level, Fmt, params)) return;
+
+	auto LogTargets(LOGTARGETS().Read());
 	for (size_t i = 0; i < LogTargets->size(); i++) {
 		auto &entry = LogTargets->at(i);
-		if ((!Target && entry.first.at(0) != _T('.')) || (Target && entry.first == *Target)) {
-			__LOG_WRITE(entry.second, Fmt, params);
+		if (entry.Accepts(Target, Level)) {
+			__LOG_WRITE(entry.File, Fmt, params);
 		}
 	}
 }
@@ -146,4 +268,729 @@ void __LOG_WRITE(FILE *Target, PCTCHAR Fmt, va_list params) {
 	DEBUG_DO(fflush(Target));
 }
 
+// --- Throttled logging
+
+#define LOGTHROTTLE_WINDOW	1000	// Milliseconds
+
+bool TLogThrottle::EveryN(long long N, long long &Suppressed) {
+	if (N <= 1) return true;
+	long long Count = _Count.fetch_add(1, std::memory_order_relaxed);
+	if (Count % N) return false;
+	Suppressed = Count ? N - 1 : 0;
+	return true;
+}
+
+bool TLogThrottle::FirstN(long long N, long long &Suppressed) {
+	long long Count = _Count.fetch_add(1, std::memory_order_relaxed);
+	if (Count < N) return true;
+	// Report after 1, 2, 4, 8, ... suppressed messages
+	long long Dropped = Count - N + 1;
+	if (!(Dropped & (Dropped - 1))) Suppressed = Dropped - Dropped / 2;
+	return false;
+}
+
+bool TLogThrottle::RateLimited(long long PerSecond, long long &Suppressed) {
+	long long Now = (long long)GetTickCount64();
+	long long Window = _Window.load(std::memory_order_relaxed);
+	// Only one thread opens a new window
+	if (Now - Window >= LOGTHROTTLE_WINDOW && _Window.compare_exchange_strong(Window, Now, std::memory_order_relaxed))
+		_WindowCount.store(0, std::memory_order_relaxed);
+	if (_WindowCount.fetch_add(1, std::memory_order_relaxed) < PerSecond) {
+		Suppressed = _Suppressed.exchange(0, std::memory_order_relaxed);
+		return true;
+	}
+	_Suppressed.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+bool TLogThrottle::Sampled(double Probability, long long &Suppressed) {
+	// Xorshift, per thread so sampling needs no shared state
+	static thread_local UINT64 __Seed = 0;
+	if (!__Seed) __Seed = (GetTickCount64() << 16 ^ (UINT64)(UINT_PTR)&__Seed ^ GetCurrentThreadId()) | 1;
+	__Seed ^= __Seed << 13;
+	__Seed ^= __Seed >> 7;
+	__Seed ^= __Seed << 17;
+	if ((__Seed >> 11) * (1.0 / (1ULL << 53)) < Probability) {
+		Suppressed = _Suppressed.exchange(0, std::memory_order_relaxed);
+		return true;
+	}
+	_Suppressed.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+// --- Asynchronous logging
+
+#define ASYNCLOG_RINGMIN			0x1000
+#define ASYNCLOG_DEFAULTTARGET		((UINT32)-1)
+#define ASYNCLOG_DEFERRED			((UINT32)-2)
+#define ASYNCLOG_CRASHFLUSH_WAIT	100
+
+struct TAsyncLogRecord {
+	UINT32 Size;		// Bytes, including this header and alignment padding
+	UINT32 TargetLen;	// Characters of target name following the header
+	UINT32 TextLen;		// Characters of message text following the target name (bytes for deferred records)
+	TLogLevel Level;
+};
+
+// Single producer (the owner thread), single consumer (whoever holds the ring registry) byte ring
+class TAsyncLogRing {
+	typedef TAsyncLogRing _this;
+
+protected:
+	std::vector<BYTE> _Buffer;
+
+public:
+	size_t const Mask;
+	DWORD const ThreadID;
+	size_t volatile Head = 0;
+	size_t volatile Tail = 0;
+	LONG volatile Dropped = 0;
+	bool volatile Orphaned = false;
+	// Set by the owner thread while it puts a record, so STOPASYNCLOG can wait for puts that raced it
+	LONG volatile Putting = 0;
+
+	TAsyncLogRing(size_t Size) : _Buffer(Size), Mask(Size - 1), ThreadID(GetCurrentThreadId()) {}
+
+	size_t Free(void) const {
+		return Mask + 1 - (Head - Tail);
+	}
+
+	void Put(size_t Pos, void const *Data, size_t Len) {
+		size_t Offset = Pos & Mask;
+		size_t Part = std::min(Len, Mask + 1 - Offset);
+		memcpy(&_Buffer[Offset], Data, Part);
+		if (Part < Len) memcpy(&_Buffer[0], (BYTE const*)Data + Part, Len - Part);
+	}
+
+	void Get(size_t Pos, void *Data, size_t Len) const {
+		size_t Offset = Pos & Mask;
+		size_t Part = std::min(Len, Mask + 1 - Offset);
+		memcpy(Data, &_Buffer[Offset], Part);
+		if (Part < Len) memcpy((BYTE*)Data + Part, &_Buffer[0], Len - Part);
+	}
+};
+
+typedef std::vector<TAsyncLogRing*> TAsyncLogRings;
+
+// Holding the registry also makes the holder the sole consumer of all rings
+TSyncObj<TAsyncLogRings>& ASYNCLOGRINGS(void) {
+	static TSyncObj<TAsyncLogRings> __IoFU;
+	return __IoFU;
+}
+
+TSyncObj<MRWorkerThread>& ASYNCLOGWRITER(void) {
+	static TSyncObj<MRWorkerThread> __IoFU;
+	return __IoFU;
+}
+
+TEvent& ASYNCLOGWAKEUP(void) {
+	static TEvent __IoFU;
+	return __IoFU;
+}
+
+// Formatted batches, written out after the registries are released
+struct TAsyncLogOutput {
+	std::vector<TString> Batches;
+	std::vector<BYTE> DeferBatch;
+};
+
+// Holding the output serializes writers, so batches reach the targets in drain order
+TSyncObj<TAsyncLogOutput>& ASYNCLOGOUTPUT(void) {
+	static TSyncObj<TAsyncLogOutput> __IoFU;
+	return __IoFU;
+}
+
+#ifdef __ZWUTILS_SYNC_CONDITIONVAIRABLE
+
+// Producers blocked on a full ring wait for the writer to release space
+struct TAsyncLogSpace {
+	TCriticalSection Lock;
+	TConditionVariable Released;
+};
+
+TAsyncLogSpace& ASYNCLOGSPACE(void) {
+	static TAsyncLogSpace __IoFU;
+	return __IoFU;
+}
+
+#endif
+
+bool volatile __AsyncLogActive = false;
+static TLogOverflow volatile __AsyncLogOverflow = TLogOverflow::Count;
+static size_t volatile __AsyncLogRingSize = ASYNCLOG_RINGSIZE;
+
+// The writer thread logs synchronously, so it never blocks on its own ring
+thread_local bool __AsyncLogWriter = false;
+
+// Plain thread locals, still valid while other thread local objects are destructed
+static thread_local TAsyncLogRing *__AsyncLogThreadRing = nullptr;
+static thread_local bool __AsyncLogThreadExited = false;
+
+class TAsyncLogRingRef {
+public:
+	void Adopt(TAsyncLogRing *Ring) {
+		__AsyncLogThreadRing = Ring;
+	}
+
+	~TAsyncLogRingRef(void) {
+		// The writer frees the ring once it is drained
+		if (__AsyncLogThreadRing) __AsyncLogThreadRing->Orphaned = true;
+		__AsyncLogThreadRing = nullptr;
+		// A ring created after this point would never be orphaned, log synchronously instead
+		__AsyncLogThreadExited = true;
+	}
+};
+
+static thread_local TAsyncLogRingRef __AsyncLogRing;
+
+// Wake producers blocked on a full ring, after ring tails (or the active flag) are updated
+static void __AsyncLogReleased(void) {
+#ifdef __ZWUTILS_SYNC_CONDITIONVAIRABLE
+	auto &Space = ASYNCLOGSPACE();
+	// A producer holding the lock has either not checked its ring yet, or is already waiting
+	Space.Lock.Enter();
+	Space.Lock.Leave();
+	Space.Released.Signal(true);
+#endif
+}
+
+// Copy a record into the calling thread's ring, returns false if it should be written synchronously
+static bool __AsyncLogPut(TAsyncLogRecord Record, void const *Target, size_t TargetSize,
+						  void const *Data, size_t DataSize) {
+	TAsyncLogRing *Ring = __AsyncLogThreadRing;
+	if (!Ring) {
+		if (__AsyncLogThreadExited) return false;
+		Ring = DEFAULT_NEW(TAsyncLogRing, __AsyncLogRingSize);
+		__AsyncLogRing.Adopt(Ring);
+		ASYNCLOGRINGS().Pickup()->push_back(Ring);
+	}
+
+	// Interlocked exchange is a full barrier, pairs with the one in STOPASYNCLOG
+	InterlockedExchange(&Ring->Putting, 1);
+	TInitResource<TAsyncLogRing*> Putting(Ring, [](TAsyncLogRing* &X) { X->Putting = 0; });
+	if (!__AsyncLogActive) return false;
+
+	size_t Size = (sizeof(Record) + TargetSize + DataSize + 7) & ~(size_t)7;
+	// Oversized messages are written synchronously
+	if (Size > Ring->Mask + 1) return false;
+
+	while (Ring->Free() < Size) {
+		switch (__AsyncLogOverflow) {
+			case TLogOverflow::Block:
+				ASYNCLOGWAKEUP().Set();
+				if (!__AsyncLogActive) return false;
+#ifdef __ZWUTILS_SYNC_CONDITIONVAIRABLE
+				{
+					auto &Space = ASYNCLOGSPACE();
+					Space.Lock.Enter();
+					if (Ring->Free() < Size && __AsyncLogActive) Space.Released.WaitFor(Space.Lock);
+					Space.Lock.Leave();
+				}
+#else
+				Sleep(1);
+#endif
+				break;
+			case TLogOverflow::Count:
+				InterlockedIncrement(&Ring->Dropped);
+				// Fall through...
+			default:
+				return true;
+		}
+	}
+
+	size_t Head = Ring->Head;
+	Record.Size = (UINT32)Size;
+	Ring->Put(Head, &Record, sizeof(Record));
+	if (TargetSize) Ring->Put(Head + sizeof(Record), Target, TargetSize);
+	Ring->Put(Head + sizeof(Record) + TargetSize, Data, DataSize);
+	// Publish only after the content is in place
+	MemoryBarrier();
+	Ring->Head = Head + Size;
+
+	if (Ring->Free() < (Ring->Mask + 1) / 2) ASYNCLOGWAKEUP().Set();
+	return true;
+}
+
+bool __ASYNCLOG_DO(TString const* Target, TLogLevel Level, PCTCHAR Fmt, va_list params) {
+	static thread_local TString __Text;
+
+	int TextLen = _vsctprintf(Fmt, params);
+	if (TextLen < 0) return false;
+	__Text.resize(TextLen + 1);
+	_vstprintf_s(&__Text[0], TextLen + 1, Fmt, params);
+
+	TAsyncLogRecord Record = { 0, Target ? (UINT32)Target->length() : ASYNCLOG_DEFAULTTARGET, (UINT32)TextLen, Level };
+	return __AsyncLogPut(Record, Target ? Target->data() : nullptr, Target ? Record.TargetLen * sizeof(TCHAR) : 0,
+						 __Text.data(), TextLen * sizeof(TCHAR));
+}
+
+static void __AsyncLogAppend(TLogTargets const &Targets, TString const *Target, TLogLevel Level,
+							 TString const &Text, std::vector<TString> &Batches) {
+	for (size_t i = 0; i < Targets.size(); i++) {
+		auto &entry = Targets[i];
+		if (entry.Accepts(Target, Level)) {
+			Batches[i].append(Text);
+		}
+	}
+}
+
+// --- Deferred logging
+
+#define DEFERLOG_MAGIC		0x4C44575A	// "ZWDL"
+#define DEFERLOG_VERSION	1
+#define DEFERLOG_SLOT		sizeof(void*)
+
+struct TDeferLogFileHeader {
+	UINT32 Magic;
+	UINT16 Version;
+	UINT16 CharSize;
+	UINT32 ProcessID;
+};
+
+enum class TDeferLogEntry : UINT32 {
+	Site = 1,	// Followed by TDeferLogSiteEntry and format characters
+	Record,		// Followed by TLogDeferredHeader and captured arguments
+};
+
+struct TDeferLogEntryHeader {
+	UINT32 Type;
+	UINT32 Size;	// Bytes following this header
+};
+
+struct TDeferLogSiteEntry {
+	UINT32 ID;
+	UINT32 FmtLen;
+};
+
+typedef std::vector<TLogSite const*> TLogSites;
+
+TSyncObj<TLogSites>& DEFERLOGSITES(void) {
+	static TSyncObj<TLogSites> __IoFU;
+	return __IoFU;
+}
+
+TLogSite::TLogSite(PCTCHAR xFmt, TLogLevel xLevel) : Fmt(xFmt), Level(xLevel), ID([&] {
+	auto Sites(DEFERLOGSITES().Pickup());
+	Sites->push_back(this);
+	return (UINT32)Sites->size() - 1;
+}()) {}
+
+struct TDeferLogTarget {
+	FILE *File = nullptr;
+	std::vector<bool> Announced;
+	std::vector<BYTE> Batch;
+	TTimeStampFormatter Formatter;
+};
+
+TSyncObj<TDeferLogTarget>& DEFERLOGTARGET(void) {
+	static TSyncObj<TDeferLogTarget> __IoFU;
+	return __IoFU;
+}
+
+// Rebuild a vararg list from captured arguments, and format it
+static bool __DeferLogFormat(PCTCHAR Fmt, BYTE const *Args, size_t Size, TString &Text) {
+	std::vector<BYTE> Slots;
+	std::vector<BYTE> Strings;
+	std::vector<std::pair<size_t, size_t>> Patches;
+	auto PutSlot = [&](void const *Data, size_t Len) {
+		size_t Pos = Slots.size();
+		Slots.resize(Pos + ((Len + DEFERLOG_SLOT - 1) & ~(DEFERLOG_SLOT - 1)));
+		memcpy(&Slots[Pos], Data, Len);
+		return Pos;
+	};
+
+	BYTE const *End = Args + Size;
+	while (Args < End) {
+		TLogArg Kind = (TLogArg)*Args++;
+		size_t Left = End - Args;
+		switch (Kind) {
+			case TLogArg::Int32:
+				if (Left < sizeof(INT32)) return false;
+				PutSlot(Args, sizeof(INT32));
+				Args += sizeof(INT32);
+				break;
+			case TLogArg::Int64:
+			case TLogArg::Double:
+				if (Left < sizeof(INT64)) return false;
+				PutSlot(Args, sizeof(INT64));
+				Args += sizeof(INT64);
+				break;
+			case TLogArg::Pointer: {
+				if (Left < sizeof(UINT64)) return false;
+				UINT64 Value;
+				memcpy(&Value, Args, sizeof(Value));
+				PVOID Ptr = (PVOID)(UINT_PTR)Value;
+				PutSlot(&Ptr, sizeof(Ptr));
+				Args += sizeof(UINT64);
+			} break;
+			case TLogArg::AString:
+			case TLogArg::WString: {
+				size_t CharSize = Kind == TLogArg::AString ? sizeof(char) : sizeof(wchar_t);
+				UINT32 Len;
+				if (Left < sizeof(Len)) return false;
+				memcpy(&Len, Args, sizeof(Len));
+				Args += sizeof(Len);
+				PVOID Ptr = nullptr;
+				size_t Pos = PutSlot(&Ptr, sizeof(Ptr));
+				if (Len != DEFERLOG_NULLSTRING) {
+					if ((size_t)(End - Args) / CharSize < Len) return false;
+					// Zero-filled, so the strings are aligned and terminated
+					size_t Offset = (Strings.size() + sizeof(wchar_t) - 1) & ~(sizeof(wchar_t) - 1);
+					Strings.resize(Offset + (Len + 1) * CharSize);
+					memcpy(&Strings[Offset], Args, Len * CharSize);
+					Args += Len * CharSize;
+					// Strings may still move, so point to them afterwards
+					Patches.emplace_back(Pos, Offset);
+				}
+			} break;
+			default:
+				return false;
+		}
+	}
+	for (auto &Patch : Patches) {
+		PVOID Ptr = &Strings[Patch.second];
+		memcpy(&Slots[Patch.first], &Ptr, sizeof(Ptr));
+	}
+	Slots.resize(Slots.size() + DEFERLOG_SLOT);
+
+	va_list Params = (va_list)Slots.data();
+	int TextLen = _vsctprintf(Fmt, Params);
+	if (TextLen < 0) return false;
+	size_t Pos = Text.length();
+	Text.resize(Pos + TextLen + 1);
+	_vstprintf_s(&Text[Pos], TextLen + 1, Fmt, Params);
+	Text.resize(Pos + TextLen);
+	return true;
+}
+
+static void __DeferLogText(PCTCHAR Fmt, DWORD ProcessID, TLogDeferredHeader const &Header,
+						   BYTE const *Args, size_t Size, TTimeStampFormatter &Formatter, TString &Text) {
+	TCHAR Prefix[64];
+	_stprintf_s(Prefix, _T("[%5d:%-5d] %s | "), ProcessID, Header.ThreadID, Formatter.Format(TimeStamp(Header.Stamp)));
+	Text.append(Prefix);
+	if (!__DeferLogFormat(Fmt, Args, Size, Text))
+		Text.append(_T("<Malformed deferred log record>") TNewLine);
+}
+
+static void __DeferLogEmit(std::vector<BYTE> &Batch, TDeferLogEntry Type,
+						   void const *Head, size_t HeadSize, void const *Data, size_t DataSize) {
+	TDeferLogEntryHeader Entry = { (UINT32)Type, (UINT32)(HeadSize + DataSize) };
+	size_t Pos = Batch.size();
+	Batch.resize(Pos + sizeof(Entry) + HeadSize + DataSize);
+	memcpy(&Batch[Pos], &Entry, sizeof(Entry));
+	memcpy(&Batch[Pos + sizeof(Entry)], Head, HeadSize);
+	if (DataSize) memcpy(&Batch[Pos + sizeof(Entry) + HeadSize], Data, DataSize);
+}
+
+static void __DeferLogDrain(std::vector<BYTE> const &Payload, TLogSites const &Sites, TDeferLogTarget &DeferTarget,
+							TLogTargets const &Targets, std::vector<TString> &Batches) {
+	TLogDeferredHeader Header;
+	memcpy(&Header, Payload.data(), sizeof(Header));
+	TLogSite const *Site = Sites[Header.SiteID];
+	BYTE const *Args = Payload.data() + sizeof(Header);
+	size_t Size = Payload.size() - sizeof(Header);
+
+	if (DeferTarget.File) {
+		if (Header.SiteID >= DeferTarget.Announced.size()) DeferTarget.Announced.resize(Sites.size());
+		if (!DeferTarget.Announced[Header.SiteID]) {
+			TDeferLogSiteEntry SiteEntry = { Site->ID, (UINT32)_tcslen(Site->Fmt) };
+			__DeferLogEmit(DeferTarget.Batch, TDeferLogEntry::Site, &SiteEntry, sizeof(SiteEntry),
+						   Site->Fmt, SiteEntry.FmtLen * sizeof(TCHAR));
+			DeferTarget.Announced[Header.SiteID] = true;
+		}
+		__DeferLogEmit(DeferTarget.Batch, TDeferLogEntry::Record, &Header, sizeof(Header), Args, Size);
+	} else {
+		TString Text;
+		__DeferLogText(Site->Fmt, GetCurrentProcessId(), Header, Args, Size, DeferTarget.Formatter, Text);
+		__AsyncLogAppend(Targets, nullptr, Site->Level, Text, Batches);
+	}
+}
+
+static void __AsyncLogDrain(TAsyncLogRing &Ring, TLogTargets const &Targets, std::vector<TString> &Batches,
+							TLogSites const &Sites, TDeferLogTarget &DeferTarget) {
+	size_t Tail = Ring.Tail;
+	size_t Head = Ring.Head;
+	MemoryBarrier();
+
+	TString Target;
+	TString Text;
+	std::vector<BYTE> Payload;
+	while (Tail != Head) {
+		TAsyncLogRecord Record;
+		Ring.Get(Tail, &Record, sizeof(Record));
+		size_t Pos = Tail + sizeof(Record);
+		if (Record.TargetLen == ASYNCLOG_DEFERRED) {
+			Payload.resize(Record.TextLen);
+			Ring.Get(Pos, Payload.data(), Record.TextLen);
+			__DeferLogDrain(Payload, Sites, DeferTarget, Targets, Batches);
+		} else {
+			bool Default = Record.TargetLen == ASYNCLOG_DEFAULTTARGET;
+			if (!Default) {
+				Target.resize(Record.TargetLen);
+				Ring.Get(Pos, &Target[0], Record.TargetLen * sizeof(TCHAR));
+				Pos += Record.TargetLen * sizeof(TCHAR);
+			}
+			Text.resize(Record.TextLen);
+			Ring.Get(Pos, &Text[0], Record.TextLen * sizeof(TCHAR));
+			__AsyncLogAppend(Targets, Default ? nullptr : &Target, Record.Level, Text, Batches);
+		}
+		Tail += Record.Size;
+	}
+	// Release the space only after the content is copied out
+	MemoryBarrier();
+	Ring.Tail = Tail;
+
+	if (LONG Dropped = InterlockedExchange(&Ring.Dropped, 0)) {
+		__AsyncLogAppend(Targets, nullptr, TLogLevel::Normal, TStringFmt(_T("WARNING: Dropped ") << Dropped
+													  << _T(" log messages from thread ") << Ring.ThreadID << TNewLine), Batches);
+	}
+}
+
+static void __AsyncLogWrite(FILE *Target, TString const &Text, bool Crashed) {
+	if (Crashed) {
+		// The crashed thread may hold the stream lock
+		for (TCHAR Char : Text) _fputtc_nolock(Char, Target);
+		_fflush_nolock(Target);
+	} else {
+		_fputts(Text.c_str(), Target);
+		fflush(Target);
+	}
+}
+
+static void __AsyncLogWrite(FILE *Target, std::vector<BYTE> const &Data, bool Crashed) {
+	if (Crashed) {
+		_fwrite_nolock(Data.data(), 1, Data.size(), Target);
+		_fflush_nolock(Target);
+	} else {
+		fwrite(Data.data(), 1, Data.size(), Target);
+		fflush(Target);
+	}
+}
+
+// In a crash, waits for locks are bounded by the timeout, and streams are written without locking
+static bool __AsyncLogFlush(WAITTIME Timeout, bool Crashed = false) {
+	// Taken before the registries, so concurrent flushes write in the order they drained
+	auto Output(ASYNCLOGOUTPUT().Pickup(Timeout));
+	if (!Output) return false;
+
+	auto LogTargets(LOGTARGETS().TryRead(Timeout));
+	if (!LogTargets) return false;
+	std::vector<TString> &Batches = Output->Batches;
+	Batches.resize(LogTargets->size());
+	FILE *DeferFile;
+	{
+		// Only drain under the registries, threads registering their first ring or log site must not wait for I/O
+		auto Rings(ASYNCLOGRINGS().Pickup(Timeout));
+		if (!Rings) return false;
+		auto Sites(DEFERLOGSITES().Pickup(Timeout));
+		if (!Sites) return false;
+		auto DeferTarget(DEFERLOGTARGET().Pickup(Timeout));
+		if (!DeferTarget) return false;
+
+		auto Iter = Rings->begin();
+		while (Iter != Rings->end()) {
+			TAsyncLogRing *Ring = *Iter;
+			// Check before draining, so the last messages of an exited thread are not lost
+			bool Orphaned = Ring->Orphaned;
+			__AsyncLogDrain(*Ring, *LogTargets, Batches, *Sites, *DeferTarget);
+			if (Orphaned) {
+				DEFAULT_DESTROY(TAsyncLogRing, Ring);
+				Iter = Rings->erase(Iter);
+			} else Iter++;
+		}
+		DeferFile = DeferTarget->File;
+		Output->DeferBatch.swap(DeferTarget->Batch);
+	}
+	__AsyncLogReleased();
+
+	for (size_t i = 0; i < Batches.size(); i++) {
+		if (Batches[i].empty()) continue;
+		__AsyncLogWrite(LogTargets->at(i).File, Batches[i], Crashed);
+		Batches[i].clear();
+	}
+	if (!Output->DeferBatch.empty()) {
+		__AsyncLogWrite(DeferFile, Output->DeferBatch, Crashed);
+		Output->DeferBatch.clear();
+	}
+	return true;
+}
+
+class TAsyncLogWriter : public TRunnable {
+	typedef TAsyncLogWriter _this;
+
+protected:
+	bool volatile _Stop = false;
+	WAITTIME const _Interval;
+
+public:
+	TAsyncLogWriter(TimeSpan const &Interval) :
+		_Interval((WAITTIME)Interval.GetValue(TimeUnit::MSEC)) {}
+
+	TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &Arg) override {
+		__AsyncLogWriter = true;
+		__LocaleInit();
+		while (!_Stop) {
+			ASYNCLOGWAKEUP().WaitFor(_Interval);
+			__AsyncLogFlush(FOREVER);
+		}
+		return {};
+	}
+
+	void StopNotify(TWorkerThread &WorkerThread) override {
+		_Stop = true;
+		ASYNCLOGWAKEUP().Set();
+	}
+};
+
+static LPTOP_LEVEL_EXCEPTION_FILTER __AsyncLogPrevFilter = nullptr;
+
+static LONG WINAPI __AsyncLogCrashFilter(EXCEPTION_POINTERS *ExceptionInfo) {
+	// Do not wait on a registry held by a crashed thread
+	__AsyncLogFlush(ASYNCLOG_CRASHFLUSH_WAIT, true);
+	return __AsyncLogPrevFilter ? __AsyncLogPrevFilter(ExceptionInfo) : EXCEPTION_CONTINUE_SEARCH;
+}
+
+static void __AsyncLogExitFlush(void) {
+	__AsyncLogFlush(ASYNCLOG_CRASHFLUSH_WAIT);
+}
+
+static void __AsyncLogInstallHooks(void) {
+	static bool __IoFU = [] {
+		// Construct the statics first, so they outlive the exit handler
+		ASYNCLOGRINGS();
+		ASYNCLOGOUTPUT();
+#ifdef __ZWUTILS_SYNC_CONDITIONVAIRABLE
+		ASYNCLOGSPACE();
+#endif
+		DEFERLOGSITES();
+		DEFERLOGTARGET();
+		LOGTARGETS();
+		__AsyncLogPrevFilter = SetUnhandledExceptionFilter(&__AsyncLogCrashFilter);
+		atexit(&__AsyncLogExitFlush);
+		return true;
+	}();
+}
+
+void STARTASYNCLOG(TLogOverflow Overflow, size_t RingSize, TimeSpan const &FlushInterval) {
+	if (RingSize < ASYNCLOG_RINGMIN || (RingSize & (RingSize - 1)))
+		FAIL(_T("Ring size must be a power of 2, and at least %d (got %Iu)"), ASYNCLOG_RINGMIN, RingSize);
+
+	auto Writer(ASYNCLOGWRITER().Pickup());
+	if (!Writer->Empty()) FAIL(_T("Asynchronous logging already started"));
+	__AsyncLogInstallHooks();
+	__AsyncLogOverflow = Overflow;
+	__AsyncLogRingSize = RingSize;
+	*Writer = { TWorkerThread::Create(_T("AsyncLogWriter"),
+		{ DEFAULT_NEW(TAsyncLogWriter, FlushInterval), CONSTRUCTION::HANDOFF }), CONSTRUCTION::HANDOFF };
+	(*Writer)->Start();
+	__AsyncLogActive = true;
+}
+
+void STOPASYNCLOG(void) {
+	auto Writer(ASYNCLOGWRITER().Pickup());
+	if (Writer->Empty()) return;
+	__AsyncLogActive = false;
+	// Blocked producers fall back to synchronous logging
+	__AsyncLogReleased();
+	{
+		// Wait for puts that saw the active flag, so the final flush picks them up
+		MemoryBarrier();
+		auto Rings(ASYNCLOGRINGS().Pickup());
+		for (auto Ring : *Rings) {
+			while (Ring->Putting) SwitchToThread();
+		}
+	}
+	(*Writer)->SignalTerminate();
+	(*Writer)->WaitFor();
+	Writer->Clear();
+	__AsyncLogFlush(FOREVER);
+}
+
+void FLUSHASYNCLOG(void) {
+	__AsyncLogFlush(FOREVER);
+}
+
+BYTE* __DEFERLOG_BUFFER(size_t Size) {
+	static thread_local std::vector<BYTE> __IoFU;
+	if (__IoFU.size() < Size) __IoFU.resize(Size);
+	return __IoFU.data();
+}
+
+void __DEFERLOG_COMMIT(TLogSite const &Site, BYTE const *Record, size_t Size) {
+	if (__AsyncLogActive && !__AsyncLogWriter) {
+		TAsyncLogRecord AsyncRecord = { 0, ASYNCLOG_DEFERRED, (UINT32)Size, Site.Level };
+		if (__AsyncLogPut(AsyncRecord, nullptr, 0, Record, Size)) return;
+	}
+
+	static thread_local TTimeStampFormatter __Formatter;
+	static thread_local TString __Text;
+	TLogDeferredHeader Header;
+	memcpy(&Header, Record, sizeof(Header));
+	__Text.clear();
+	__DeferLogText(Site.Fmt, GetCurrentProcessId(), Header, Record + sizeof(Header), Size - sizeof(Header),
+				   __Formatter, __Text);
+	__LOG_DO(nullptr, Site.Level, _T("%s"), __Text.c_str());
+}
+
+void SETDEFERLOGTARGET(FILE *Target) {
+	// Pending records still go to the previous target
+	__AsyncLogFlush(FOREVER);
+
+	auto DeferTarget(DEFERLOGTARGET().Pickup());
+	DeferTarget->File = Target;
+	DeferTarget->Announced.clear();
+	if (Target) {
+		TDeferLogFileHeader Header = { DEFERLOG_MAGIC, DEFERLOG_VERSION, sizeof(TCHAR), GetCurrentProcessId() };
+		fwrite(&Header, sizeof(Header), 1, Target);
+		fflush(Target);
+	}
+}
+
+size_t DECODEDEFERLOG(FILE *Source, FILE *Target) {
+	TDeferLogFileHeader Header;
+	if (fread(&Header, sizeof(Header), 1, Source) != 1 || Header.Magic != DEFERLOG_MAGIC)
+		FAIL(_T("Not a deferred log file"));
+	if (Header.Version != DEFERLOG_VERSION || Header.CharSize != sizeof(TCHAR))
+		FAIL(_T("Unsupported deferred log file (version %d, character size %d)"), Header.Version, Header.CharSize);
+
+	std::unordered_map<UINT32, TString> Formats;
+	TTimeStampFormatter Formatter;
+	std::vector<BYTE> Payload;
+	TString Text;
+	size_t Count = 0;
+	TDeferLogEntryHeader Entry;
+	while (fread(&Entry, sizeof(Entry), 1, Source) == 1) {
+		Payload.resize(Entry.Size);
+		// A crashed writer may leave a partial entry behind
+		if (Entry.Size && fread(Payload.data(), Entry.Size, 1, Source) != 1) break;
+
+		switch ((TDeferLogEntry)Entry.Type) {
+			case TDeferLogEntry::Site: {
+				TDeferLogSiteEntry Site;
+				if (Entry.Size < sizeof(Site)) FAIL(_T("Malformed deferred log site entry"));
+				memcpy(&Site, Payload.data(), sizeof(Site));
+				if (Entry.Size != sizeof(Site) + Site.FmtLen * sizeof(TCHAR))
+					FAIL(_T("Malformed deferred log site entry"));
+				Formats[Site.ID].assign((PCTCHAR)(Payload.data() + sizeof(Site)), Site.FmtLen);
+			} break;
+			case TDeferLogEntry::Record: {
+				TLogDeferredHeader Record;
+				if (Entry.Size < sizeof(Record)) FAIL(_T("Malformed deferred log record entry"));
+				memcpy(&Record, Payload.data(), sizeof(Record));
+				auto Format = Formats.find(Record.SiteID);
+				if (Format == Formats.end()) FAIL(_T("Deferred log record refers to unknown site #%d"), Record.SiteID);
+				Text.clear();
+				__DeferLogText(Format->second.c_str(), Header.ProcessID, Record, Payload.data() + sizeof(Record),
+							   Entry.Size - sizeof(Record), Formatter, Text);
+				_fputts(Text.c_str(), Target);
+				Count++;
+			} break;
+			default:
+				FAIL(_T("Unrecognized deferred log entry type %d"), Entry.Type);
+		}
+	}
+	fflush(Target);
+	return Count;
+}
+
 #endif
\ No newline at end of file
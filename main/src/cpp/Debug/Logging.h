@@ -46,20 +46,289 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Debug.h"
 
+#include <atomic>
+#include <type_traits>
+
 extern TString const LOGTARGET_CONSOLE;
 
+//-------------- RUNTIME VERBOSITY
+
+enum class TLogLevel : int {
+	Off,
+	Normal,			// LOG
+	Verbose,		// LOGV
+	VeryVerbose,	// LOGVV
+};
+
+// Initial level follows the build configuration
+#if defined(DBGVV)
+#define LOGLEVEL_DEFAULT	TLogLevel::VeryVerbose
+#elif defined(DBGV)
+#define LOGLEVEL_DEFAULT	TLogLevel::Verbose
+#elif !defined(NDEBUG)
+#define LOGLEVEL_DEFAULT	TLogLevel::Normal
+#else
+#define LOGLEVEL_DEFAULT	TLogLevel::Off
+#endif
+
+/**
+ * A subsystem with its own adjustable log level
+ * - Checking the level is a single relaxed load
+ * - Constant-initialized, so it is usable during static initialization
+ **/
+class TLogModule {
+	typedef TLogModule _this;
+
+protected:
+	std::atomic<int> _Level;
+
+public:
+	PCTCHAR const Name;
+	// Whether the level was set explicitly, instead of following the global level
+	bool Override = false;
+
+	constexpr TLogModule(PCTCHAR xName) : _Level((int)LOGLEVEL_DEFAULT), Name(xName) {}
+
+	bool Enabled(TLogLevel const &xLevel) const {
+		return _Level.load(std::memory_order_relaxed) >= (int)xLevel;
+	}
+
+	TLogLevel Level(void) const {
+		return (TLogLevel)_Level.load(std::memory_order_relaxed);
+	}
+
+	void SetLevel(TLogLevel const &xLevel) {
+		_Level.store((int)xLevel, std::memory_order_relaxed);
+	}
+
+	class TRegistration {
+	public:
+		TRegistration(TLogModule &Module);
+	};
+};
+
+//! Define a log module at namespace scope
+#define LOGMODULE_DEFINE(var, name)		\
+TLogModule var(name);					\
+static TLogModule::TRegistration const __##var##_Registration(var)
+
+extern TLogModule LOGMODULE_DEFAULT;
+
+//! Set the level of all modules without an explicitly set level
+void SETLOGLEVEL(TLogLevel Level);
+//! Set the level of a module explicitly
+void SETLOGLEVEL(TString const &Module, TLogLevel Level);
+//! Let a module follow the global level again
+void RESETLOGLEVEL(TString const &Module);
+TLogLevel GETLOGLEVEL(TString const &Module);
+/**
+ * Apply a comma separated list of level settings, e.g. "Normal,WThread=VeryVerbose,SyncDQ=2"
+ * - An item without a module name sets the global level
+ * - Levels are given by name or number
+ **/
+void SETLOGLEVELS(TString const &Spec);
+
 //! Add or remove a debug log target
 void SETLOGTARGET(TString const &Name, FILE *xTarget);
 FILE * GETLOGTARGET(TString const &Name);
+//! Only write messages up to the given level to a log target (all levels by default)
+void SETLOGTARGETLEVEL(TString const &Name, TLogLevel Level);
 
 void SETDYNLOGPREFIX(TString const &Str);
 void SETDYNLOGPREFIX(TString &&Str);
 
 //! Print a formatted debug string message to a log target
-void __LOG_DO(TString const* Target, PCTCHAR Fmt, ...);
+void __LOG_DO(TString const* Target, TLogLevel Level, PCTCHAR Fmt, ...);
+
+//-------------- ASYNCHRONOUS LOGGING
+
+#define ASYNCLOG_RINGSIZE		0x40000	// 256KB per logging thread
+#define ASYNCLOG_FLUSHINTERVAL	50		// Milliseconds
+
+//! Handling of messages that do not fit in the calling thread's ring buffer
+enum class TLogOverflow {
+	Block,	// Wait for the writer to make room
+	Drop,	// Discard silently
+	Count,	// Discard, and log the number of discarded messages
+};
+
+/**
+ * Switch to asynchronous logging
+ * - Callers format messages into their own (lock-free, single producer) ring buffers
+ * - A background writer periodically drains all rings and writes each target in one batch
+ * - Messages from different threads may be written out of order
+ * - Pending messages are flushed on unhandled exceptions and at process exit
+ **/
+void STARTASYNCLOG(TLogOverflow Overflow = TLogOverflow::Count, size_t RingSize = ASYNCLOG_RINGSIZE,
+				   TimeSpan const &FlushInterval = TimeSpan(ASYNCLOG_FLUSHINTERVAL));
+//! Write out pending messages and switch back to synchronous logging
+void STOPASYNCLOG(void);
+//! Write out pending messages (safe to call from custom crash handlers)
+void FLUSHASYNCLOG(void);
+
+//-------------- DEFERRED LOGGING
+
+/**
+ * Static description of a deferred logging site
+ * - Registered once, records only refer to it by ID
+ **/
+class TLogSite {
+	typedef TLogSite _this;
+
+public:
+	PCTCHAR const Fmt;
+	TLogLevel const Level;
+	UINT32 const ID;
+
+	TLogSite(PCTCHAR xFmt, TLogLevel xLevel);
+};
+
+//! Kinds of captured arguments, each maps to one vararg slot
+enum class TLogArg : BYTE {
+	Int32,
+	Int64,
+	Double,
+	Pointer,
+	AString,	// Characters are captured, not the pointer
+	WString,	// Characters are captured, not the pointer
+};
+
+struct TLogDeferredHeader {
+	UINT32 SiteID;
+	UINT32 ThreadID;
+	UINT64 Stamp;	// MS Windows time stamp
+};
+
+#define DEFERLOG_NULLSTRING	((UINT32)-1)
+
+template<typename T, typename Enable = void>
+struct __TLogArg {
+	static_assert(sizeof(T) == 0, "Unsupported deferred logging argument type");
+};
+
+template<typename T, typename S>
+struct __TLogArgScalar {
+	static size_t Size(T const &) {
+		return 1 + sizeof(S);
+	}
+	static BYTE* Put(BYTE *Ptr, T const &X, TLogArg Kind) {
+		S Value = (S)X;
+		*Ptr = (BYTE)Kind;
+		memcpy(Ptr + 1, &Value, sizeof(S));
+		return Ptr + 1 + sizeof(S);
+	}
+};
+
+template<typename T>
+struct __TLogArg<T, std::enable_if_t<(std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) <= 4>>
+	: __TLogArgScalar<T, INT32> {
+	static BYTE* Put(BYTE *Ptr, T const &X) {
+		return __TLogArgScalar<T, INT32>::Put(Ptr, X, TLogArg::Int32);
+	}
+};
+
+template<typename T>
+struct __TLogArg<T, std::enable_if_t<(std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) == 8>>
+	: __TLogArgScalar<T, INT64> {
+	static BYTE* Put(BYTE *Ptr, T const &X) {
+		return __TLogArgScalar<T, INT64>::Put(Ptr, X, TLogArg::Int64);
+	}
+};
+
+template<typename T>
+struct __TLogArg<T, std::enable_if_t<std::is_floating_point<T>::value>>
+	: __TLogArgScalar<T, double> {
+	static BYTE* Put(BYTE *Ptr, T const &X) {
+		return __TLogArgScalar<T, double>::Put(Ptr, X, TLogArg::Double);
+	}
+};
+
+template<typename T>
+struct __TLogArg<T*, std::enable_if_t<!std::is_same<std::remove_cv_t<T>, char>::value &&
+	!std::is_same<std::remove_cv_t<T>, wchar_t>::value>> {
+	static size_t Size(T* const &) {
+		return 1 + sizeof(UINT64);
+	}
+	static BYTE* Put(BYTE *Ptr, T* const &X) {
+		UINT64 Value = (UINT_PTR)X;
+		*Ptr = (BYTE)TLogArg::Pointer;
+		memcpy(Ptr + 1, &Value, sizeof(Value));
+		return Ptr + 1 + sizeof(Value);
+	}
+};
+
+template<typename C, TLogArg K>
+struct __TLogArgString {
+	static size_t Size(C const *X) {
+		return 1 + sizeof(UINT32) + (X ? std::char_traits<C>::length(X) * sizeof(C) : 0);
+	}
+	static BYTE* Put(BYTE *Ptr, C const *X) {
+		UINT32 Len = X ? (UINT32)std::char_traits<C>::length(X) : DEFERLOG_NULLSTRING;
+		*Ptr = (BYTE)K;
+		memcpy(Ptr + 1, &Len, sizeof(Len));
+		Ptr += 1 + sizeof(Len);
+		if (X) {
+			memcpy(Ptr, X, Len * sizeof(C));
+			Ptr += Len * sizeof(C);
+		}
+		return Ptr;
+	}
+};
 
-#define __LOG(...)		__LOG_DO(nullptr, __VA_ARGS__)
-#define __TLOG(t, ...)	__LOG_DO(t, __VA_ARGS__)
+template<typename T>
+struct __TLogArg<T*, std::enable_if_t<std::is_same<std::remove_cv_t<T>, char>::value>>
+	: __TLogArgString<char, TLogArg::AString> {};
+
+template<typename T>
+struct __TLogArg<T*, std::enable_if_t<std::is_same<std::remove_cv_t<T>, wchar_t>::value>>
+	: __TLogArgString<wchar_t, TLogArg::WString> {};
+
+//! Per-thread scratch space for capturing a record
+BYTE* __DEFERLOG_BUFFER(size_t Size);
+//! Queue a captured record (or format it immediately, if asynchronous logging is inactive)
+void __DEFERLOG_COMMIT(TLogSite const &Site, BYTE const *Record, size_t Size);
+
+inline size_t __DeferLogSize(void) {
+	return 0;
+}
+
+template<typename T, typename... Args>
+size_t __DeferLogSize(T const &X, Args const&... xArgs) {
+	return __TLogArg<std::decay_t<T>>::Size(X) + __DeferLogSize(xArgs...);
+}
+
+inline BYTE* __DeferLogPut(BYTE *Ptr) {
+	return Ptr;
+}
+
+template<typename T, typename... Args>
+BYTE* __DeferLogPut(BYTE *Ptr, T const &X, Args const&... xArgs) {
+	return __DeferLogPut(__TLogArg<std::decay_t<T>>::Put(Ptr, X), xArgs...);
+}
+
+template<typename... Args>
+void __DEFERLOG_DO(TLogSite const &Site, Args const&... xArgs) {
+	size_t Size = sizeof(TLogDeferredHeader) + __DeferLogSize(xArgs...);
+	BYTE *Record = __DEFERLOG_BUFFER(Size);
+	TLogDeferredHeader Header = { Site.ID, GetCurrentThreadId(), (UINT64)TimeStamp::Now().MSWINTS() };
+	memcpy(Record, &Header, sizeof(Header));
+	__DeferLogPut(Record + sizeof(Header), xArgs...);
+	__DEFERLOG_COMMIT(Site, Record, Size);
+}
+
+/**
+ * Write deferred records to a binary file, instead of formatting them
+ * - Only takes effect with asynchronous logging, records are formatted immediately otherwise
+ * - The file is self-contained (includes site formats), decode it with DECODEDEFERLOG
+ * - Pass nullptr to switch back to formatting
+ **/
+void SETDEFERLOGTARGET(FILE *Target);
+
+//! Decode a binary deferred log file into text, returns the number of decoded records
+size_t DECODEDEFERLOG(FILE *Source, FILE *Target);
+
+#define __LOG(...)			__LOG_DO(nullptr, TLogLevel::Normal, __VA_ARGS__)
+#define __TLOG(t, l, ...)	__LOG_DO(t, l, __VA_ARGS__)
 
 //-------------- LOGGING
 extern thread_local TString __DynLogPfx;
@@ -70,45 +339,164 @@ extern thread_local TString __DynLogPfx;
 #define LOG_DO(x)	;
 #endif
 
-#define _TLOG(t,fmt, ...)											\
+#define _TLOGL(t,l,fmt, ...)										\
 LOG_DO({															\
-	TString __TS = __TimeStamp();									\
-	__TLOG(t, _T("[%s] %s | %s") fmt TNewLine,						\
-		__PTID(), __TS.c_str(), __DynLogPfx.c_str()					\
+	PCTCHAR __TS = __TimeStamp();									\
+	__TLOG(t, l, _T("[%s] %s | %s") fmt TNewLine,					\
+		__PTID(), __TS, __DynLogPfx.c_str()							\
 		__VAWRAP(__VA_ARGS__));										\
 })
 
-#define _TLOGS(t,fmt, ...)											\
+#define _TLOGSL(t,l,fmt, ...)											\
+LOG_DO({																\
+	SOURCEMARK															\
+	PCTCHAR __TS = __TimeStamp();										\
+	__TLOG(t, l, _T("@<%s>") TNewLine _T("[%s] %s | %s") fmt TNewLine,	\
+		__SrcMark.c_str(), __PTID(), __TS,								\
+		__DynLogPfx.c_str() __VAWRAP(__VA_ARGS__));						\
+})
+
+#define _TLOG(t,fmt, ...)	_TLOGL(t, TLogLevel::Normal, fmt, __VA_ARGS__)
+#define _TLOGS(t,fmt, ...)	_TLOGSL(t, TLogLevel::Normal, fmt, __VA_ARGS__)
+
+#define _LOGL(l,fmt, ...)	_TLOGL(nullptr, l, fmt, __VA_ARGS__)
+#define _LOGSL(l,fmt, ...)	_TLOGSL(nullptr, l, fmt, __VA_ARGS__)
+#define _LOG(fmt, ...)		_TLOG(nullptr, fmt, __VA_ARGS__)
+#define _LOGS(fmt, ...)		_TLOGS(nullptr, fmt, __VA_ARGS__)
+
+// Only captures the site ID and raw arguments, formatting happens later
+#define _DLOGL(l,fmt, ...)											\
 LOG_DO({															\
-	SOURCEMARK														\
-	TString __TS = __TimeStamp();									\
-	__TLOG(t, _T("@<%s>") TNewLine _T("[%s] %s | %s") fmt TNewLine,	\
-		__SrcMark.c_str(), __PTID(), __TS.c_str(),					\
-		__DynLogPfx.c_str() __VAWRAP(__VA_ARGS__));					\
+	static TLogSite const __DLSite(_T("%s") fmt TNewLine, l);		\
+	__DEFERLOG_DO(__DLSite, __DynLogPfx.c_str()						\
+		__VAWRAP(__VA_ARGS__));										\
 })
 
-#define _LOG(fmt, ...)	_TLOG(nullptr, fmt, __VA_ARGS__)
-#define _LOGS(fmt, ...)	_TLOGS(nullptr, fmt, __VA_ARGS__)
+#define _DLOG(fmt, ...)		_DLOGL(TLogLevel::Normal, fmt, __VA_ARGS__)
 
 #ifndef __LOGPFX__
 #define __LOGPFX__
 #endif
 
+//! The log module of call sites in a source file
+#ifndef __LOGMODULE__
+#define __LOGMODULE__	LOGMODULE_DEFAULT
+#endif
+
 //-------------- DEBUG LOGGING
 
-#define LOG(s, ...)		DEBUG_DO(_LOG(__LOGPFX__ s, __VA_ARGS__))
-#define LOGS(s, ...)	DEBUG_DO(_LOGS(__LOGPFX__ s, __VA_ARGS__))
-#define LOGV(s, ...)	DEBUGV_DO(_LOG(__LOGPFX__ s, __VA_ARGS__))
-#define LOGSV(s, ...)	DEBUGV_DO(_LOGS(__LOGPFX__ s, __VA_ARGS__))
-#define LOGVV(s, ...)	DEBUGVV_DO(_LOG(__LOGPFX__ s, __VA_ARGS__))
-#define LOGSVV(s, ...)	DEBUGVV_DO(_LOGS(__LOGPFX__ s, __VA_ARGS__))
+// By default, all levels are compiled in and only the runtime level decides, so verbosity can be raised on a live process
+// With LOGLEVEL_COMPILETIME, levels beyond the build configuration (DBGV / DBGVV / NDEBUG) are compiled out instead
+#ifndef LOGLEVEL_COMPILETIME
+#define LOGLEVEL_RUNTIME
+#endif
+
+#ifdef LOGLEVEL_RUNTIME
+#define LOGLEVEL_DO(x)		x
+#define LOGLEVELV_DO(x)		x
+#define LOGLEVELVV_DO(x)	x
+#else
+#define LOGLEVEL_DO(x)		DEBUG_DO(x)
+#define LOGLEVELV_DO(x)		DEBUGV_DO(x)
+#define LOGLEVELVV_DO(x)	DEBUGVV_DO(x)
+#endif
+
+#define __LOGIF(m,l,x)		{ if ((m).Enabled(l)) x }
+
+#define MLOG(m,s, ...)		LOGLEVEL_DO(__LOGIF(m, TLogLevel::Normal, _LOGL(TLogLevel::Normal, __LOGPFX__ s, __VA_ARGS__)))
+#define MLOGS(m,s, ...)		LOGLEVEL_DO(__LOGIF(m, TLogLevel::Normal, _LOGSL(TLogLevel::Normal, __LOGPFX__ s, __VA_ARGS__)))
+#define MLOGV(m,s, ...)		LOGLEVELV_DO(__LOGIF(m, TLogLevel::Verbose, _LOGL(TLogLevel::Verbose, __LOGPFX__ s, __VA_ARGS__)))
+#define MLOGSV(m,s, ...)	LOGLEVELV_DO(__LOGIF(m, TLogLevel::Verbose, _LOGSL(TLogLevel::Verbose, __LOGPFX__ s, __VA_ARGS__)))
+#define MLOGVV(m,s, ...)	LOGLEVELVV_DO(__LOGIF(m, TLogLevel::VeryVerbose, _LOGL(TLogLevel::VeryVerbose, __LOGPFX__ s, __VA_ARGS__)))
+#define MLOGSVV(m,s, ...)	LOGLEVELVV_DO(__LOGIF(m, TLogLevel::VeryVerbose, _LOGSL(TLogLevel::VeryVerbose, __LOGPFX__ s, __VA_ARGS__)))
+
+#define MDLOG(m,s, ...)		LOGLEVEL_DO(__LOGIF(m, TLogLevel::Normal, _DLOGL(TLogLevel::Normal, __LOGPFX__ s, __VA_ARGS__)))
+#define MDLOGV(m,s, ...)	LOGLEVELV_DO(__LOGIF(m, TLogLevel::Verbose, _DLOGL(TLogLevel::Verbose, __LOGPFX__ s, __VA_ARGS__)))
+#define MDLOGVV(m,s, ...)	LOGLEVELVV_DO(__LOGIF(m, TLogLevel::VeryVerbose, _DLOGL(TLogLevel::VeryVerbose, __LOGPFX__ s, __VA_ARGS__)))
+
+#define LOG(s, ...)		MLOG(__LOGMODULE__, s, __VA_ARGS__)
+#define LOGS(s, ...)	MLOGS(__LOGMODULE__, s, __VA_ARGS__)
+#define LOGV(s, ...)	MLOGV(__LOGMODULE__, s, __VA_ARGS__)
+#define LOGSV(s, ...)	MLOGSV(__LOGMODULE__, s, __VA_ARGS__)
+#define LOGVV(s, ...)	MLOGVV(__LOGMODULE__, s, __VA_ARGS__)
+#define LOGSVV(s, ...)	MLOGSVV(__LOGMODULE__, s, __VA_ARGS__)
 
-#define TLOG(t,s, ...)		DEBUG_DO(_TLOG(t, __LOGPFX__ s, __VA_ARGS__))
-#define TLOGS(t,s, ...)		DEBUG_DO(_TLOGS(t, __LOGPFX__ s, __VA_ARGS__))
-#define TLOGV(t,s, ...)		DEBUGV_DO(_TLOG(t, __LOGPFX__ s, __VA_ARGS__))
-#define TLOGSV(t,s, ...)	DEBUGV_DO(_TLOGS(t, __LOGPFX__ s, __VA_ARGS__))
-#define TLOGVV(t,s, ...)	DEBUGVV_DO(_TLOG(t, __LOGPFX__ s, __VA_ARGS__))
-#define TLOGSVV(t,s, ...)	DEBUGVV_DO(_TLOGS(t, __LOGPFX__ s, __VA_ARGS__))
+#define DLOG(s, ...)	MDLOG(__LOGMODULE__, s, __VA_ARGS__)
+#define DLOGV(s, ...)	MDLOGV(__LOGMODULE__, s, __VA_ARGS__)
+#define DLOGVV(s, ...)	MDLOGVV(__LOGMODULE__, s, __VA_ARGS__)
+
+#define TLOG(t,s, ...)		LOGLEVEL_DO(__LOGIF(__LOGMODULE__, TLogLevel::Normal, _TLOGL(t, TLogLevel::Normal, __LOGPFX__ s, __VA_ARGS__)))
+#define TLOGS(t,s, ...)		LOGLEVEL_DO(__LOGIF(__LOGMODULE__, TLogLevel::Normal, _TLOGSL(t, TLogLevel::Normal, __LOGPFX__ s, __VA_ARGS__)))
+#define TLOGV(t,s, ...)		LOGLEVELV_DO(__LOGIF(__LOGMODULE__, TLogLevel::Verbose, _TLOGL(t, TLogLevel::Verbose, __LOGPFX__ s, __VA_ARGS__)))
+#define TLOGSV(t,s, ...)	LOGLEVELV_DO(__LOGIF(__LOGMODULE__, TLogLevel::Verbose, _TLOGSL(t, TLogLevel::Verbose, __LOGPFX__ s, __VA_ARGS__)))
+#define TLOGVV(t,s, ...)	LOGLEVELVV_DO(__LOGIF(__LOGMODULE__, TLogLevel::VeryVerbose, _TLOGL(t, TLogLevel::VeryVerbose, __LOGPFX__ s, __VA_ARGS__)))
+#define TLOGSVV(t,s, ...)	LOGLEVELVV_DO(__LOGIF(__LOGMODULE__, TLogLevel::VeryVerbose, _TLOGSL(t, TLogLevel::VeryVerbose, __LOGPFX__ s, __VA_ARGS__)))
+
+//-------------- THROTTLED LOGGING
+
+/**
+ * Per call site state of throttled logging
+ * - Constant-initialized and lock-free, so it is a function-local static without guard
+ * - Each check also reports how many messages were suppressed since the last report
+ **/
+class TLogThrottle {
+	typedef TLogThrottle _this;
+
+protected:
+	std::atomic<long long> _Count;
+	std::atomic<long long> _Suppressed;
+	std::atomic<long long> _Window;
+	std::atomic<long long> _WindowCount;
+
+public:
+	constexpr TLogThrottle(void) : _Count(0), _Suppressed(0), _Window(0), _WindowCount(0) {}
+
+	//! Pass every N-th message
+	bool EveryN(long long N, long long &Suppressed);
+	//! Pass the first N messages, then report suppressed counts at exponentially growing intervals
+	bool FirstN(long long N, long long &Suppressed);
+	//! Pass at most N messages per second
+	bool RateLimited(long long PerSecond, long long &Suppressed);
+	//! Pass each message with the given probability
+	bool Sampled(double Probability, long long &Suppressed);
+};
+
+#define LOGTHROTTLE_SUMMARY	_T("(%lld similar messages suppressed)")
+
+#define EVERY_N(n)			EveryN(n, __LTSuppressed)
+#define FIRST_N(n)			FirstN(n, __LTSuppressed)
+#define RATE_LIMITED(r)		RateLimited(r, __LTSuppressed)
+#define SAMPLED(p)			Sampled(p, __LTSuppressed)
+
+// Messages the module would not log are neither passed nor counted as suppressed
+#define __LOGTHROTTLED(m,l,check, summary, x) {		\
+	if ((m).Enabled(l)) {							\
+		static TLogThrottle __LTSite;				\
+		long long __LTSuppressed = 0;				\
+		bool __LTPass = __LTSite.check;				\
+		if (__LTSuppressed) summary;				\
+		if (__LTPass) x;							\
+	}												\
+}
+
+//! Throttle a logging statement of a module at a level (e.g. MLOGV) with EVERY_N / FIRST_N / RATE_LIMITED / SAMPLED
+#define MLOG_THROTTLED(m,l,check, x)	\
+	LOGLEVEL_DO(__LOGTHROTTLED(m, l, check, _LOGL(l, __LOGPFX__ LOGTHROTTLE_SUMMARY, __LTSuppressed), x))
+//! Throttle any logging statement of the source file's module (e.g. LOG, ERRLOG)
+#define LOG_THROTTLED(check, x)			MLOG_THROTTLED(__LOGMODULE__, TLogLevel::Normal, check, x)
+#define TLOG_THROTTLED(t,check, x)		\
+	LOGLEVEL_DO(__LOGTHROTTLED(__LOGMODULE__, TLogLevel::Normal, check,										\
+							   _TLOGL(t, TLogLevel::Normal, __LOGPFX__ LOGTHROTTLE_SUMMARY, __LTSuppressed), x))
+
+#define LOG_EVERY_N(n,s, ...)		LOG_THROTTLED(EVERY_N(n), LOG(s, __VA_ARGS__))
+#define LOG_FIRST_N(n,s, ...)		LOG_THROTTLED(FIRST_N(n), LOG(s, __VA_ARGS__))
+#define LOG_RATE_LIMITED(r,s, ...)	LOG_THROTTLED(RATE_LIMITED(r), LOG(s, __VA_ARGS__))
+#define LOG_SAMPLED(p,s, ...)		LOG_THROTTLED(SAMPLED(p), LOG(s, __VA_ARGS__))
+
+#define TLOG_EVERY_N(t,n,s, ...)		TLOG_THROTTLED(t, EVERY_N(n), TLOG(t, s, __VA_ARGS__))
+#define TLOG_FIRST_N(t,n,s, ...)		TLOG_THROTTLED(t, FIRST_N(n), TLOG(t, s, __VA_ARGS__))
+#define TLOG_RATE_LIMITED(t,r,s, ...)	TLOG_THROTTLED(t, RATE_LIMITED(r), TLOG(t, s, __VA_ARGS__))
+#define TLOG_SAMPLED(t,p,s, ...)		TLOG_THROTTLED(t, SAMPLED(p), TLOG(t, s, __VA_ARGS__))
 
 #ifdef DEFAULT_LOG_WITH_SOURCE
 #undef LOG
@@ -118,6 +506,13 @@ LOG_DO({															\
 #undef LOGVV
 #define LOGVV LOGSVV
 
+#undef MLOG
+#define MLOG MLOGS
+#undef MLOGV
+#define MLOGV MLOGSV
+#undef MLOGVV
+#define MLOGVV MLOGSVV
+
 #undef TLOG
 #define TLOG TLOGS
 #undef TLOGV
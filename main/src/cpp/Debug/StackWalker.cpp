@@ -124,28 +124,28 @@ bool TStackWalker::LogError(LPCTSTR FuncHint, DWORD errCode, PVOID addr) {
 
 TString TStackWalker::FormatEntry(CallstackEntry const &Entry) {
 	return Entry.FileName.empty() ?
-		TStringCast(_T('!') << (Entry.ModuleName.empty() ? STR_NoModuleName : Entry.ModuleName.c_str())
-					<< _T('@') << (Entry.ModuleBase ?
-								   TStringCast(Entry.ModuleBase
-											   << _T('+') << std::hex
-											   << (__ARC_INT)Entry.Address - (__ARC_INT)Entry.ModuleBase) :
-								   TStringCast(Entry.Address))
-					<< _T(':')
-					<< (Entry.SymbolName.empty() ? STR_NoSymbolName : Entry.SymbolName.c_str())
-					<< (Entry.SmybolOffset ? TStringCast(_T('+') << Entry.SmybolOffset) : _T(""))
+		TStringFmt(_T('!') << (Entry.ModuleName.empty() ? STR_NoModuleName : Entry.ModuleName.c_str())
+				   << _T('@') << (Entry.ModuleBase ?
+								  TStringFmt(Entry.ModuleBase
+											 << _T('+')
+											 << FmtHex((__ARC_INT)Entry.Address - (__ARC_INT)Entry.ModuleBase, 0, false)) :
+								  TStringFmt(Entry.Address))
+				   << _T(':')
+				   << (Entry.SymbolName.empty() ? STR_NoSymbolName : Entry.SymbolName.c_str())
+				   << (Entry.SmybolOffset ? TStringFmt(_T('+') << Entry.SmybolOffset) : _T(""))
 		) :
-		TStringCast(Entry.FileName << _T('#') << Entry.LineNumber
-					// << (Entry.LineOffset ? _T("+") : _T(""))
-					<< _T(':')
-					<< (Entry.SymbolName.empty() ? STR_NoSymbolName : Entry.SymbolName.c_str())
+		TStringFmt(Entry.FileName << _T('#') << Entry.LineNumber
+				   // << (Entry.LineOffset ? _T("+") : _T(""))
+				   << _T(':')
+				   << (Entry.SymbolName.empty() ? STR_NoSymbolName : Entry.SymbolName.c_str())
 		);
 }
 
 TString TStackWalker::FormatError(LPCTSTR FuncHint, DWORD errCode, PVOID addr) {
 	TString ErrMsg;
 	if (DecodeSysError(errCode, ErrMsg) != nullptr)
-		return TStringCast(_T('!') << FuncHint << _T('@') << addr << _T(':') << ErrMsg);
-	return TStringCast(_T('!') << FuncHint << _T('@') << addr << _T(":0x") << std::hex << errCode);
+		return TStringFmt(_T('!') << FuncHint << _T('@') << addr << _T(':') << ErrMsg);
+	return TStringFmt(_T('!') << FuncHint << _T('@') << addr << _T(":0x") << FmtHex(errCode, 0, false));
 }
 
 class StackWalker_Impl : public TStackWalker {
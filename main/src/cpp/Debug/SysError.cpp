@@ -149,7 +149,7 @@ SystemError* SystemError::MakeClone(IAllocator &xAlloc) const {
 TString const& SystemError::ErrorMessage(void) const {
 	if (rErrorMsg.empty()) {
 		if (DecodeSysError(ErrorCode, rErrorMsg) == nullptr)
-			rErrorMsg = TStringCast(_T("Undecodable error ") << ErrorCode << _T(" (0x") << std::hex << ErrorCode << _T(')'));
+			rErrorMsg = TStringFmt(_T("Undecodable error ") << ErrorCode << _T(" (0x") << FmtHex(ErrorCode, 0, false) << _T(')'));
 	}
 	return rErrorMsg;
 }
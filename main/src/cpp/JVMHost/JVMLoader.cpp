@@ -108,7 +108,7 @@ void TJVM::FreeJVM(JavaVM* &Inst) {
 
 TJVM::InitArgs TJVM::PrepareArgs(TString const &ClassPath, TString const &LocalJREPath, int DebugPort, int RemotePort) {
 	if (!LocalJREPath.empty()) {
-		AddSearchPath(TStringCast(LocalJREPath << _T(JRE_PLATFORM_PATHFRAG) _T("\\bin\\server")));
+		AddSearchPath(TStringFmt(LocalJREPath << _T(JRE_PLATFORM_PATHFRAG) _T("\\bin\\server")));
 	}
 
 	TJVMOptions Opts;
@@ -117,20 +117,20 @@ TJVM::InitArgs TJVM::PrepareArgs(TString const &ClassPath, TString const &LocalJ
 		TString ConvErrMsg;
 		CString ConvClassPath = WStringtoCString(CP_ACP, ClassPath, ConvErrMsg);
 		if (!ConvErrMsg.empty()) FAIL(_T("Failed to convert class path - %s"), ConvErrMsg.c_str());
-		Opts.emplace_back(CStringCast("-Djava.class.path=" << ConvClassPath.c_str()), nullptr);
+		Opts.emplace_back(CStringFmt("-Djava.class.path=" << ConvClassPath), nullptr);
 	}
 #else
-	Opts.emplace_back(CStringCast("-Djava.class.path=" << ClassPath.c_str()), nullptr);
+	Opts.emplace_back(CStringFmt("-Djava.class.path=" << ClassPath), nullptr);
 #endif
 
 	if (DebugPort != 0)
-		Opts.emplace_back(CStringCast("-agentlib:jdwp=transport=dt_socket,server=y,suspend=n,address=" << DebugPort), nullptr);
+		Opts.emplace_back(CStringFmt("-agentlib:jdwp=transport=dt_socket,server=y,suspend=n,address=" << DebugPort), nullptr);
 
 	if (RemotePort != 0) {
-		Opts.emplace_back(CStringCast("-Dcom.sun.management.jmxremote=true"), nullptr);
-		Opts.emplace_back(CStringCast("-Dcom.sun.management.jmxremote.authenticate=false"), nullptr);
-		Opts.emplace_back(CStringCast("-Dcom.sun.management.jmxremote.ssl=false"), nullptr);
-		Opts.emplace_back(CStringCast("-Dcom.sun.management.jmxremote.port=" << RemotePort), nullptr);
+		Opts.emplace_back(CString("-Dcom.sun.management.jmxremote=true"), nullptr);
+		Opts.emplace_back(CString("-Dcom.sun.management.jmxremote.authenticate=false"), nullptr);
+		Opts.emplace_back(CString("-Dcom.sun.management.jmxremote.ssl=false"), nullptr);
+		Opts.emplace_back(CStringFmt("-Dcom.sun.management.jmxremote.port=" << RemotePort), nullptr);
 	}
 
 	InitArgs Ret;
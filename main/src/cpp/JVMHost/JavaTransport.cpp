@@ -57,7 +57,7 @@ TJavaTransportV1::TJavaTransportV1(TJVM &JVM, TNativeChunkPool &xChunkPool,
 #ifdef UNICODE
 	{
 		TString ConvErrMsg;
-		CString ConvClassName = WStringtoCString(CP_ACP, TransportClassName, ConvErrMsg);
+		CString ConvClassName = WStringtoUTF8(TransportClassName, ConvErrMsg);
 		if (!ConvErrMsg.empty()) FAIL(_T("Failed to convert class name - %s"), ConvErrMsg.c_str());
 		TransportClass = Env->FindClass(ConvClassName.c_str());
 	}
@@ -69,7 +69,7 @@ TJavaTransportV1::TJavaTransportV1(TJVM &JVM, TNativeChunkPool &xChunkPool,
 #ifdef UNICODE
 	{
 		TString ConvErrMsg;
-		CString ConvForwardMethodName = WStringtoCString(CP_ACP, ForwardMethodName, ConvErrMsg);
+		CString ConvForwardMethodName = WStringtoUTF8(ForwardMethodName, ConvErrMsg);
 		if (!ConvErrMsg.empty()) FAIL(_T("Failed to convert forward method name - %s"), ConvErrMsg.c_str());
 		ForwardMethodID = Env->GetStaticMethodID(TransportClass, ConvForwardMethodName.c_str(), "(Ljava/nio/ByteBuffer;)V");
 	}
@@ -83,7 +83,7 @@ TJavaTransportV1::TJavaTransportV1(TJVM &JVM, TNativeChunkPool &xChunkPool,
 	CString ConvReturnMethodName;
 	{
 		TString ConvErrMsg;
-		ConvReturnMethodName = WStringtoCString(CP_ACP, ReturnMethodName, ConvErrMsg);
+		ConvReturnMethodName = WStringtoUTF8(ReturnMethodName, ConvErrMsg);
 		if (!ConvErrMsg.empty()) FAIL(_T("Failed to convert return method name - %s"), ConvErrMsg.c_str());
 		RegMethod = { const_cast<char*>(ConvReturnMethodName.c_str()), "(JJ)V", &__ReturnStubV1 };
 	}
@@ -96,7 +96,7 @@ TJavaTransportV1::TJavaTransportV1(TJVM &JVM, TNativeChunkPool &xChunkPool,
 #ifdef UNICODE
 	{
 		TString ConvErrMsg;
-		CString ConvTerminateMethodName = WStringtoCString(CP_ACP, TerminateMethodName, ConvErrMsg);
+		CString ConvTerminateMethodName = WStringtoUTF8(TerminateMethodName, ConvErrMsg);
 		if (!ConvErrMsg.empty()) FAIL(_T("Failed to convert terminate method name - %s"), ConvErrMsg.c_str());
 		TerminateMethodID = Env->GetStaticMethodID(TransportClass, ConvTerminateMethodName.c_str(), "()V");
 	}
@@ -118,7 +118,10 @@ void TJavaTransportV1::Forward(TNativeChunk* Chunk) {
 	jobject ChunkWrap = Env->NewDirectByteBuffer(BufferV1, ChunkV1->Size());
 	if (ChunkWrap == nullptr) FAIL(_T("Unable to allocate buffer wrapper"));
 
-	Env->CallStaticVoidMethod(TransportClass, ForwardMethodID, ChunkWrap);
+	{
+		THistogram::TScopedTimer ForwardTimer(&_ForwardLatency);
+		Env->CallStaticVoidMethod(TransportClass, ForwardMethodID, ChunkWrap);
+	}
 	LOGVV(_T("Forwarded chunk #%p"), ChunkV1);
 }
 
@@ -45,6 +45,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Misc/Global.h"
 
 #include "Misc/TString.h"
+#include "Misc/Histogram.h"
 
 #include "Debug/Exception.h"
 
@@ -74,6 +75,9 @@ public:
 	{ FAIL(_T("Abstract function")); }
 	virtual void Terminate(void)
 	{ FAIL(_T("Abstract function")); }
+	// Time spent in each forward call into Java
+	virtual THistogram::TSnapshot ForwardLatency(void) const
+	{ FAIL(_T("Abstract function")); }
 };
 
 class TJavaTransportV1 : public TJavaTransport {
@@ -84,6 +88,7 @@ protected:
 	jmethodID ForwardMethodID;
 	jmethodID TerminateMethodID;
 	TNativeChunkPool &ChunkPool;
+	THistogram _ForwardLatency;
 
 public:
 	TJavaTransportV1(TJVM &JVM, TNativeChunkPool &xChunkPool,
@@ -98,6 +103,8 @@ public:
 	void Forward(TNativeChunk* Chunk);
 	void Return(TNativeChunk* Chunk);
 	void Terminate(void);
+	THistogram::TSnapshot ForwardLatency(void) const
+	{ return _ForwardLatency.Snapshot(); }
 };
 
 #endif //ZWUtils_JavaTransport_H
@@ -51,7 +51,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 class TNativeChunkPool {
 protected:
-	typedef TSyncBlockingDeque<MRNativeChunk> TChunkStore;
+	typedef TSyncBlockingDeque<MRNativeChunk, TSDQPolicy_ConstIter> TChunkStore;
 	TChunkStore Store;
 
 	size_t PoolLimit;
@@ -76,7 +76,7 @@ public:
 	}
 
 	virtual TString toString(void) const {
-		return TStringCast(_T("MObj@") << (void*)this << _T('(') << RefCount() << _T(')'));
+		return TStringFmt(_T("MObj@") << (void*)this << _T('(') << RefCount() << _T(')'));
 	}
 };
 
@@ -93,12 +93,12 @@ private:
 
 	template<typename X = TObject>
 	auto _toString(bool Debug = false) const -> decltype(std::enable_if<Has_toString<X>::value, TString>::type()) {
-		return Debug ? TStringCast(X::toString() << _T("#MObj(") << RefCount() << _T(')')) : X::toString();
+		return Debug ? TStringFmt(X::toString() << _T("#MObj(") << RefCount() << _T(')')) : X::toString();
 	}
 
 	template<typename X = TObject, typename = void>
 	auto _toString(void) const -> decltype(std::enable_if<!Has_toString<X>::value, TString>::type()) {
-		return TStringCast(_T('#') << ManagedObj::toString());
+		return TStringFmt(_T('#') << ManagedObj::toString());
 	}
 
 public:
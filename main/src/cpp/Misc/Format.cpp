@@ -0,0 +1,237 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// [Utilities] Fast type-safe string formatting
+
+#include "Format.h"
+
+#include <stdio.h>
+#include <cwchar>
+
+#if defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define FORMAT_SSE2
+#include <emmintrin.h>
+#endif
+
+static char const __DecPairs[] =
+	"00010203040506070809" "10111213141516171819" "20212223242526272829" "30313233343536373839"
+	"40414243444546474849" "50515253545556575859" "60616263646566676869" "70717273747576777879"
+	"80818283848586878889" "90919293949596979899";
+
+static char const __HexUpper[] = "0123456789ABCDEF";
+static char const __HexLower[] = "0123456789abcdef";
+
+// Produce digits from the end, two at a time
+template<typename C>
+size_t _FormatDec(C *Buf, unsigned long long Value) {
+	C Digits[20];
+	C *Ptr = Digits + 20;
+	while (Value >= 100) {
+		unsigned int Idx = (unsigned int)(Value % 100) * 2;
+		Value /= 100;
+		*--Ptr = __DecPairs[Idx + 1];
+		*--Ptr = __DecPairs[Idx];
+	}
+	if (Value >= 10) {
+		unsigned int Idx = (unsigned int)Value * 2;
+		*--Ptr = __DecPairs[Idx + 1];
+		*--Ptr = __DecPairs[Idx];
+	} else *--Ptr = (C)('0' + Value);
+	size_t Len = Digits + 20 - Ptr;
+	memcpy(Buf, Ptr, Len * sizeof(C));
+	return Len;
+}
+
+template<typename C>
+size_t _FormatHex(C *Buf, unsigned long long Value, unsigned int Width, bool Upper) {
+	char const *Symbols = Upper ? __HexUpper : __HexLower;
+	size_t Len = 1;
+	while (Len < 16 && (Value >> (Len * 4))) Len++;
+	if (Len < Width) Len = Width;
+	for (size_t i = Len; i > 0; i--, Value >>= 4) Buf[i - 1] = Symbols[Value & 0xF];
+	return Len;
+}
+
+size_t __FormatDec(char *Buf, unsigned long long Value) {
+	return _FormatDec(Buf, Value);
+}
+
+size_t __FormatDec(wchar_t *Buf, unsigned long long Value) {
+	return _FormatDec(Buf, Value);
+}
+
+size_t __FormatHex(char *Buf, unsigned long long Value, unsigned int Width, bool Upper) {
+	return _FormatHex(Buf, Value, Width, Upper);
+}
+
+size_t __FormatHex(wchar_t *Buf, unsigned long long Value, unsigned int Width, bool Upper) {
+	return _FormatHex(Buf, Value, Width, Upper);
+}
+
+// Same as the default stream rendering
+size_t __FormatReal(char *Buf, double Value) {
+	int Len = _snprintf_s(Buf, FORMAT_REALLEN, _TRUNCATE, "%g", Value);
+	return Len < 0 ? 0 : Len;
+}
+
+size_t __FormatReal(wchar_t *Buf, double Value) {
+	int Len = _snwprintf_s(Buf, FORMAT_REALLEN, _TRUNCATE, L"%g", Value);
+	return Len < 0 ? 0 : Len;
+}
+
+//
+// Bulk hex codec, 16 bytes at a time when SSE2 is available
+//
+
+#ifdef FORMAT_SSE2
+
+// Turn one nibble per byte into hex digit characters
+inline __m128i __HexNibbleToDigit(__m128i N, __m128i AlphaOfs) {
+	__m128i IsAlpha = _mm_cmpgt_epi8(N, _mm_set1_epi8(9));
+	return _mm_add_epi8(_mm_add_epi8(N, _mm_set1_epi8('0')), _mm_and_si128(IsAlpha, AlphaOfs));
+}
+
+// Turn hex digit characters into one nibble per byte, fails if any of them is not a hex digit
+inline bool __HexDigitToNibble(__m128i D, __m128i &N) {
+	__m128i IsDigit = _mm_and_si128(_mm_cmpgt_epi8(D, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(D, _mm_set1_epi8('9' + 1)));
+	__m128i Lower = _mm_or_si128(D, _mm_set1_epi8(0x20));
+	__m128i IsAlpha = _mm_and_si128(_mm_cmpgt_epi8(Lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(Lower, _mm_set1_epi8('f' + 1)));
+	if (_mm_movemask_epi8(_mm_or_si128(IsDigit, IsAlpha)) != 0xFFFF) return false;
+	N = _mm_or_si128(_mm_and_si128(IsDigit, _mm_sub_epi8(D, _mm_set1_epi8('0'))),
+					 _mm_andnot_si128(IsDigit, _mm_sub_epi8(Lower, _mm_set1_epi8('a' - 10))));
+	return true;
+}
+
+// Merge (high, low) nibble pairs into bytes, one per 16-bit lane
+inline __m128i __HexNibblePairs(__m128i N) {
+	return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(N, _mm_set1_epi16(0x00FF)), 4), _mm_srli_epi16(N, 8));
+}
+
+inline void __HexStore(char *Dst, __m128i V) {
+	_mm_storeu_si128((__m128i*)Dst, V);
+}
+
+inline void __HexStore(wchar_t *Dst, __m128i V) {
+	__m128i Zero = _mm_setzero_si128();
+	__m128i L = _mm_unpacklo_epi8(V, Zero);
+	__m128i H = _mm_unpackhi_epi8(V, Zero);
+#if WCHAR_MAX > 0xFFFF
+	_mm_storeu_si128((__m128i*)Dst, _mm_unpacklo_epi16(L, Zero));
+	_mm_storeu_si128((__m128i*)(Dst + 4), _mm_unpackhi_epi16(L, Zero));
+	_mm_storeu_si128((__m128i*)(Dst + 8), _mm_unpacklo_epi16(H, Zero));
+	_mm_storeu_si128((__m128i*)(Dst + 12), _mm_unpackhi_epi16(H, Zero));
+#else
+	_mm_storeu_si128((__m128i*)Dst, L);
+	_mm_storeu_si128((__m128i*)(Dst + 8), H);
+#endif
+}
+
+inline __m128i __HexLoad(char const *Src) {
+	return _mm_loadu_si128((__m128i const*)Src);
+}
+
+// Wide characters outside of byte range saturate into non-hex bytes
+inline __m128i __HexLoad(wchar_t const *Src) {
+#if WCHAR_MAX > 0xFFFF
+	__m128i A = _mm_packs_epi32(_mm_loadu_si128((__m128i const*)Src), _mm_loadu_si128((__m128i const*)(Src + 4)));
+	__m128i B = _mm_packs_epi32(_mm_loadu_si128((__m128i const*)(Src + 8)), _mm_loadu_si128((__m128i const*)(Src + 12)));
+	return _mm_packus_epi16(A, B);
+#else
+	return _mm_packus_epi16(_mm_loadu_si128((__m128i const*)Src), _mm_loadu_si128((__m128i const*)(Src + 8)));
+#endif
+}
+
+#endif
+
+template<typename C>
+inline int __HexValue(C X) {
+	if (X >= '0' && X <= '9') return X - '0';
+	if (X >= 'A' && X <= 'F') return X - 'A' + 10;
+	if (X >= 'a' && X <= 'f') return X - 'a' + 10;
+	return -1;
+}
+
+template<typename C>
+void _HexEncode(unsigned char const *Src, size_t Len, C *Dst, bool Upper) {
+	size_t i = 0;
+#ifdef FORMAT_SSE2
+	__m128i Mask = _mm_set1_epi8(0x0F);
+	__m128i AlphaOfs = _mm_set1_epi8(Upper ? 'A' - '0' - 10 : 'a' - '0' - 10);
+	for (; i + 16 <= Len; i += 16) {
+		__m128i V = _mm_loadu_si128((__m128i const*)(Src + i));
+		__m128i Hi = __HexNibbleToDigit(_mm_and_si128(_mm_srli_epi16(V, 4), Mask), AlphaOfs);
+		__m128i Lo = __HexNibbleToDigit(_mm_and_si128(V, Mask), AlphaOfs);
+		__HexStore(Dst + i * 2, _mm_unpacklo_epi8(Hi, Lo));
+		__HexStore(Dst + i * 2 + 16, _mm_unpackhi_epi8(Hi, Lo));
+	}
+#endif
+	char const *Symbols = Upper ? __HexUpper : __HexLower;
+	for (; i < Len; i++) {
+		Dst[i * 2] = Symbols[Src[i] >> 4];
+		Dst[i * 2 + 1] = Symbols[Src[i] & 0xF];
+	}
+}
+
+template<typename C>
+size_t _HexDecode(C const *Src, size_t Len, unsigned char *Dst) {
+	size_t i = 0;
+#ifdef FORMAT_SSE2
+	for (; i + 32 <= Len; i += 32) {
+		__m128i A, B;
+		if (!__HexDigitToNibble(__HexLoad(Src + i), A) || !__HexDigitToNibble(__HexLoad(Src + i + 16), B))
+			break;
+		_mm_storeu_si128((__m128i*)(Dst + i / 2), _mm_packus_epi16(__HexNibblePairs(A), __HexNibblePairs(B)));
+	}
+#endif
+	for (; i + 2 <= Len; i += 2) {
+		int Hi = __HexValue(Src[i]);
+		if (Hi < 0) return i;
+		int Lo = __HexValue(Src[i + 1]);
+		if (Lo < 0) return i + 1;
+		Dst[i / 2] = (unsigned char)((Hi << 4) | Lo);
+	}
+	return (i < Len && __HexValue(Src[i]) >= 0) ? i + 1 : i;
+}
+
+void HexEncode(void const *Src, size_t Len, char *Dst, bool Upper) {
+	_HexEncode((unsigned char const*)Src, Len, Dst, Upper);
+}
+
+void HexEncode(void const *Src, size_t Len, wchar_t *Dst, bool Upper) {
+	_HexEncode((unsigned char const*)Src, Len, Dst, Upper);
+}
+
+size_t HexDecode(char const *Src, size_t Len, void *Dst) {
+	return _HexDecode(Src, Len, (unsigned char*)Dst);
+}
+
+size_t HexDecode(wchar_t const *Src, size_t Len, void *Dst) {
+	return _HexDecode(Src, Len, (unsigned char*)Dst);
+}
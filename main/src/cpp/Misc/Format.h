@@ -0,0 +1,246 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @addtogroup Utilities Basic Supporting Utilities
+ * @file
+ * @brief Fast type-safe string formatting
+ **/
+
+#ifndef ZWUtils_Format_H
+#define ZWUtils_Format_H
+
+ // Project global control 
+#include "Global.h"
+
+#include "TString.h"
+
+#include <algorithm>
+#include <type_traits>
+
+#define FORMAT_INLINE	128		// Characters formatted in place before spilling to heap
+
+//! Hexadecimal formatting, optionally zero-padded to a width
+struct THexFmt {
+	unsigned long long Value;
+	unsigned int Width;
+	bool Upper;
+};
+
+//! Decimal formatting, padded to a width
+struct TDecFmt {
+	unsigned long long Magnitude;
+	bool Negative;
+	unsigned int Width;
+	char Fill;
+};
+
+template<typename T>
+THexFmt FmtHex(T const &Value, unsigned int Width = 0, bool Upper = true) {
+	static_assert(std::is_integral<T>::value, "Hexadecimal formatting requires an integral value");
+	return { (unsigned long long)(typename std::make_unsigned<T>::type)Value, Width, Upper };
+}
+
+template<typename T>
+TDecFmt FmtDec(T const &Value, unsigned int Width, char Fill = '0') {
+	static_assert(std::is_integral<T>::value, "Decimal formatting requires an integral value");
+	bool Negative = std::is_signed<T>::value && ((long long)Value < 0);
+	return { Negative ? 0ULL - (unsigned long long)(long long)Value : (unsigned long long)Value, Negative, Width, Fill };
+}
+
+// Low-level formatters, the buffer must have enough space (20 for integers, FORMAT_REALLEN for reals)
+size_t __FormatDec(char *Buf, unsigned long long Value);
+size_t __FormatDec(wchar_t *Buf, unsigned long long Value);
+size_t __FormatHex(char *Buf, unsigned long long Value, unsigned int Width, bool Upper);
+size_t __FormatHex(wchar_t *Buf, unsigned long long Value, unsigned int Width, bool Upper);
+
+#define FORMAT_REALLEN	32
+size_t __FormatReal(char *Buf, double Value);
+size_t __FormatReal(wchar_t *Buf, double Value);
+
+template<typename T>
+using __FormatInteger = std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+	!std::is_same<T, char>::value && !std::is_same<T, signed char>::value && !std::is_same<T, unsigned char>::value &&
+	!std::is_same<T, wchar_t>::value && !std::is_same<T, char16_t>::value && !std::is_same<T, char32_t>::value>;
+
+/**
+ * @ingroup Utilities
+ * @brief Stream-like string builder
+ *
+ * Formats into an inline buffer, and only allocates once the output outgrows it
+ * - Unlike string streams, accepts only supported types, and no locale or manipulator state
+ * - Characters and bytes are not integers, use FmtDec / FmtHex to print their values
+ **/
+template<typename C, size_t N = FORMAT_INLINE>
+class TBasicFormat {
+	typedef TBasicFormat _this;
+	typedef std::basic_string<C> TStr;
+
+protected:
+	C _Inline[N + 1];
+	size_t _Len = 0;
+	bool _Spilled = false;
+	TStr _Spill;
+
+	C* __Reserve(size_t Count) {
+		if (!_Spilled) {
+			if (_Len + Count <= N) return _Inline + _Len;
+			_Spill.reserve((_Len + Count) * 2);
+			_Spill.assign(_Inline, _Len);
+			_Spilled = true;
+		}
+		_Spill.resize(_Len + Count);
+		return &_Spill[_Len];
+	}
+
+	void __Commit(size_t Count) {
+		_Len += Count;
+		if (_Spilled) _Spill.resize(_Len);
+	}
+
+	_this& __Pad(size_t Len, unsigned int Width, C Fill) {
+		if (Width > Len) {
+			size_t Count = Width - Len;
+			C *Buf = __Reserve(Count);
+			for (size_t i = 0; i < Count; i++) Buf[i] = Fill;
+			__Commit(Count);
+		}
+		return *this;
+	}
+
+public:
+	_this& Append(C const *Str, size_t Len) {
+		memcpy(__Reserve(Len), Str, Len * sizeof(C));
+		__Commit(Len);
+		return *this;
+	}
+
+	_this& operator<<(C Ch) {
+		*__Reserve(1) = Ch;
+		__Commit(1);
+		return *this;
+	}
+
+	_this& operator<<(C const *Str) {
+		return Str ? Append(Str, std::char_traits<C>::length(Str)) : *this;
+	}
+
+	_this& operator<<(TStr const &Str) {
+		return Append(Str.data(), Str.length());
+	}
+
+	// Strings of the other character width need an explicit conversion
+	typedef typename std::conditional<std::is_same<C, char>::value, wchar_t, char>::type _OtherChar;
+	_this& operator<<(_OtherChar const *Str) = delete;
+
+	template<typename T, typename = typename __FormatInteger<T>::type>
+	_this& operator<<(T Value) {
+		C *Buf = __Reserve(21);
+		size_t Len = 0;
+		if (std::is_signed<T>::value && Value < 0) {
+			Buf[Len++] = (C)'-';
+			Len += __FormatDec(Buf + Len, 0ULL - (unsigned long long)Value);
+		} else Len += __FormatDec(Buf + Len, (unsigned long long)Value);
+		__Commit(Len);
+		return *this;
+	}
+
+	//! Unscoped enums print as their integral promotion, scoped enums need an explicit cast
+	template<typename T, typename = typename std::enable_if<std::is_enum<T>::value &&
+		std::is_convertible<T, long long>::value>::type, typename = void>
+	_this& operator<<(T Value) {
+		return *this << +Value;
+	}
+
+	_this& operator<<(double Value) {
+		__Commit(__FormatReal(__Reserve(FORMAT_REALLEN), Value));
+		return *this;
+	}
+
+	//! Same rendering as MSVC streams (zero-padded upper-case hex)
+	_this& operator<<(void const *Ptr) {
+		__Commit(__FormatHex(__Reserve(sizeof(void*) * 2), (unsigned long long)(size_t)Ptr, sizeof(void*) * 2, true));
+		return *this;
+	}
+
+	_this& operator<<(THexFmt const &Hex) {
+		__Commit(__FormatHex(__Reserve(std::max(Hex.Width, 16U)), Hex.Value, Hex.Width, Hex.Upper));
+		return *this;
+	}
+
+	_this& operator<<(TDecFmt const &Dec) {
+		C Buf[20];
+		size_t Len = __FormatDec(Buf, Dec.Magnitude);
+		if (!Dec.Negative) return __Pad(Len, Dec.Width, (C)Dec.Fill).Append(Buf, Len);
+		// Zero padding goes between the sign and the digits, other fills go before the sign
+		C const Sign = (C)'-';
+		if (Dec.Fill == '0') Append(&Sign, 1).__Pad(Len + 1, Dec.Width, (C)Dec.Fill);
+		else __Pad(Len + 1, Dec.Width, (C)Dec.Fill).Append(&Sign, 1);
+		return Append(Buf, Len);
+	}
+
+	size_t length(void) const {
+		return _Len;
+	}
+
+	C const* c_str(void) {
+		if (_Spilled) return _Spill.c_str();
+		_Inline[_Len] = 0;
+		return _Inline;
+	}
+
+	TStr str(void) const {
+		return _Spilled ? _Spill : TStr(_Inline, _Len);
+	}
+};
+
+template<size_t N = FORMAT_INLINE>
+using TFormat = TBasicFormat<TCHAR, N>;
+
+//! Drop-in replacement of StringCast for supported types
+#define CStringFmt(exp) (TBasicFormat<char>() << exp).str()
+#define WStringFmt(exp) (TBasicFormat<wchar_t>() << exp).str()
+
+#ifdef UNICODE
+#define TStringFmt		WStringFmt
+#else
+#define TStringFmt		CStringFmt
+#endif
+
+//! Encode bytes as pairs of hex digits, destination must hold 2 * Len characters
+void HexEncode(void const *Src, size_t Len, char *Dst, bool Upper = true);
+void HexEncode(void const *Src, size_t Len, wchar_t *Dst, bool Upper = true);
+
+//! Decode pairs of hex digits into bytes, stopping at the first non-hex digit
+//! Returns the number of valid digits consumed (a trailing odd digit is not decoded)
+size_t HexDecode(char const *Src, size_t Len, void *Dst);
+size_t HexDecode(wchar_t const *Src, size_t Len, void *Dst);
+
+#endif
@@ -0,0 +1,331 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// [Utilities] Latency histogram
+
+#include "Histogram.h"
+
+#include "Debug/Exception.h"
+#include "Memory/ObjAllocator.h"
+#include "Threading/SyncObjects.h"
+
+#include <intrin.h>
+#include <cmath>
+#include <algorithm>
+
+#define HISTOGRAM_FORMAT_VERSION	1
+
+// --- THistogram
+
+static unsigned int __MSB64(UINT64 Value) {
+	unsigned long Ret;
+#ifdef _WIN64
+	_BitScanReverse64(&Ret, Value);
+#else
+	if (Value >> 32) {
+		_BitScanReverse(&Ret, (unsigned long)(Value >> 32));
+		Ret += 32;
+	} else _BitScanReverse(&Ret, (unsigned long)Value);
+#endif
+	return Ret;
+}
+
+static UINT64 __Read64(LONG64 const volatile &Value) {
+#ifdef _WIN64
+	return Value;
+#else
+	return InterlockedCompareExchange64(const_cast<LONG64 volatile*>(&Value), 0, 0);
+#endif
+}
+
+size_t THistogram::BucketOf(UINT64 Value) {
+	if (Value >> HISTOGRAM_RANGE_BITS) Value = (1ULL << HISTOGRAM_RANGE_BITS) - 1;
+	if (Value < HISTOGRAM_SUBBUCKETS) return (size_t)Value;
+	unsigned int Shift = __MSB64(Value) - HISTOGRAM_PRECISION_BITS + 1;
+	return Shift * (HISTOGRAM_SUBBUCKETS / 2) + (size_t)(Value >> Shift);
+}
+
+UINT64 THistogram::BucketLow(size_t Bucket) {
+	if (Bucket < HISTOGRAM_SUBBUCKETS) return Bucket;
+	unsigned int Shift = (unsigned int)(Bucket / (HISTOGRAM_SUBBUCKETS / 2)) - 1;
+	return (UINT64)(Bucket - Shift * (HISTOGRAM_SUBBUCKETS / 2)) << Shift;
+}
+
+UINT64 THistogram::BucketHigh(size_t Bucket) {
+	if (Bucket < HISTOGRAM_SUBBUCKETS) return Bucket;
+	unsigned int Shift = (unsigned int)(Bucket / (HISTOGRAM_SUBBUCKETS / 2)) - 1;
+	return BucketLow(Bucket) + (1ULL << Shift) - 1;
+}
+
+// Shards the current thread records into, released when the thread exits
+class TShardCache {
+public:
+	struct TEntry {
+		UINT64 ID;
+		THistogram::TShard *Shard;
+	};
+	std::vector<TEntry> Entries;
+
+	~TShardCache(void) {
+		for (auto &Entry : Entries) THistogram::__Release_Shard(Entry.Shard);
+	}
+};
+
+static thread_local TShardCache __ShardCache;
+
+// Shards of recording threads, and the counts folded from exited ones
+struct THistogram::TShardSet {
+	std::vector<TShard*> Active;
+	TShard *Overflow = nullptr;
+	TShard Retired = {};
+};
+
+class THistogram::TShards : public TSyncObj<TShardSet> {};
+
+static LONG64 volatile __NextID = 0;
+
+THistogram::THistogram(TString const &xName) :
+	_ID(InterlockedIncrement64(&__NextID)), _Shards(DEFAULT_NEW(TShards)), Name(xName) {}
+
+THistogram::~THistogram(void) {
+	{
+		auto Shards(_Shards->Pickup());
+		for (auto Shard : Shards->Active) __Release_Shard(Shard);
+		if (Shards->Overflow) __Release_Shard(Shards->Overflow);
+	}
+	DEFAULT_DESTROY(TShards, _Shards);
+}
+
+void THistogram::__Release_Shard(TShard *Shard) {
+	if (!InterlockedDecrement(&Shard->Refs)) DEFAULT_DESTROY(TShard, Shard);
+}
+
+// The last access of an exiting thread is dropping its reference, so a shard held only by us is final
+void THistogram::__Fold_Retired(TShardSet &ShardSet) {
+	auto Iter = ShardSet.Active.begin();
+	while (Iter != ShardSet.Active.end()) {
+		TShard *Shard = *Iter;
+		if (Shard->Refs != 1) {
+			Iter++;
+			continue;
+		}
+		for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) ShardSet.Retired.Counts[i] += Shard->Counts[i];
+		ShardSet.Retired.Sum += Shard->Sum;
+		__Release_Shard(Shard);
+		Iter = ShardSet.Active.erase(Iter);
+	}
+}
+
+THistogram::TShard* THistogram::__Shard(void) {
+	auto &Entries = __ShardCache.Entries;
+	for (auto &Entry : Entries)
+		if (Entry.ID == _ID) return Entry.Shard;
+
+	// First recording of this thread, drop shards of destroyed histograms on the way
+	Entries.erase(std::remove_if(Entries.begin(), Entries.end(), [](TShardCache::TEntry &Entry) {
+		if (Entry.Shard->Refs != 1) return false;
+		__Release_Shard(Entry.Shard);
+		return true;
+	}), Entries.end());
+	Entries.reserve(Entries.size() + 1);
+
+	TShard *Shard;
+	{
+		auto Shards(_Shards->Pickup());
+		__Fold_Retired(*Shards);
+		if (Shards->Active.size() < HISTOGRAM_SHARDS_MAX) {
+			Shards->Active.reserve(Shards->Active.size() + 1);
+			Shard = DEFAULT_NEW(TShard);
+			Shard->Refs = 2;
+			Shards->Active.push_back(Shard);
+		} else {
+			if (!Shards->Overflow) {
+				Shards->Overflow = DEFAULT_NEW(TShard);
+				Shards->Overflow->Refs = 1;
+			}
+			Shard = Shards->Overflow;
+			InterlockedIncrement(&Shard->Refs);
+		}
+	}
+	Entries.push_back({ _ID, Shard });
+	return Shard;
+}
+
+void THistogram::Record(long long NSec) {
+	UINT64 Value = NSec > 0 ? NSec : 0;
+	TShard *Shard = __Shard();
+	InterlockedIncrement64(&Shard->Counts[BucketOf(Value)]);
+	InterlockedExchangeAdd64(&Shard->Sum, (LONG64)Value);
+}
+
+THistogram::TSnapshot THistogram::Snapshot(void) const {
+	TSnapshot Ret;
+	auto Shards(_Shards->Pickup());
+	auto Collect = [&](TShard const &Shard) {
+		for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+			UINT64 Count = __Read64(Shard.Counts[i]);
+			Ret._Counts[i] += Count;
+			Ret._Total += Count;
+		}
+		Ret._Sum += __Read64(Shard.Sum);
+	};
+	for (auto Shard : Shards->Active) Collect(*Shard);
+	if (Shards->Overflow) Collect(*Shards->Overflow);
+	Collect(Shards->Retired);
+	return Ret;
+}
+
+void THistogram::Reset(void) {
+	auto Shards(_Shards->Pickup());
+	auto Clear = [](TShard &Shard) {
+		for (auto &Count : Shard.Counts) InterlockedExchange64(&Count, 0);
+		InterlockedExchange64(&Shard.Sum, 0);
+	};
+	for (auto Shard : Shards->Active) Clear(*Shard);
+	if (Shards->Overflow) Clear(*Shards->Overflow);
+	for (auto &Count : Shards->Retired.Counts) Count = 0;
+	Shards->Retired.Sum = 0;
+}
+
+// --- THistogram::TSnapshot
+
+THistogram::TSnapshot& THistogram::TSnapshot::Merge(_this const &xSnapshot) {
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) _Counts[i] += xSnapshot._Counts[i];
+	_Total += xSnapshot._Total;
+	_Sum += xSnapshot._Sum;
+	return *this;
+}
+
+TNSecSpan THistogram::TSnapshot::Min(void) const {
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+		if (_Counts[i]) return TNSecSpan(BucketLow(i));
+	return TNSecSpan();
+}
+
+TNSecSpan THistogram::TSnapshot::Max(void) const {
+	for (size_t i = HISTOGRAM_BUCKETS; i--;)
+		if (_Counts[i]) return TNSecSpan(BucketHigh(i));
+	return TNSecSpan();
+}
+
+TNSecSpan THistogram::TSnapshot::Mean(void) const {
+	return TNSecSpan(_Total ? _Sum / _Total : 0);
+}
+
+TNSecSpan THistogram::TSnapshot::Percentile(double Percent) const {
+	if (!_Total) return TNSecSpan();
+	Percent = std::min(std::max(Percent, 0.0), 100.0);
+	UINT64 Rank = std::max((UINT64)std::ceil(Percent / 100 * _Total), 1ULL);
+	UINT64 Seen = 0;
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		Seen += _Counts[i];
+		if (Seen >= Rank) return TNSecSpan(BucketHigh(i));
+	}
+	return Max();
+}
+
+TString THistogram::TSnapshot::toString(TimeUnit const &Unit) const {
+	if (!_Total) return _T("no samples");
+	return TStringFmt(_Total << _T(" samples, mean ") << Mean().toString(Unit)
+					  << _T(", p50 ") << Percentile(50).toString(Unit)
+					  << _T(", p90 ") << Percentile(90).toString(Unit)
+					  << _T(", p99 ") << Percentile(99).toString(Unit)
+					  << _T(", p99.9 ") << Percentile(99.9).toString(Unit)
+					  << _T(", max ") << Max().toString(Unit));
+}
+
+static void __PutVarInt(TDynBuffer &Buffer, size_t &Pos, UINT64 Value) {
+	// At most 10 bytes per 64-bit value
+	if (Pos + 10 > Buffer.GetSize() && !Buffer.SetSize(Buffer.GetSize() * 2 + 10))
+		FAIL(_T("Unable to grow histogram buffer"));
+	PBYTE Out = (PBYTE)&Buffer;
+	do {
+		BYTE Part = Value & 0x7F;
+		Value >>= 7;
+		Out[Pos++] = Value ? Part | 0x80 : Part;
+	} while (Value);
+}
+
+static UINT64 __GetVarInt(BYTE const *&Data, BYTE const *End) {
+	UINT64 Ret = 0;
+	for (unsigned int Shift = 0; Shift < 64; Shift += 7) {
+		if (Data >= End) FAIL(_T("Truncated histogram data"));
+		BYTE Part = *Data++;
+		Ret |= (UINT64)(Part & 0x7F) << Shift;
+		if (!(Part & 0x80)) return Ret;
+	}
+	FAIL(_T("Malformed histogram data"));
+}
+
+// Layout: version, precision bits, range bits, sum, then (skipped empty buckets, count) pairs
+TDynBuffer THistogram::TSnapshot::Serialize(void) const {
+	TDynBuffer Ret(64);
+	size_t Pos = 0;
+	__PutVarInt(Ret, Pos, HISTOGRAM_FORMAT_VERSION);
+	__PutVarInt(Ret, Pos, HISTOGRAM_PRECISION_BITS);
+	__PutVarInt(Ret, Pos, HISTOGRAM_RANGE_BITS);
+	__PutVarInt(Ret, Pos, _Sum);
+	size_t Skipped = 0;
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		if (!_Counts[i]) {
+			Skipped++;
+			continue;
+		}
+		__PutVarInt(Ret, Pos, Skipped);
+		__PutVarInt(Ret, Pos, _Counts[i]);
+		Skipped = 0;
+	}
+	Ret.SetSize(Pos);
+	return Ret;
+}
+
+THistogram::TSnapshot THistogram::TSnapshot::Deserialize(void const *Data, size_t Size) {
+	BYTE const *Ptr = (BYTE const*)Data;
+	BYTE const *End = Ptr + Size;
+	UINT64 Version = __GetVarInt(Ptr, End);
+	if (Version != HISTOGRAM_FORMAT_VERSION)
+		FAIL(_T("Unsupported histogram format version %llu"), Version);
+	UINT64 PrecisionBits = __GetVarInt(Ptr, End);
+	UINT64 RangeBits = __GetVarInt(Ptr, End);
+	if (PrecisionBits != HISTOGRAM_PRECISION_BITS || RangeBits != HISTOGRAM_RANGE_BITS)
+		FAIL(_T("Incompatible histogram layout (precision %llu, range %llu)"), PrecisionBits, RangeBits);
+
+	_this Ret;
+	Ret._Sum = __GetVarInt(Ptr, End);
+	size_t Bucket = 0;
+	while (Ptr < End) {
+		Bucket += (size_t)__GetVarInt(Ptr, End);
+		if (Bucket >= HISTOGRAM_BUCKETS) FAIL(_T("Histogram bucket out of range"));
+		UINT64 Count = __GetVarInt(Ptr, End);
+		Ret._Counts[Bucket++] = Count;
+		Ret._Total += Count;
+	}
+	return Ret;
+}
@@ -0,0 +1,214 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @addtogroup Utilities Basic Supporting Utilities
+ * @file
+ * @brief Latency histogram
+ **/
+
+#ifndef ZWUtils_Histogram_H
+#define ZWUtils_Histogram_H
+
+ // Project global control 
+#include "Global.h"
+
+#include "TString.h"
+#include "Timing.h"
+
+#include "Memory/Resource.h"
+
+#include <vector>
+
+// Linear sub-buckets per power of 2 = 2^bits, relative error <= 2^-(bits-1)
+#define HISTOGRAM_PRECISION_BITS	6
+// Largest distinguishable value = 2^bits - 1 nanoseconds (~4.9 hours), larger values saturate
+#define HISTOGRAM_RANGE_BITS		44
+#define HISTOGRAM_SUBBUCKETS		(1 << HISTOGRAM_PRECISION_BITS)
+#define HISTOGRAM_BUCKETS			((HISTOGRAM_RANGE_BITS - HISTOGRAM_PRECISION_BITS + 2) * (HISTOGRAM_SUBBUCKETS / 2))
+// Threads with a shard of their own (~10KB each), further threads share one
+#define HISTOGRAM_SHARDS_MAX		8
+
+/**
+ * @ingroup Utilities
+ * @brief Log-linear (HDR) latency histogram
+ *
+ * Values are nanosecond counts, grouped into buckets of constant relative width.
+ * Each recording thread updates its own shard with two uncontended interlocked adds (bucket and sum),
+ *  so recording never touches cache lines of other recording threads; readers merge the shards into a snapshot.
+ * Only the first recording of a thread takes a lock, to register its shard;
+ *  shards of exited threads are folded into a common one at that point.
+ * Shards are allocated on the first recording of a thread, and at most HISTOGRAM_SHARDS_MAX of them;
+ *  further threads record into a shared overflow shard, at the cost of contended adds.
+ **/
+class THistogram {
+	typedef THistogram _this;
+
+public:
+	/**
+	 * Merged, immutable view of the bucket counts
+	 **/
+	class TSnapshot {
+		typedef TSnapshot _this;
+		friend class THistogram;
+
+	protected:
+		std::vector<UINT64> _Counts;
+		UINT64 _Total = 0;
+		UINT64 _Sum = 0;
+
+	public:
+		TSnapshot(void) : _Counts(HISTOGRAM_BUCKETS, 0) {}
+
+		UINT64 Count(void) const {
+			return _Total;
+		}
+
+		/**
+		 * Add all samples of another snapshot
+		 **/
+		_this& Merge(_this const &xSnapshot);
+
+		TNSecSpan Min(void) const;
+		TNSecSpan Max(void) const;
+		TNSecSpan Mean(void) const;
+
+		/**
+		 * Get the value at or below which the given percent of samples fall
+		 * @note Reported as the highest value equivalent to the containing bucket
+		 **/
+		TNSecSpan Percentile(double Percent) const;
+
+		TString toString(TimeUnit const &Unit = TimeUnit::USEC) const;
+
+		/**
+		 * Encode as run-length compressed variable-length integers
+		 **/
+		TDynBuffer Serialize(void) const;
+		static _this Deserialize(void const *Data, size_t Size);
+	};
+
+	/**
+	 * Record the lifetime of the scope (or from Start() on), nothing if the histogram is null
+	 **/
+	class TScopedTimer {
+		typedef TScopedTimer _this;
+
+	protected:
+		THistogram *_Histogram;
+		TMonotonicStamp _Start;
+
+	public:
+		TScopedTimer(THistogram *Histogram = nullptr) :
+			_Histogram(Histogram), _Start(Histogram ? TMonotonicStamp::Now() : TMonotonicStamp()) {}
+
+		/**
+		 * Start timing from now, for a timer constructed without a histogram
+		 **/
+		void Start(THistogram *Histogram) {
+			_Histogram = Histogram;
+			if (Histogram) _Start = TMonotonicStamp::Now();
+		}
+
+		bool Started(void) const {
+			return _Histogram != nullptr;
+		}
+
+		~TScopedTimer(void) {
+			if (_Histogram) _Histogram->Record(TMonotonicStamp::Now().Since(_Start));
+		}
+
+		TScopedTimer(_this const &) = delete;
+		_this& operator=(_this const &) = delete;
+	};
+
+protected:
+	struct TShard {
+		LONG64 volatile Counts[HISTOGRAM_BUCKETS];
+		LONG64 volatile Sum;
+		// Held by the histogram and by the recording thread, whichever lets go last frees it
+		LONG volatile Refs;
+	};
+	friend class TShardCache;
+
+	// Defined with the implementation, keeps this header free of threading dependencies
+	struct TShardSet;
+	class TShards;
+
+	// Histogram addresses may be reused, threads identify their shards by a unique ID
+	UINT64 const _ID;
+	TShards * const _Shards;
+
+	TShard* __Shard(void);
+	static void __Fold_Retired(TShardSet &ShardSet);
+	static void __Release_Shard(TShard *Shard);
+
+public:
+	TString const Name;
+
+	THistogram(TString const &xName = EMPTY_TSTRING());
+	~THistogram(void);
+
+	// Recording threads may hold on to the shards
+	THistogram(_this const &) = delete;
+	THistogram(_this &&) = delete;
+	_this& operator=(_this const &) = delete;
+	_this& operator=(_this &&) = delete;
+
+	static size_t BucketOf(UINT64 Value);
+	static UINT64 BucketLow(size_t Bucket);
+	static UINT64 BucketHigh(size_t Bucket);
+
+	/**
+	 * Record a value in nanoseconds, negative values count as zero
+	 **/
+	void Record(long long NSec);
+
+	template<TimeUnit U>
+	void Record(TTypedSpan<U> const &Span) {
+		Record(TNSecSpan(Span).Count());
+	}
+
+	void Record(TimeSpan const &Span) {
+		Record(Span.GetValue(TimeUnit::NSEC));
+	}
+
+	/**
+	 * Merge all shards, concurrent recordings may be partially included
+	 **/
+	TSnapshot Snapshot(void) const;
+
+	/**
+	 * Clear all counts, concurrent recordings may be lost
+	 **/
+	void Reset(void);
+};
+
+#endif //ZWUtils_Histogram_H
@@ -39,6 +39,22 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <Windows.h>
 #endif
 
+#include <cwchar>
+
+#if defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define UTF_SSE2
+#include <emmintrin.h>
+#endif
+
+#if WCHAR_MAX > 0xFFFF
+#define UTF_WCHAR32
+#define UTF8_MAXPERUNIT		4
+#else
+#define UTF8_MAXPERUNIT		3
+#endif
+
+#define UTF_NOERROR			((size_t)-1)
+
 CString const& EMPTY_CSTRING(void) {
 	static CString const __IoFU(EmptyAText);
 	return __IoFU;
@@ -49,6 +65,155 @@ WString const& EMPTY_WSTRING(void) {
 	return __IoFU;
 }
 
+//
+// Native UTF-8 transcoder
+// - wchar_t is treated as UTF-16 (Windows) or UTF-32 (Linux)
+// - Runs of ASCII are converted 16 code units at a time when SSE2 is available
+// - Destination buffers are sized for the worst case, so conversion is done in one pass
+//
+
+#ifdef UTF_SSE2
+
+// Narrow 16 wide chars to bytes, fails if any of them is not ASCII
+inline bool __ASCIIBlockNarrow(wchar_t const *Src, unsigned char *Dst) {
+#ifdef UTF_WCHAR32
+	__m128i A = _mm_loadu_si128((__m128i const*)Src);
+	__m128i B = _mm_loadu_si128((__m128i const*)(Src + 4));
+	__m128i C = _mm_loadu_si128((__m128i const*)(Src + 8));
+	__m128i D = _mm_loadu_si128((__m128i const*)(Src + 12));
+	__m128i High = _mm_and_si128(_mm_or_si128(_mm_or_si128(A, B), _mm_or_si128(C, D)), _mm_set1_epi32((int)0xFFFFFF80));
+	if (_mm_movemask_epi8(_mm_cmpeq_epi32(High, _mm_setzero_si128())) != 0xFFFF) return false;
+	_mm_storeu_si128((__m128i*)Dst, _mm_packus_epi16(_mm_packs_epi32(A, B), _mm_packs_epi32(C, D)));
+#else
+	__m128i A = _mm_loadu_si128((__m128i const*)Src);
+	__m128i B = _mm_loadu_si128((__m128i const*)(Src + 8));
+	__m128i High = _mm_and_si128(_mm_or_si128(A, B), _mm_set1_epi16((short)0xFF80));
+	if (_mm_movemask_epi8(_mm_cmpeq_epi16(High, _mm_setzero_si128())) != 0xFFFF) return false;
+	_mm_storeu_si128((__m128i*)Dst, _mm_packus_epi16(A, B));
+#endif
+	return true;
+}
+
+// Widen 16 bytes to wide chars, fails if any of them is not ASCII
+inline bool __ASCIIBlockWiden(unsigned char const *Src, wchar_t *Dst) {
+	__m128i A = _mm_loadu_si128((__m128i const*)Src);
+	if (_mm_movemask_epi8(A) != 0) return false;
+	__m128i Zero = _mm_setzero_si128();
+	__m128i L = _mm_unpacklo_epi8(A, Zero);
+	__m128i H = _mm_unpackhi_epi8(A, Zero);
+#ifdef UTF_WCHAR32
+	_mm_storeu_si128((__m128i*)Dst, _mm_unpacklo_epi16(L, Zero));
+	_mm_storeu_si128((__m128i*)(Dst + 4), _mm_unpackhi_epi16(L, Zero));
+	_mm_storeu_si128((__m128i*)(Dst + 8), _mm_unpacklo_epi16(H, Zero));
+	_mm_storeu_si128((__m128i*)(Dst + 12), _mm_unpackhi_epi16(H, Zero));
+#else
+	_mm_storeu_si128((__m128i*)Dst, L);
+	_mm_storeu_si128((__m128i*)(Dst + 8), H);
+#endif
+	return true;
+}
+
+#endif
+
+// Encode wide chars into UTF-8, destination must hold UTF8_MAXPERUNIT bytes per source unit
+// Ill-formed code units are replaced with U+FFFD, and the first offending offset is reported
+static size_t __UTF8Encode(wchar_t const *Src, size_t Len, char *Dst, size_t &BadPos) {
+	unsigned char *Out = (unsigned char*)Dst;
+	size_t Idx = 0;
+	BadPos = UTF_NOERROR;
+	while (Idx < Len) {
+#ifdef UTF_SSE2
+		while ((Idx + 16 <= Len) && __ASCIIBlockNarrow(Src + Idx, Out)) {
+			Idx += 16; Out += 16;
+		}
+		if (Idx >= Len) break;
+#endif
+		unsigned int CP = (unsigned int)Src[Idx++];
+		if (CP < 0x80) {
+			*Out++ = (unsigned char)CP;
+			continue;
+		}
+		if (CP < 0x800) {
+			*Out++ = (unsigned char)(0xC0 | (CP >> 6));
+			*Out++ = (unsigned char)(0x80 | (CP & 0x3F));
+			continue;
+		}
+#ifdef UTF_WCHAR32
+		bool Valid = (CP < 0xD800) || ((CP > 0xDFFF) && (CP <= 0x10FFFF));
+#else
+		bool Valid = (CP & 0xF800) != 0xD800;
+		if (!Valid && (CP < 0xDC00) && (Idx < Len) && ((Src[Idx] & 0xFC00) == 0xDC00)) {
+			CP = 0x10000 + ((CP - 0xD800) << 10) + ((unsigned int)Src[Idx++] - 0xDC00);
+			Valid = true;
+		}
+#endif
+		if (!Valid) {
+			if (BadPos == UTF_NOERROR) BadPos = Idx - 1;
+			CP = 0xFFFD;
+		}
+		if (CP < 0x10000) {
+			*Out++ = (unsigned char)(0xE0 | (CP >> 12));
+		} else {
+			*Out++ = (unsigned char)(0xF0 | (CP >> 18));
+			*Out++ = (unsigned char)(0x80 | ((CP >> 12) & 0x3F));
+		}
+		*Out++ = (unsigned char)(0x80 | ((CP >> 6) & 0x3F));
+		*Out++ = (unsigned char)(0x80 | (CP & 0x3F));
+	}
+	return Out - (unsigned char*)Dst;
+}
+
+// Decode UTF-8 into wide chars, destination must hold one unit per source byte
+// Conversion stops at the first ill-formed sequence (overlong, surrogate, out of range or truncated)
+static size_t __UTF8Decode(char const *Src, size_t Len, wchar_t *Dst, size_t &BadPos) {
+	unsigned char const *In = (unsigned char const*)Src;
+	wchar_t *Out = Dst;
+	size_t Idx = 0;
+	BadPos = UTF_NOERROR;
+	while (Idx < Len) {
+#ifdef UTF_SSE2
+		while ((Idx + 16 <= Len) && __ASCIIBlockWiden(In + Idx, Out)) {
+			Idx += 16; Out += 16;
+		}
+		if (Idx >= Len) break;
+#endif
+		unsigned int CP = In[Idx];
+		if (CP < 0x80) {
+			*Out++ = (wchar_t)CP;
+			Idx++;
+			continue;
+		}
+		size_t Trail;
+		unsigned int Min;
+		if ((CP & 0xE0) == 0xC0) {
+			Trail = 1; Min = 0x80; CP &= 0x1F;
+		} else if ((CP & 0xF0) == 0xE0) {
+			Trail = 2; Min = 0x800; CP &= 0x0F;
+		} else if ((CP & 0xF8) == 0xF0) {
+			Trail = 3; Min = 0x10000; CP &= 0x07;
+		} else break;
+		if (Len - Idx <= Trail) break;
+		size_t i = 1;
+		for (; i <= Trail; i++) {
+			unsigned int Cont = In[Idx + i];
+			if ((Cont & 0xC0) != 0x80) break;
+			CP = (CP << 6) | (Cont & 0x3F);
+		}
+		if ((i <= Trail) || (CP < Min) || (CP > 0x10FFFF) || ((CP >= 0xD800) && (CP <= 0xDFFF))) break;
+		Idx += Trail + 1;
+#ifndef UTF_WCHAR32
+		if (CP >= 0x10000) {
+			CP -= 0x10000;
+			*Out++ = (wchar_t)(0xD800 + (CP >> 10));
+			CP = 0xDC00 + (CP & 0x3FF);
+		}
+#endif
+		*Out++ = (wchar_t)CP;
+	}
+	if (Idx < Len) BadPos = Idx;
+	return Out - Dst;
+}
+
 CString WStringtoCString(unsigned int CodePage, WString const &Str, TString &ErrMessage) {
 	ErrMessage.clear();
 
@@ -56,16 +221,19 @@ CString WStringtoCString(unsigned int CodePage, WString const &Str, TString &Err
 		return EMPTY_CSTRING();
 
 #ifdef WINDOWS
+	if (CodePage == CP_UTF8)
+		return std::move(WStringtoUTF8(Str, ErrMessage));
+
 	DWORD dwConversionFlags = 0;
 #if (WINVER >= 0x0600)
-	// Only applicable to UTF-8 and GB18030
-	if ((CodePage == CP_UTF8) || (CodePage == 54936))
+	// Only applicable to GB18030 (UTF-8 is handled natively)
+	if (CodePage == 54936)
 		dwConversionFlags = WC_ERR_INVALID_CHARS;
 #endif
 	BOOL IsDefaultCharUsed = FALSE;
 	LPBOOL UsedDefaultChar = &IsDefaultCharUsed;
-	// Not supported by UTF-7 or UTF-8
-	if ((CodePage == CP_UTF7) || (CodePage == CP_UTF8))
+	// Not supported by UTF-7
+	if (CodePage == CP_UTF7)
 		UsedDefaultChar = NULL;
 
 	// Get size of destination UTF-8 buffer, in CHAR's (= bytes)
@@ -82,8 +250,8 @@ CString WStringtoCString(unsigned int CodePage, WString const &Str, TString &Err
 	if (cbCP == 0) {
 		DWORD ErrCode = GetLastError();
 #if (WINVER >= 0x0600)
-		// Only applicable to UTF-8 and GB18030
-		if (((CodePage == CP_UTF8) || (CodePage == 54936)) && (ErrCode == ERROR_NO_UNICODE_TRANSLATION)) {
+		// Only applicable to GB18030
+		if ((CodePage == 54936) && (ErrCode == ERROR_NO_UNICODE_TRANSLATION)) {
 			DecodeSysError(ErrCode, ErrMessage);
 			// Retry with less strict conversion behavior
 			cbCP = WideCharToMultiByte(
@@ -135,6 +303,9 @@ WString CStringtoWString(UINT CodePage, CString const &Str) {
 		return EMPTY_WSTRING();
 
 #ifdef WINDOWS
+	if (CodePage == CP_UTF8)
+		return std::move(UTF8toWString(Str));
+
 	//
 	// Get size of destination UTF-16 buffer, in WCHAR's
 	//
@@ -175,18 +346,36 @@ WString CStringtoWString(UINT CodePage, CString const &Str) {
 
 CString WStringtoUTF8(WString const &Str) {
 	TString ErrMessage;
-	CString Ret = WStringtoCString(CP_UTF8, Str, ErrMessage);
+	CString Ret = WStringtoUTF8(Str, ErrMessage);
 	if (!ErrMessage.empty())
 		FAIL(_T("Unsafe conversion from unicode to UTF-8 - %s"), ErrMessage.c_str());
 	return std::move(Ret);
 }
 
 CString WStringtoUTF8(WString const &Str, TString &ErrMessage) {
-	return std::move(WStringtoCString(CP_UTF8, Str, ErrMessage));
+	ErrMessage.clear();
+
+	if (Str.length() == 0)
+		return EMPTY_CSTRING();
+
+	size_t BadPos;
+	CString Ret(Str.length() * UTF8_MAXPERUNIT, NullAChar);
+	Ret.resize(__UTF8Encode(Str.data(), Str.length(), &Ret.front(), BadPos));
+	if (BadPos != UTF_NOERROR)
+		ErrMessage = TStringFmt(_T("Ill-formed unicode code unit at offset ") << BadPos << _T(", replaced with U+FFFD"));
+	return std::move(Ret);
 }
 
 WString UTF8toWString(CString const &Str) {
-	return std::move(CStringtoWString(CP_UTF8, Str));
+	if (Str.length() == 0)
+		return EMPTY_WSTRING();
+
+	size_t BadPos;
+	WString Ret(Str.length(), NullWChar);
+	Ret.resize(__UTF8Decode(Str.data(), Str.length(), &Ret.front(), BadPos));
+	if (BadPos != UTF_NOERROR)
+		FAIL(_T("Ill-formed UTF-8 sequence at offset %llu"), (unsigned long long)BadPos);
+	return std::move(Ret);
 }
 
 void TrimString(CString &Str) {
@@ -216,7 +405,7 @@ void TrimString(WString &Str) {
 #ifdef WINDOWS
 
 TCHAR const* ACP_LOCALE(void) {
-	static TString __IoFU(TStringCast('.' << GetACP()));
+	static TString __IoFU(TStringFmt(_T('.') << GetACP()));
 	return __IoFU.c_str();
 }
 
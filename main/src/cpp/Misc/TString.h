@@ -130,8 +130,16 @@ CString WStringtoCString(unsigned int CodePage, WString const &Str, TString &Err
 //! Convert string of a given code page to wide string
 WString CStringtoWString(unsigned int CodePage, CString const &Str);
 
+//! @ingroup Utilities
+//! Convert wide string (UTF-16 or UTF-32) to UTF-8, ill-formed code units raise exception
 CString WStringtoUTF8(WString const &Str);
+
+//! @ingroup Utilities
+//! Convert wide string (UTF-16 or UTF-32) to UTF-8, ill-formed code units are replaced with U+FFFD
 CString WStringtoUTF8(WString const &Str, TString &ErrMessage);
+
+//! @ingroup Utilities
+//! Convert UTF-8 string to wide string, ill-formed sequences raise exception
 WString UTF8toWString(CString const &Str);
 
 #ifdef UNICODE
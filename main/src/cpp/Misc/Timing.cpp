@@ -31,6 +31,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // [Utilities] Timing support
 
 #include "Timing.h"
+#include "Format.h"
 
 #include "Debug/Exception.h"
 
@@ -38,8 +39,6 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <Windows.h>
 #endif
 
-#include <iomanip>
-
 // --- TimeSpan
 
 TimeSpan const TimeSpan::Null;
@@ -106,10 +105,10 @@ TString TimeStamp::toString(TimeUnit const &Resolution) const {
 	SYSTEMTIME SystemTime;
 	FileTimeToSystemTime((FILETIME*)&Value.U64, &SystemTime);
 
-	TStringStream StrBuf;
-	StrBuf << std::setw(4) << SystemTime.wYear
-		<< _T('/') << std::setw(2) << std::setfill(_T('0')) << SystemTime.wMonth
-		<< _T('/') << std::setw(2) << std::setfill(_T('0')) << SystemTime.wDay;
+	TFormat<> StrBuf;
+	StrBuf << FmtDec(SystemTime.wYear, 4, ' ')
+		<< _T('/') << FmtDec(SystemTime.wMonth, 2)
+		<< _T('/') << FmtDec(SystemTime.wDay, 2);
 	switch (Resolution) {
 		case TimeUnit::DAY: break;
 		case TimeUnit::HR:
@@ -118,12 +117,12 @@ TString TimeStamp::toString(TimeUnit const &Resolution) const {
 		case TimeUnit::MIN:
 		case TimeUnit::SEC:
 		case TimeUnit::MSEC:
-			StrBuf << _T(' ') << std::setw(2) << std::setfill(_T('0')) << SystemTime.wHour;
-			StrBuf << _T(':') << std::setw(2) << std::setfill(_T('0')) << SystemTime.wMinute;
+			StrBuf << _T(' ') << FmtDec(SystemTime.wHour, 2);
+			StrBuf << _T(':') << FmtDec(SystemTime.wMinute, 2);
 			if ((Resolution == TimeUnit::HR) || (Resolution == TimeUnit::MIN)) break;
-			StrBuf << _T(':') << std::setw(2) << std::setfill(_T('0')) << SystemTime.wSecond;
+			StrBuf << _T(':') << FmtDec(SystemTime.wSecond, 2);
 			if (Resolution == TimeUnit::SEC) break;
-			StrBuf << _T('.') << std::setw(3) << std::setfill(_T('0')) << SystemTime.wMilliseconds;
+			StrBuf << _T('.') << FmtDec(SystemTime.wMilliseconds, 3);
 			break;
 		default:
 			FAIL(_T("Unrecognized time-unit resolution"));
@@ -148,4 +147,77 @@ TimeStamp TimeStamp::Now(TimeSpan const &Offset) {
 	TimeStamp Ret(FileTime);
 	return Offset ? Ret.Offset(Offset) : Ret;
 #endif
+}
+
+// --- TTimeStampFormatter
+
+#define HNSEC_PER_SEC	((long long)TimeUnit::SEC / (long long)TimeUnit::HNSEC)
+#define HNSEC_PER_MSEC	((long long)TimeUnit::MSEC / (long long)TimeUnit::HNSEC)
+
+PCTCHAR TTimeStampFormatter::Format(TimeStamp const &Stamp) {
+	long long Value = Stamp.MSWINTS();
+	long long Second = Value / HNSEC_PER_SEC;
+	if (Second != _Second) {
+#ifdef WINDOWS
+		ULARGE_INTEGER SecondValue;
+		SecondValue.QuadPart = Second * HNSEC_PER_SEC;
+		FILETIME FileTime = { SecondValue.LowPart, SecondValue.HighPart };
+		SYSTEMTIME SystemTime;
+		FileTimeToSystemTime(&FileTime, &SystemTime);
+		_sntprintf_s(_Text, _TRUNCATE, _T("%4d/%02d/%02d %02d:%02d:%02d."),
+					 SystemTime.wYear, SystemTime.wMonth, SystemTime.wDay,
+					 SystemTime.wHour, SystemTime.wMinute, SystemTime.wSecond);
+#endif
+		_Second = Second;
+	}
+	unsigned int MSec = (unsigned int)(Value % HNSEC_PER_SEC / HNSEC_PER_MSEC);
+	_Text[20] = _T('0') + MSec / 100;
+	_Text[21] = _T('0') + MSec / 10 % 10;
+	_Text[22] = _T('0') + MSec % 10;
+	_Text[23] = NullTChar;
+	return _Text;
+}
+
+// --- TMonotonicStamp
+
+#define NSEC_PER_SEC	((long long)TimeUnit::SEC)
+
+long long TMonotonicStamp::Frequency(void) {
+#ifdef WINDOWS
+	static long long const __IoFU = [] {
+		LARGE_INTEGER iRet;
+		QueryPerformanceFrequency(&iRet);
+		return iRet.QuadPart;
+	}();
+	return __IoFU;
+#endif
+}
+
+TimeSpan TMonotonicStamp::toSpan(long long const &Ticks) {
+	return toNSec(Ticks);
+}
+
+TNSecSpan TMonotonicStamp::toNSec(long long const &Ticks) {
+	long long Freq = Frequency();
+	// Split to avoid overflow on long durations
+	return TNSecSpan(Ticks / Freq * NSEC_PER_SEC + Ticks % Freq * NSEC_PER_SEC / Freq);
+}
+
+long long TMonotonicStamp::toTicks(TimeSpan const &Span) {
+	return toTicks(TNSecSpan(Span));
+}
+
+long long TMonotonicStamp::toTicks(TNSecSpan const &Span) {
+	long long Freq = Frequency();
+	long long NSec = Span.Count();
+	return NSec / NSEC_PER_SEC * Freq + NSec % NSEC_PER_SEC * Freq / NSEC_PER_SEC;
+}
+
+TMonotonicStamp TMonotonicStamp::Now(TimeSpan const &Offset) {
+#ifdef WINDOWS
+	LARGE_INTEGER Counter;
+	QueryPerformanceCounter(&Counter);
+	_this Ret(Counter.QuadPart);
+	return Offset ? Ret.Offset(Offset) : Ret;
+#endif
 }
\ No newline at end of file
@@ -47,6 +47,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Units.h"
 
 #include <algorithm>
+#include <type_traits>
 
 // Value = Second offset
 enum class TimeSystem : unsigned long long {
@@ -156,6 +157,140 @@ public:
 	}
 };
 
+/**
+ * Time span with a compile-time unit
+ * - Arithmetic and comparisons are plain integer operations, usable in constant expressions
+ * - Implicitly widens to finer units and to TimeSpan without loss;
+ *   narrowing to a coarser unit is explicit via Truncate() / Ceil()
+ **/
+template<TimeUnit U>
+class TTypedSpan {
+	typedef TTypedSpan _this;
+
+	template<TimeUnit>
+	friend class TTypedSpan;
+
+protected:
+	long long Value;
+
+	static constexpr long long __Ratio(TimeUnit const &From, TimeUnit const &To) {
+		return (long long)((unsigned long long)From / (unsigned long long)To);
+	}
+
+public:
+	static constexpr TimeUnit Unit = U;
+
+	constexpr explicit TTypedSpan(long long const &xValue = 0) : Value(xValue) {}
+
+	template<TimeUnit V, typename = std::enable_if_t<(V >= U)>>
+	constexpr TTypedSpan(TTypedSpan<V> const &xSpan) : Value(xSpan.Value * __Ratio(V, U)) {}
+
+	explicit TTypedSpan(TimeSpan const &xSpan) : Value(xSpan.GetValue(U)) {}
+
+	operator TimeSpan() const {
+		return { Value, U };
+	}
+
+	constexpr long long Count(void) const {
+		return Value;
+	}
+
+	// Convert to a coarser unit, rounding toward zero
+	template<TimeUnit V>
+	constexpr TTypedSpan<V> Truncate(void) const {
+		static_assert(V >= U, "Use implicit conversion to a finer unit");
+		return TTypedSpan<V>(Value / __Ratio(V, U));
+	}
+
+	// Convert to a coarser unit, rounding away from zero
+	template<TimeUnit V>
+	constexpr TTypedSpan<V> Ceil(void) const {
+		static_assert(V >= U, "Use implicit conversion to a finer unit");
+		return TTypedSpan<V>((Value + (Value < 0 ? 1 - __Ratio(V, U) : __Ratio(V, U) - 1)) / __Ratio(V, U));
+	}
+
+	TString toString(TimeUnit const &xUnit, bool Abbrv = true, bool OmitPlus = true) const {
+		return TimeSpan(*this).toString(xUnit, Abbrv, OmitPlus);
+	}
+
+	constexpr _this operator-(void) const {
+		return _this(-Value);
+	}
+
+	constexpr _this operator+(_this const &xSpan) const {
+		return _this(Value + xSpan.Value);
+	}
+
+	constexpr _this operator-(_this const &xSpan) const {
+		return _this(Value - xSpan.Value);
+	}
+
+	constexpr _this operator*(long long const &Factor) const {
+		return _this(Value * Factor);
+	}
+
+	constexpr _this operator/(long long const &Divisor) const {
+		return _this(Value / Divisor);
+	}
+
+	constexpr long long operator/(_this const &xSpan) const {
+		return Value / xSpan.Value;
+	}
+
+	_this& operator+=(_this const &xSpan) {
+		return Value += xSpan.Value, *this;
+	}
+
+	_this& operator-=(_this const &xSpan) {
+		return Value -= xSpan.Value, *this;
+	}
+
+	constexpr bool Positive(void) const {
+		return Value > 0;
+	}
+
+	constexpr bool Negative(void) const {
+		return Value < 0;
+	}
+
+	constexpr bool operator==(_this const &xSpan) const {
+		return Value == xSpan.Value;
+	}
+
+	constexpr bool operator!=(_this const &xSpan) const {
+		return Value != xSpan.Value;
+	}
+
+	constexpr bool operator<(_this const &xSpan) const {
+		return Value < xSpan.Value;
+	}
+
+	constexpr bool operator>(_this const &xSpan) const {
+		return Value > xSpan.Value;
+	}
+
+	constexpr bool operator<=(_this const &xSpan) const {
+		return Value <= xSpan.Value;
+	}
+
+	constexpr bool operator>=(_this const &xSpan) const {
+		return Value >= xSpan.Value;
+	}
+
+	constexpr explicit operator bool() const {
+		return Value != 0;
+	}
+};
+
+template<TimeUnit U>
+constexpr TimeUnit TTypedSpan<U>::Unit;
+
+typedef TTypedSpan<TimeUnit::NSEC> TNSecSpan;
+typedef TTypedSpan<TimeUnit::HNSEC> THNSecSpan;
+typedef TTypedSpan<TimeUnit::USEC> TUSecSpan;
+typedef TTypedSpan<TimeUnit::MSEC> TMSecSpan;
+typedef TTypedSpan<TimeUnit::SEC> TSecSpan;
+
 class TimeStamp {
 	typedef TimeStamp _this;
 
@@ -273,6 +408,153 @@ public:
 	static _this Now(TimeSpan const &Offset = TimeSpan::Null);
 };
 
+/**
+ * Incremental time stamp formatter, renders the same text as TimeStamp::toString(TimeUnit::MSEC)
+ * - Caches the date and time up to the second, so only the millisecond digits are re-rendered
+ *   for stamps within the same second as the previous one
+ * - Not thread-safe, use one instance per thread
+ **/
+class TTimeStampFormatter {
+	typedef TTimeStampFormatter _this;
+
+protected:
+	long long _Second = -1;
+	// "YYYY/MM/DD HH:MM:SS.mmm"
+	TCHAR _Text[24];
+
+public:
+	/**
+	 * Format a time stamp, the text is valid until the next call
+	 **/
+	PCTCHAR Format(TimeStamp const &Stamp);
+};
+
+/**
+ * Monotonic time stamp on the high-resolution performance counter
+ * - Not affected by wall clock adjustments, only comparable with other monotonic stamps
+ * - Differences convert to TimeSpan at nanosecond resolution
+ **/
+class TMonotonicStamp {
+	typedef TMonotonicStamp _this;
+
+protected:
+	long long Ticks;
+
+public:
+	explicit TMonotonicStamp(long long const &xTicks = 0) : Ticks(xTicks) {}
+
+	long long GetTicks(void) const {
+		return Ticks;
+	}
+
+	bool At(_this const &TS) const {
+		return Ticks == TS.Ticks;
+	}
+
+	bool Before(_this const &TS) const {
+		return Ticks < TS.Ticks;
+	}
+
+	bool After(_this const &TS) const {
+		return Ticks > TS.Ticks;
+	}
+
+	bool operator==(_this const &TS) const {
+		return At(TS);
+	}
+
+	bool operator!=(_this const &TS) const {
+		return !At(TS);
+	}
+
+	bool operator<(_this const &TS) const {
+		return Before(TS);
+	}
+
+	bool operator>(_this const &TS) const {
+		return After(TS);
+	}
+
+	bool operator<=(_this const &TS) const {
+		return !After(TS);
+	}
+
+	bool operator>=(_this const &TS) const {
+		return !Before(TS);
+	}
+
+	_this Offset(TimeSpan const &Ofs) const {
+		return _this(Ticks + toTicks(Ofs));
+	}
+
+	template<TimeUnit U>
+	_this Offset(TTypedSpan<U> const &Ofs) const {
+		return _this(Ticks + toTicks(TNSecSpan(Ofs)));
+	}
+
+	_this operator+(TimeSpan const &Ofs) const {
+		return Offset(Ofs);
+	}
+
+	_this operator-(TimeSpan const &Ofs) const {
+		return Offset(-Ofs);
+	}
+
+	template<TimeUnit U>
+	_this operator+(TTypedSpan<U> const &Ofs) const {
+		return Offset(Ofs);
+	}
+
+	template<TimeUnit U>
+	_this operator-(TTypedSpan<U> const &Ofs) const {
+		return Offset(-Ofs);
+	}
+
+	_this& operator+=(TimeSpan const &Ofs) {
+		return *this = *this + Ofs;
+	}
+
+	_this& operator-=(TimeSpan const &Ofs) {
+		return *this += -Ofs;
+	}
+
+	TimeSpan From(_this const &xStamp) const {
+		return toSpan(Ticks - xStamp.Ticks);
+	}
+
+	/**
+	 * Same as From(), but in integer nanoseconds
+	 **/
+	TNSecSpan Since(_this const &xStamp) const {
+		return toNSec(Ticks - xStamp.Ticks);
+	}
+
+	TimeSpan To(_this const &xStamp) const {
+		return xStamp.From(*this);
+	}
+
+	TimeSpan operator-(_this const &xStamp) const {
+		return From(xStamp);
+	}
+
+	operator bool() const {
+		return Ticks != 0;
+	}
+
+	/**
+	 * Get the number of counter ticks per second
+	 **/
+	static long long Frequency(void);
+
+	// Conversion between counter ticks and time spans, truncated toward zero
+	static TimeSpan toSpan(long long const &Ticks);
+	static TNSecSpan toNSec(long long const &Ticks);
+	static long long toTicks(TimeSpan const &Span);
+	static long long toTicks(TNSecSpan const &Span);
+
+	static _this Now(TimeSpan const &Offset = TimeSpan::Null);
+};
+
 
 
 #endif
\ No newline at end of file
@@ -32,9 +32,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Types.h"
 
-#include "Debug/Exception.h"
+#include "Format.h"
 
-#include <iomanip>
+#include "Debug/Exception.h"
 
 #define __GEN_HASHCOLLAPSE(v,bcnt)										\
 	__ARC_CARDINAL iRet(v);												\
@@ -44,59 +44,55 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 		Ret.U8[i % icnt] ^= iRet.U8[i];									\
 	return (size_t)Ret
 
+// Render bytes in hex, -1 skips leading zero bytes and marks it with '~'
+static TString __CardinalToString(unsigned char const *U8, unsigned int Size, unsigned int bcnt) {
+	unsigned int start = 0;
+	if (bcnt == -1) {
+		bcnt = 0;
+		while (start < Size && U8[start] == 0) start++;
+	}
+	unsigned int end = std::min(bcnt ? bcnt : Size, Size);
+	if (start >= end) return start ? TString(1, _T('~')) : TString();
+	TString Ret((start ? 1 : 0) + (end - start) * 2, _T('~'));
+	HexEncode(U8 + start, end - start, &Ret[Ret.length() - (end - start) * 2]);
+	return Ret;
+}
+
+// Parse right-aligned hex digits into bytes, excess leading digits are ignored
+static size_t __CardinalFromString(TString const &_S, unsigned char *U8, unsigned int Size) {
+	size_t Digits = std::min(_S.length(), (size_t)Size * 2);
+	TCHAR const *Src = _S.data() + _S.length() - Digits;
+	unsigned char *Dst = U8 + Size - (Digits + 1) / 2;
+	if (Digits & 1) {
+		TCHAR Pad[2] = { _T('0'), *Src };
+		if (HexDecode(Pad, 2, Dst) != 2) FAIL(_T("Invalid symbol '%c'"), *Src);
+		Src++; Dst++;
+	}
+	size_t Valid = HexDecode(Src, Digits & ~(size_t)1, Dst);
+	if (Valid != (Digits & ~(size_t)1)) FAIL(_T("Invalid symbol '%c'"), Src[Valid]);
+#ifndef LITTLE_ENDIAN
+	std::reverse(U8, U8 + Size);
+#endif
+	return Digits / 2;
+}
+
 // Cardinal32
 
 size_t Cardinal32::hashcode(unsigned int bcnt) const {
-	size_t tRet = std::hash<unsigned long>()(U32);
+	size_t tRet = hashvalue();
 	if (bcnt == 0) return tRet;
 	__GEN_HASHCOLLAPSE(tRet, bcnt);
 }
 
 TString Cardinal32::toString(unsigned int bcnt) const {
-	TStringStream StrBuf;
-	unsigned int start = 0;
-	if (bcnt == -1) {
-		bcnt = 0;
-		while (U8[start++] == 0);
-		if (--start) StrBuf << _T('~');
-	}
-	StrBuf << std::hex << std::uppercase << std::setfill(_T('0'));
-	for (unsigned int idx = start; idx < std::min(bcnt ? bcnt : 4, (unsigned int)sizeof(U8)); idx++) {
-		StrBuf << std::setw(2) << U8[idx];
-	}
-	return StrBuf.str();
-}
-
-static char HexCharToVal(TCHAR X) {
-	int V = X - _T('0');
-	if (V < 0) FAIL(_T("Invalid symbol '%c'"), X);
-	if (V > 9) {
-		V -= _T('A') - _T('0');
-		if (V < 0) FAIL(_T("Invalid symbol '%c'"), X);
-		if (V > 5) {
-			V -= _T('a') - _T('A');
-			if (V < 0) FAIL(_T("Invalid symbol '%c'"), X);
-		}
-		V += 10;
-	}
-	return (char)V;
+	return __CardinalToString(U8, (unsigned int)sizeof(U8), bcnt);
 }
 
 size_t Cardinal32::fromString(TString const &_S) {
 	Cardinal32 iVal(0UL);
-	size_t pos = 0;
-	for (auto iter = _S.crbegin(); iter != _S.crend(); iter++) {
-		char X = HexCharToVal(*iter);
-		if (pos & 1) X <<= 4;
-#ifdef LITTLE_ENDIAN
-		iVal.U8[3 - pos / 2] |= X;
-#else
-		iVal.U8[pos / 2] |= X;
-#endif
-		if (++pos >= 8) break;
-	}
+	size_t Ret = __CardinalFromString(_S, iVal.U8, (unsigned int)sizeof(iVal.U8));
 	operator=(iVal);
-	return pos / 2;
+	return Ret;
 }
 
 bool Cardinal32::equalto(Cardinal const &T) const {
@@ -147,41 +143,20 @@ Cardinal32 const& Cardinal32::ZERO(void) {
 // Cardinal64
 
 size_t Cardinal64::hashcode(unsigned int bcnt) const {
-	size_t tRet = std::hash<unsigned long long>()(U64);
+	size_t tRet = hashvalue();
 	if (bcnt == 0) return tRet;
 	__GEN_HASHCOLLAPSE(tRet, bcnt);
 }
 
 TString Cardinal64::toString(unsigned int bcnt) const {
-	TStringStream StrBuf;
-	unsigned int start = 0;
-	if (bcnt == -1) {
-		bcnt = 0;
-		while (U8[start++] == 0);
-		if (--start) StrBuf << _T('~');
-	}
-	StrBuf << std::hex << std::uppercase << std::setfill(_T('0'));
-	for (unsigned int idx = start; idx < std::min(bcnt ? bcnt : 8, (unsigned int)sizeof(U8)); idx++) {
-		StrBuf << std::setw(2) << U8[idx];
-	}
-	return StrBuf.str();
+	return __CardinalToString(U8, (unsigned int)sizeof(U8), bcnt);
 }
 
 size_t Cardinal64::fromString(TString const &_S) {
 	Cardinal64 iVal(0ULL);
-	size_t pos = 0;
-	for (auto iter = _S.crbegin(); iter != _S.crend(); iter++) {
-		char X = HexCharToVal(*iter);
-		if (pos & 1) X <<= 4;
-#ifdef LITTLE_ENDIAN
-		iVal.U8[7 - pos / 2] |= X;
-#else
-		iVal.U8[pos / 2] |= X;
-#endif
-		if (++pos >= 16) break;
-	}
+	size_t Ret = __CardinalFromString(_S, iVal.U8, (unsigned int)sizeof(iVal.U8));
 	operator=(iVal);
-	return pos / 2;
+	return Ret;
 }
 
 bool Cardinal64::equalto(Cardinal const &T) const {
@@ -232,41 +207,20 @@ Cardinal64 const& Cardinal64::ZERO(void) {
 // Cardinal128
 
 size_t Cardinal128::hashcode(unsigned int bcnt) const {
-	size_t tRet = std::hash<unsigned long long>()(U64A) ^ std::hash<unsigned long long>()(U64B);
+	size_t tRet = hashvalue();
 	if (bcnt == 0) return tRet;
 	__GEN_HASHCOLLAPSE(tRet, bcnt);
 }
 
 TString Cardinal128::toString(unsigned int bcnt) const {
-	TStringStream StrBuf;
-	unsigned int start = 0;
-	if (bcnt == -1) {
-		bcnt = 0;
-		while (U8[start++] == 0);
-		if (--start) StrBuf << _T('~');
-	}
-	StrBuf << std::hex << std::uppercase << std::setfill(_T('0'));
-	for (unsigned int idx = start; idx < std::min(bcnt ? bcnt : 16, (unsigned int)sizeof(U8)); idx++) {
-		StrBuf << std::setw(2) << U8[idx];
-	}
-	return StrBuf.str();
+	return __CardinalToString(U8, (unsigned int)sizeof(U8), bcnt);
 }
 
 size_t Cardinal128::fromString(TString const &_S) {
 	Cardinal128 iVal(0ULL, 0ULL);
-	size_t pos = 0;
-	for (auto iter = _S.crbegin(); iter != _S.crend(); iter++) {
-		char X = HexCharToVal(*iter);
-		if (pos & 1) X <<= 4;
-#ifdef LITTLE_ENDIAN
-		iVal.U8[15 - pos / 2] |= X;
-#else
-		iVal.U8[pos / 2] |= X;
-#endif
-		if (++pos >= 32) break;
-	}
+	size_t Ret = __CardinalFromString(_S, iVal.U8, (unsigned int)sizeof(iVal.U8));
 	operator=(iVal);
-	return pos / 2;
+	return Ret;
 }
 
 bool Cardinal128::equalto(Cardinal const &T) const {
@@ -301,10 +255,6 @@ bool Cardinal128::equalto(Cardinal const &T) const {
 	FAIL(_T("Unsupported cardinal type"));
 }
 
-bool Cardinal128::equalto(Cardinal128 const &T) const {
-	return ((U64A ^ T.U64A) | (U64B ^ T.U64B)) == 0;
-}
-
 GUID Cardinal128::toGUID(void) const {
 	return *(LPGUID)U8;
 }
@@ -325,42 +275,20 @@ Cardinal128 const& Cardinal128::ZERO(void) {
 // Cardinal256
 
 size_t Cardinal256::hashcode(unsigned int bcnt) const {
-	size_t tRet = std::hash<unsigned long long>()(U64[0]) ^ std::hash<unsigned long long>()(U64[1]) ^
-		std::hash<unsigned long long>()(U64[2]) ^ std::hash<unsigned long long>()(U64[3]);
+	size_t tRet = hashvalue();
 	if (bcnt == 0) return tRet;
 	__GEN_HASHCOLLAPSE(tRet, bcnt);
 }
 
 TString Cardinal256::toString(unsigned int bcnt) const {
-	TStringStream StrBuf;
-	unsigned int start = 0;
-	if (bcnt == -1) {
-		bcnt = 0;
-		while (U8[start++] == 0);
-		if (--start) StrBuf << _T('~');
-	}
-	StrBuf << std::hex << std::uppercase << std::setfill(_T('0'));
-	for (unsigned int idx = start; idx < std::min(bcnt ? bcnt : 32, (unsigned int)sizeof(U8)); idx++) {
-		StrBuf << std::setw(2) << U8[idx];
-	}
-	return StrBuf.str();
+	return __CardinalToString(U8, (unsigned int)sizeof(U8), bcnt);
 }
 
 size_t Cardinal256::fromString(TString const &_S) {
 	Cardinal256 iVal(0ULL, 0ULL, 0ULL, 0ULL);
-	size_t pos = 0;
-	for (auto iter = _S.crbegin(); iter != _S.crend(); iter++) {
-		char X = HexCharToVal(*iter);
-		if (pos & 1) X <<= 4;
-#ifdef LITTLE_ENDIAN
-		iVal.U8[31 - pos / 2] |= X;
-#else
-		iVal.U8[pos / 2] |= X;
-#endif
-		if (++pos >= 64) break;
-	}
+	size_t Ret = __CardinalFromString(_S, iVal.U8, (unsigned int)sizeof(iVal.U8));
 	operator=(iVal);
-	return pos / 2;
+	return Ret;
 }
 
 bool Cardinal256::equalto(Cardinal const &T) const {
@@ -395,10 +323,6 @@ bool Cardinal256::equalto(Cardinal const &T) const {
 	FAIL(_T("Unsupported cardinal type"));
 }
 
-bool Cardinal256::equalto(Cardinal256 const &T) const {
-	return ((U64[0] ^ T.U64[0]) | (U64[1] ^ T.U64[1]) | (U64[2] ^ T.U64[2]) | (U64[3] ^ T.U64[3])) == 0;
-}
-
 bool Cardinal256::isZero(void) const {
 	return (U64[0] | U64[1] | U64[2] | U64[3]) == 0;
 }
@@ -408,83 +332,98 @@ Cardinal256 const& Cardinal256::ZERO(void) {
 	return __IoFU;
 }
 
-WString UUIDToWString(UUID const &Val) {
-	WString Ret(36, NullWChar);
-	Cardinal128 Value(Val);
-	int result = _snwprintf_s((PWCHAR)Ret.data(), 36 + 1, 36 + 1,
-							  _T("%08X-%04hX-%04hX-%02X%02X-%02X%02X%02X%02X%02X%02X"),
-							  Value.U32[0], Value.U16[2], Value.U16[3],
-							  Value.U8[8], Value.U8[9], Value.U8[10], Value.U8[11],
-							  Value.U8[12], Value.U8[13], Value.U8[14], Value.U8[15]);
-	if (result < 0)
-		FAIL(_T("Converting from GUID to string failed with error code %d"), errno);
+// UUID text form is "XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX", with the leading three fields in big-endian
+#define UUID_TEXTLEN	36
+
+template<typename C>
+static std::basic_string<C> __UUIDToString(UUID const &Val) {
+	unsigned char Bytes[16] = {
+		(unsigned char)(Val.Data1 >> 24), (unsigned char)(Val.Data1 >> 16), (unsigned char)(Val.Data1 >> 8), (unsigned char)Val.Data1,
+		(unsigned char)(Val.Data2 >> 8), (unsigned char)Val.Data2, (unsigned char)(Val.Data3 >> 8), (unsigned char)Val.Data3
+	};
+	memcpy(Bytes + 8, Val.Data4, 8);
+	std::basic_string<C> Ret(UUID_TEXTLEN, (C)'-');
+	C *Out = &Ret.front();
+	HexEncode(Bytes, 4, Out);
+	HexEncode(Bytes + 4, 2, Out + 9);
+	HexEncode(Bytes + 6, 2, Out + 14);
+	HexEncode(Bytes + 8, 2, Out + 19);
+	HexEncode(Bytes + 10, 6, Out + 24);
+	return Ret;
+}
+
+template<typename C>
+static UUID __UUIDFromString(std::basic_string<C> const &Str) {
+	static unsigned int const Dashes[] = { 8, 13, 18, 23 };
+	if (Str.length() < UUID_TEXTLEN)
+		FAIL(_T("Converting from string to GUID failed, expect %d characters, got %d"), UUID_TEXTLEN, (int)Str.length());
+	C Digits[32];
+	C const *In = Str.data();
+	size_t DigitPos = 0, TextPos = 0;
+	for (unsigned int Dash : Dashes) {
+		if (In[Dash] != (C)'-')
+			FAIL(_T("Converting from string to GUID failed at offset %d"), Dash);
+		memcpy(Digits + DigitPos, In + TextPos, (Dash - TextPos) * sizeof(C));
+		DigitPos += Dash - TextPos;
+		TextPos = Dash + 1;
+	}
+	memcpy(Digits + DigitPos, In + TextPos, (UUID_TEXTLEN - TextPos) * sizeof(C));
+
+	unsigned char Bytes[16];
+	size_t Valid = HexDecode(Digits, 32, Bytes);
+	if (Valid != 32) {
+		// Map digit index back to text offset (skip over the dashes before it)
+		size_t Offset = Valid;
+		for (unsigned int Dash : Dashes) if (Offset >= Dash) Offset++;
+		FAIL(_T("Converting from string to GUID failed at offset %d"), (int)Offset);
+	}
+
+	UUID Ret;
+	Ret.Data1 = ((unsigned long)Bytes[0] << 24) | ((unsigned long)Bytes[1] << 16) | ((unsigned long)Bytes[2] << 8) | Bytes[3];
+	Ret.Data2 = (unsigned short)((Bytes[4] << 8) | Bytes[5]);
+	Ret.Data3 = (unsigned short)((Bytes[6] << 8) | Bytes[7]);
+	memcpy(Ret.Data4, Bytes + 8, 8);
 	return Ret;
 }
 
+WString UUIDToWString(UUID const &Val) {
+	return __UUIDToString<wchar_t>(Val);
+}
+
 UUID UUIDFromWString(WString const &Str) {
-	Cardinal128 Value;
-
-	// Work around VC++ missing support for "hhX"
-	int tail8[8];
-	int result = swscanf_s(Str.c_str(), _T("%8X-%4hX-%4hX-%2X%2X-%2X%2X%2X%2X%2X%2X"),
-						   &Value.U32[0], &Value.U16[2], &Value.U16[3],
-						   &tail8[0], &tail8[1], &tail8[2], &tail8[3],
-						   &tail8[4], &tail8[5], &tail8[6], &tail8[7]);
-	if (result < 0)
-		FAIL(_T("Converting from string to GUID failed with error code %d"), errno);
-	if (result < 11)
-		FAIL(_T("Converting from string to GUID failed strating from %d"), result + 1);
-	// Work around VC++ missing support for "hhX"
-	for (int i = 0; i < 8; i++)
-		Value.U8[8 + i] = tail8[i];
-	return Value.toGUID();
+	return __UUIDFromString(Str);
 }
 
 CString UUIDToCString(UUID const &Val) {
-	CString Ret(36, NullAChar);
-	Cardinal128 Value(Val);
-	int result = _snprintf_s((PCHAR)Ret.data(), 36 + 1, 36 + 1,
-							 "%08X-%04hX-%04hX-%02X%02X-%02X%02X%02X%02X%02X%02X",
-							 Value.U32[0], Value.U16[2], Value.U16[3],
-							 Value.U8[8], Value.U8[9], Value.U8[10], Value.U8[11],
-							 Value.U8[12], Value.U8[13], Value.U8[14], Value.U8[15]);
-	if (result < 0)
-		FAIL(_T("Converting from GUID to string failed with error code %d"), errno);
-	return Ret;
+	return __UUIDToString<char>(Val);
 }
 
 UUID UUIDFromCString(CString const &Str) {
-	Cardinal128 Value;
-
-	// Work around VC++ missing support for "hhX"
-	int tail8[8];
-	int result = sscanf_s(Str.c_str(), "%8X-%4hX-%4hX-%2X%2X-%2X%2X%2X%2X%2X%2X",
-						  &Value.U32[0], &Value.U16[2], &Value.U16[3],
-						  &tail8[0], &tail8[1], &tail8[2], &tail8[3],
-						  &tail8[4], &tail8[5], &tail8[6], &tail8[7]);
-	if (result < 0)
-		FAIL(_T("Converting from string to GUID failed with error code %d"), errno);
-	if (result < 11)
-		FAIL(_T("Converting from string to GUID failed strating from %d"), result + 1);
-	// Work around VC++ missing support for "hhX"
-	for (int i = 0; i < 8; i++)
-		Value.U8[8 + i] = tail8[i];
-	return Value.toGUID();
+	return __UUIDFromString(Str);
 }
 
 UUID const UUID_NULL = { 0 };
 
 TString HexInspect(void* Buf, size_t Len) {
-	TString HexBuf;
-	unsigned char* ByteBuf = (unsigned char*)Buf;
-	for (size_t i = 0; i < Len; i++) {
-		HexBuf.append(TStringCast(_T(' ') << std::hex << std::uppercase << std::setfill(_T('0'))
-								  << std::setw(2) << ByteBuf[i]));
-		if ((i & 15) == 15) HexBuf.append(_T("\n"));
-		else if ((i & 7) == 7) HexBuf.append(_T("\t"));
+	// Each byte takes " XX", every 8 bytes are followed by a tab or a newline
+	TString Ret(Len * 3 + Len / 8 + ((Len & 15) ? 1 : 0), _T(' '));
+	if (Ret.empty()) return Ret;
+	unsigned char const* ByteBuf = (unsigned char const*)Buf;
+	TCHAR *Out = &Ret.front();
+	TCHAR Digits[32];
+	for (size_t i = 0; i < Len; i += 16) {
+		size_t Count = std::min(Len - i, (size_t)16);
+		HexEncode(ByteBuf + i, Count, Digits);
+		for (size_t j = 0; j < Count; j++) {
+			Out[1] = Digits[j * 2];
+			Out[2] = Digits[j * 2 + 1];
+			Out += 3;
+			if (j == 7) *Out++ = _T('\t');
+		}
+		if (Count == 16) *Out++ = _T('\n');
 	}
-	if ((Len & 15) != 15) HexBuf.append(_T("\n"));
-	return HexBuf;
+	if (Len & 15) *Out = _T('\n');
+	return Ret;
 }
 
 UINT32 CountBits32(UINT32 Mask) {
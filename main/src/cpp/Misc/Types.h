@@ -94,6 +94,63 @@ struct Has_##Func {												\
 	static const bool value = sizeof(_Probe<T>(nullptr)) > 1;	\
 }
 
+//--------
+// Fast hashing (multiply-fold mixing, same construction as wyhash)
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define CARDINAL_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX2__
+#define CARDINAL_AVX2
+#include <immintrin.h>
+#endif
+
+#define HASH_SECRET0	0xa0761d6478bd642fULL
+#define HASH_SECRET1	0xe7037ed1a0b428dbULL
+#define HASH_SECRET2	0x8ebc6af09c88c6e3ULL
+#define HASH_SECRET3	0x589965cc75374cc3ULL
+
+//! Full 64x64 -> 128-bit multiply, the low and high halves replace the inputs
+inline void __HashMum(UINT64 &A, UINT64 &B) {
+#if defined(_M_AMD64)
+	A = _umul128(A, B, &B);
+#elif defined(__SIZEOF_INT128__)
+	unsigned __int128 R = (unsigned __int128)A * B;
+	A = (UINT64)R; B = (UINT64)(R >> 64);
+#else
+	UINT64 HH = (A >> 32) * (B >> 32), HL = (A >> 32) * (UINT32)B;
+	UINT64 LH = (UINT32)A * (B >> 32), LL = (UINT64)(UINT32)A * (UINT32)B;
+	UINT64 Mid = (LL >> 32) + (UINT32)HL + (UINT32)LH;
+	A = (Mid << 32) | (UINT32)LL;
+	B = HH + (HL >> 32) + (LH >> 32) + (Mid >> 32);
+#endif
+}
+
+//! Multiply and fold the 128-bit product into 64 bits
+inline UINT64 __HashMix(UINT64 A, UINT64 B) {
+	__HashMum(A, B);
+	return A ^ B;
+}
+
+//! Hash two 64-bit words carrying Len bytes of data
+inline size_t HashWords(UINT64 A, UINT64 B, UINT64 Len) {
+	A ^= HASH_SECRET1;
+	B ^= HASH_SECRET0;
+	__HashMum(A, B);
+	UINT64 Ret = __HashMix(A ^ HASH_SECRET0 ^ Len, B ^ HASH_SECRET1);
+#ifdef ARCH_64
+	return (size_t)Ret;
+#else
+	return (size_t)(Ret ^ (Ret >> 32));
+#endif
+}
+
 //--------
 // Cardinals
 
@@ -135,6 +192,8 @@ struct Cardinal32 : public Cardinal {
 	virtual bool isZero(void) const override;
 
 	bool equalto(Cardinal32 const &T) const;
+	size_t hashvalue(void) const
+	{ return HashWords(U32, 0, sizeof(U32)); }
 	operator size_t() const { return U32; }
 
 	static Cardinal32 const& ZERO(void);
@@ -143,7 +202,7 @@ struct Cardinal32 : public Cardinal {
 template<>
 struct std::hash<Cardinal32> {
 	size_t operator()(Cardinal32 const &X) const {
-		return X.hashcode();
+		return X.hashvalue();
 	}
 };
 
@@ -185,6 +244,8 @@ struct Cardinal64 : public Cardinal {
 	virtual bool isZero(void) const override;
 
 	bool equalto(Cardinal64 const &T) const;
+	size_t hashvalue(void) const
+	{ return HashWords(U64, 0, sizeof(U64)); }
 #ifdef ARCH_64
 	operator size_t() const { return U64; }
 #endif
@@ -195,7 +256,7 @@ struct Cardinal64 : public Cardinal {
 template<>
 struct std::hash<Cardinal64> {
 	size_t operator()(Cardinal64 const &X) const {
-		return X.hashcode();
+		return X.hashvalue();
 	}
 };
 
@@ -233,7 +294,16 @@ struct Cardinal128 : public Cardinal {
 	virtual bool equalto(Cardinal const &T) const override;
 	virtual bool isZero(void) const override;
 
-	bool equalto(Cardinal128 const &T) const;
+	bool equalto(Cardinal128 const &T) const {
+#ifdef CARDINAL_SSE2
+		__m128i X = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*)U8), _mm_loadu_si128((__m128i const*)T.U8));
+		return _mm_movemask_epi8(X) == 0xFFFF;
+#else
+		return ((U64A ^ T.U64A) | (U64B ^ T.U64B)) == 0;
+#endif
+	}
+	size_t hashvalue(void) const
+	{ return HashWords(U64A, U64B, sizeof(U8)); }
 
 	GUID toGUID(void) const;
 	void loadGUID(GUID const &V);
@@ -244,7 +314,7 @@ struct Cardinal128 : public Cardinal {
 template<>
 struct std::hash<Cardinal128> {
 	size_t operator()(Cardinal128 const &X) const {
-		return X.hashcode();
+		return X.hashvalue();
 	}
 };
 
@@ -293,7 +363,22 @@ struct Cardinal256 : public Cardinal {
 	virtual bool equalto(Cardinal const &T) const override;
 	virtual bool isZero(void) const override;
 
-	bool equalto(Cardinal256 const &T) const;
+	bool equalto(Cardinal256 const &T) const {
+#if defined(CARDINAL_AVX2)
+		__m256i X = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const*)U8), _mm256_loadu_si256((__m256i const*)T.U8));
+		return _mm256_movemask_epi8(X) == -1;
+#elif defined(CARDINAL_SSE2)
+		__m128i XA = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*)U8), _mm_loadu_si128((__m128i const*)T.U8));
+		__m128i XB = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*)(U8 + 16)), _mm_loadu_si128((__m128i const*)(T.U8 + 16)));
+		return _mm_movemask_epi8(_mm_and_si128(XA, XB)) == 0xFFFF;
+#else
+		return ((U64[0] ^ T.U64[0]) | (U64[1] ^ T.U64[1]) | (U64[2] ^ T.U64[2]) | (U64[3] ^ T.U64[3])) == 0;
+#endif
+	}
+	size_t hashvalue(void) const {
+		return HashWords(__HashMix(U64[0] ^ HASH_SECRET1, U64[1] ^ HASH_SECRET2),
+						 __HashMix(U64[2] ^ HASH_SECRET3, U64[3] ^ HASH_SECRET2), sizeof(U8));
+	}
 
 	static Cardinal256 const& ZERO(void);
 };
@@ -301,7 +386,7 @@ struct Cardinal256 : public Cardinal {
 template<>
 struct std::hash<Cardinal256> {
 	size_t operator()(Cardinal256 const &X) const {
-		return X.hashcode();
+		return X.hashvalue();
 	}
 };
 
@@ -342,6 +427,18 @@ UUID UUIDFromCString(CString const &Str);
 
 extern UUID const UUID_NULL;
 
+#ifdef WINDOWS
+// Consistent with the hash of Cardinal128 holding the same GUID
+template<>
+struct std::hash<GUID> {
+	size_t operator()(GUID const &X) const {
+		UINT64 W[2];
+		memcpy(W, &X, sizeof(W));
+		return HashWords(W[0], W[1], sizeof(W));
+	}
+};
+#endif
+
 //--------
 // Misc utilities
 
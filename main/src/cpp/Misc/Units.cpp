@@ -31,6 +31,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // [Utilities] Platform and charset independent string utilities
 
 #include "Units.h"
+#include "Format.h"
 
 unsigned long long _Convert(unsigned long long &Value, unsigned long long const &FromBase,
 	unsigned long long const &ToBase) {
@@ -110,7 +111,7 @@ TString _ToString(long long const &Value, T const &DataUnit, bool Abbrv, bool Om
 				else if (Value < 0) Ret.append(1, _T('-'));
 			} else Ret.append(1, _T(' '));
 
-			Ret.append(TStringCast(RValue))
+			Ret.append(TStringFmt(RValue))
 				.append(Abbrv ? 0 : 1, _T(' '))
 				.append(UnitName(CurRes, Abbrv))
 				.append(!Abbrv && (RValue > 1) ? 1 : 0, _T('s'));
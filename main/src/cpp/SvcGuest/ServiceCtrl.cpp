@@ -167,7 +167,7 @@ static void InstallAsService(LPCTSTR ServiceName, LPCTSTR ServiceDispName, LPCTS
 	}
 	if (CrashRestart != 0) {
 		LOGV(_T("* Crash restart %s times with %s delay"),
-			 CrashRestart > 0 ? TStringCast(CrashRestart).c_str() : _T("INFINITE"),
+			 CrashRestart > 0 ? TStringFmt(CrashRestart).c_str() : _T("INFINITE"),
 			 TimeSpan(RestartDelay, TimeUnit::MSEC).toString(TimeUnit::MIN).c_str());
 
 		SERVICE_FAILURE_ACTIONS FailureActions{ 0 };
@@ -197,7 +197,7 @@ static void InstallAsService(LPCTSTR ServiceName, LPCTSTR ServiceDispName, LPCTS
 	THKEY ServiceParamKey(
 		[&] {
 			HKEY _KEY = nullptr;
-			TString ServiceRegName = TStringCast(_SERVICE_REGBASE << ServiceName);
+			TString ServiceRegName = TStringFmt(_SERVICE_REGBASE << ServiceName);
 			LONG Result = RegOpenKeyEx(HKEY_LOCAL_MACHINE, ServiceRegName.c_str(), 0, KEY_ALL_ACCESS, &_KEY);
 			if (Result != ERROR_SUCCESS)
 				SYSERRFAIL(Result, _T("Unable to open service configuration"));
@@ -523,7 +523,7 @@ static void MoveServiceGroup(LPCTSTR ServiceName, LPCTSTR ServiceSrcGrp, LPCTSTR
 					SYSERRFAIL(Result, _T("Unable to set member of service group '%s'"), ServiceDstGrp);
 			}
 
-			TString ServiceRegName = TStringCast(_T("SYSTEM\\CurrentControlSet\\services\\") << ServiceName);
+			TString ServiceRegName = TStringFmt(_T("SYSTEM\\CurrentControlSet\\services\\") << ServiceName);
 			Result = RegOpenKeyTransacted(HKEY_LOCAL_MACHINE, ServiceRegName.c_str(), 0, KEY_ALL_ACCESS, &_KEY, MoveTXN, nullptr);
 			if (Result != ERROR_SUCCESS)
 				SYSERRFAIL(Result, _T("Unable to open service configuration"));
@@ -544,7 +544,7 @@ static void MoveServiceGroup(LPCTSTR ServiceName, LPCTSTR ServiceSrcGrp, LPCTSTR
 			if (Result != ERROR_SUCCESS)
 				SYSERRFAIL(Result, _T("Unable to query image path for service '%s'"), ServiceName);
 
-			TString GroupIdent = TStringCast(_T(" -k ") << ServiceSrcGrp);
+			TString GroupIdent = TStringFmt(_T(" -k ") << ServiceSrcGrp);
 			LPCTSTR Match = _tcsstr(ImagePath.data(), GroupIdent.data());
 			if (!Match)
 				FAIL(_T("Unable to match service group identifier in image path of service '%s'"), ServiceName, ServiceSrcGrp);
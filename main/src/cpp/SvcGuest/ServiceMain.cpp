@@ -213,7 +213,7 @@ static TEvent &ServiceAck(void) {
 }
 
 static TInterlockedOrdinal32<BOOL> ServiceRunLock(FALSE);
-static TimeStamp ServiceStartTS;
+static TMonotonicStamp ServiceStartTS;
 
 static bool _Invoke_ServiceEvent(TString const &SvcName, LPCTSTR EvtKind, ServiceEvent const &SvcEvt) {
 	try {
@@ -270,7 +270,7 @@ TString Service_GetDataDir(void) {
 	}
 	LOGVV(_T("+ Common application data directory '%s'"), PROGRAMDATA.c_str());
 
-	TString Ret = TStringCast(PROGRAMDATA.c_str() << _T('\\') << SERVICE_PROGRAMPATH);
+	TString Ret = TStringFmt(PROGRAMDATA.c_str() << _T('\\') << SERVICE_PROGRAMPATH);
 	int iRet = SHCreateDirectoryEx(NULL, Ret.c_str(), NULL);
 	if (iRet != ERROR_SUCCESS) {
 		if (iRet != ERROR_ALREADY_EXISTS) {
@@ -328,7 +328,7 @@ static DWORD ServiceInit(ServiceMode Mode) {
 	TString SERVICE_DATADIR = Service_GetDataDir();
 	if (SERVICE_DATADIR.empty()) return 1;
 
-	TString SERVICE_LOG = TStringCast(SERVICE_DATADIR << _T('\\') << SERVICE_LOG_FILENAME);
+	TString SERVICE_LOG = TStringFmt(SERVICE_DATADIR << _T('\\') << SERVICE_LOG_FILENAME);
 	LOGFILE = _tfsopen(SERVICE_LOG.c_str(), _T("a+t, ccs=UNICODE"), _SH_DENYNO);
 	if (LOGFILE == nullptr) {
 		LOG(_T("WARNING: Unable to open service log file (runtime error %d)"), errno);
@@ -336,7 +336,7 @@ static DWORD ServiceInit(ServiceMode Mode) {
 	}
 	SETLOGTARGET(LOGTARGET_SERVICE, LOGFILE);
 
-	ServiceStartTS = TimeStamp::Now();
+	ServiceStartTS = TMonotonicStamp::Now();
 
 	ServiceStop().Reset();
 	ServiceAck().Reset();
@@ -396,7 +396,7 @@ static DWORD _ServiceStop(void) {
 			}
 		}
 
-		TimeSpan ServiceDuration = TimeStamp::Now() - ServiceStartTS;
+		TimeSpan ServiceDuration = TMonotonicStamp::Now() - ServiceStartTS;
 		LOG(_T("* Service execution duration: %s"), ServiceDuration.toString(true, true, TimeUnit::DAY, TimeUnit::MSEC).c_str());
 	}
 	return failcount;
@@ -38,8 +38,6 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Debug/SysError.h"
 
-#include <iomanip>
-
 #ifdef WINDOWS
 
 #pragma comment(lib, "version")
@@ -108,8 +106,8 @@ TTypedBuffer<LANGANDCODEPAGE> GetVersionTranslations(TDynBuffer const &ResData)
 }
 
 TString ExtractVersionString(TDynBuffer const &ResData, LANGANDCODEPAGE const& LCData, TString const &ResKey) {
-	TString FileInfoPfx = TStringCast(__VERSION_STRINGFILEINFO << std::hex << std::setfill(_T('0')) <<
-									  std::setw(4) << LCData.wLanguage << std::setw(4) << LCData.wCodePage << _T('\\'));
+	TString FileInfoPfx = TStringFmt(__VERSION_STRINGFILEINFO << FmtHex(LCData.wLanguage, 4, false)
+									 << FmtHex(LCData.wCodePage, 4, false) << _T('\\'));
 
 	auto StrBuf = GetVersionResource(FileInfoPfx + ResKey, ResData);
 	if (StrBuf.GetSize() % sizeof(TCHAR)) {
@@ -0,0 +1,172 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// [Threading] Lock Contention Profiling
+
+#include "LockProfile.h"
+
+#include "Debug/Logging.h"
+
+typedef std::vector<TLockProfile*> TLockProfiles;
+
+TSyncObj<TLockProfiles>& LOCKPROFILES(void) {
+	static TSyncObj<TLockProfiles> __IoFU;
+	return __IoFU;
+}
+
+// --- TLockProfile
+
+#define LOCKPROFILE_HOLDS	16
+
+// Timed holds of the current thread, so concurrent holders of shared or counting locks are timed separately
+struct TLockHolds {
+	struct THold {
+		void const *Lockable;
+		UINT64 Start;
+	} Entries[LOCKPROFILE_HOLDS];
+	size_t Count = 0;
+};
+
+static thread_local TLockHolds __LockHolds;
+
+void TLockProfile::HoldBegin(void const *Lockable, UINT64 Start) {
+	if (__LockHolds.Count == LOCKPROFILE_HOLDS) {
+		// Most likely left behind by locks released on other threads, drop the oldest
+		memmove(&__LockHolds.Entries[0], &__LockHolds.Entries[1], sizeof(TLockHolds::THold) * --__LockHolds.Count);
+	}
+	__LockHolds.Entries[__LockHolds.Count++] = { Lockable, Start };
+}
+
+UINT64 TLockProfile::HoldEnd(void const *Lockable) {
+	for (size_t i = __LockHolds.Count; i--;) {
+		if (__LockHolds.Entries[i].Lockable != Lockable) continue;
+		UINT64 iRet = __LockHolds.Entries[i].Start;
+		memmove(&__LockHolds.Entries[i], &__LockHolds.Entries[i + 1], sizeof(TLockHolds::THold) * (--__LockHolds.Count - i));
+		return iRet;
+	}
+	return 0;
+}
+
+static UINT64 __Read64(LONG64 const volatile &Value) {
+#ifdef _WIN64
+	return Value;
+#else
+	return InterlockedCompareExchange64(const_cast<LONG64 volatile*>(&Value), 0, 0);
+#endif
+}
+
+TLockProfile::TLockProfile(TString const &xName, unsigned int SampleRate) :
+	_SampleMask(SampleRate - 1),
+	Name(xName.empty() ? TStringFmt(_T("Lock@") << (void*)this) : xName) {
+	if (!SampleRate || (SampleRate & _SampleMask))
+		FAIL(_T("Sample rate must be a power of 2 (got %u)"), SampleRate);
+	LOCKPROFILES().Pickup()->push_back(this);
+}
+
+TLockProfile::~TLockProfile(void) {
+	auto Profiles(LOCKPROFILES().Pickup());
+	Profiles->erase(std::find(Profiles->begin(), Profiles->end(), this));
+}
+
+TLockProfile::TStats TLockProfile::Stats(void) const {
+	return { Name, __Read64(_Acquired), __Read64(_Contended), __Read64(_Sampled),
+		Span(__Read64(_WaitTotal)), Span(__Read64(_WaitMax)), Span(__Read64(_HoldTotal)), Span(__Read64(_HoldMax)),
+		_Waits.Snapshot() };
+}
+
+std::vector<TLockProfile::TStats> TLockProfile::Top(size_t Count) {
+	std::vector<TStats> iRet;
+	{
+		auto Profiles(LOCKPROFILES().Pickup());
+		iRet.reserve(Profiles->size());
+		for (auto Profile : *Profiles) iRet.emplace_back(Profile->Stats());
+	}
+	std::sort(iRet.begin(), iRet.end(), [](TStats const &A, TStats const &B) {
+		if (A.Contended != B.Contended) return A.Contended > B.Contended;
+		return A.WaitTotal > B.WaitTotal;
+	});
+	if (iRet.size() > Count) iRet.resize(Count);
+	return iRet;
+}
+
+void TLockProfile::Dump(size_t Count) {
+	auto Stats = Top(Count);
+	LOG(_T("Lock contention profile (top %d of profiled locks):"), (int)Stats.size());
+	for (auto &Entry : Stats) LOG(_T("- %s"), Entry.toString().c_str());
+}
+
+TString TLockProfile::TStats::toString(void) const {
+	UINT64 Timed = std::max(Sampled, 1ULL);
+	TNSecSpan WaitAvg = WaitTotal / Timed;
+	TNSecSpan HoldAvg = HoldTotal / Timed;
+	return TStringFmt(_T('\'') << Name << _T("': ") << Acquired << _T(" acquired, ") << Contended
+					  << _T(" contended; wait avg ") << WaitAvg.toString(TimeUnit::USEC)
+					   << _T(" p99 ") << Waits.Percentile(99).toString(TimeUnit::USEC)
+					   << _T(" max ") << WaitMax.toString(TimeUnit::USEC)
+					   << _T("; hold avg ") << HoldAvg.toString(TimeUnit::USEC)
+					   << _T(" max ") << HoldMax.toString(TimeUnit::USEC)
+					   << _T(" (") << Sampled << _T(" timed)"));
+}
+
+// --- TLockProfileReporter
+
+class TLockProfileReportRunnable : public TRunnable {
+	typedef TLockProfileReportRunnable _this;
+
+protected:
+	TEvent _StopEvent;
+	WAITTIME const _Interval;
+	size_t const _Count;
+
+public:
+	TLockProfileReportRunnable(TimeSpan const &Interval, size_t Count) :
+		_Interval((WAITTIME)Interval.GetValue(TimeUnit::MSEC)), _Count(Count) {}
+
+	TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &Arg) override {
+		while (_StopEvent.WaitFor(_Interval) == WaitResult::TimedOut)
+			TLockProfile::Dump(_Count);
+		return {};
+	}
+
+	void StopNotify(TWorkerThread &WorkerThread) override {
+		_StopEvent.Set();
+	}
+};
+
+TLockProfileReporter::TLockProfileReporter(TimeSpan const &Interval, size_t Count) :
+	_Thread(TWorkerThread::Create(_T("LockProfileReporter"),
+		{ DEFAULT_NEW(TLockProfileReportRunnable, Interval, Count), CONSTRUCTION::HANDOFF }), CONSTRUCTION::HANDOFF) {
+	_Thread->Start();
+}
+
+TLockProfileReporter::~TLockProfileReporter(void) {
+	_Thread->SignalTerminate();
+	_Thread->WaitFor();
+}
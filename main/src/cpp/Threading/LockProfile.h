@@ -0,0 +1,299 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @addtogroup Threading Threading Support Utilities
+ * @file
+ * @brief Lock Contention Profiling
+ **/
+
+#ifndef ZWUtils_LockProfile_H
+#define ZWUtils_LockProfile_H
+
+ // Project global control 
+#include "Misc/Global.h"
+
+#include "Misc/TString.h"
+#include "Misc/Timing.h"
+#include "Misc/Histogram.h"
+
+#include "Debug/FlightRecorder.h"
+
+#include "SyncObjects.h"
+#include "WorkerThread.h"
+
+#include <vector>
+
+#define LOCKPROFILE_TOPN	10
+
+/**
+ * @ingroup Threading
+ * @brief Contention statistics of a named lock
+ *
+ * Counters are updated with interlocked operations, so concurrent holders of shared or counting locks
+ * are all accounted for; hold start times are kept per thread
+ **/
+class TLockProfile {
+	typedef TLockProfile _this;
+
+public:
+	struct TStats {
+		TString Name;
+		UINT64 Acquired;
+		UINT64 Contended;
+		UINT64 Sampled;
+		TNSecSpan WaitTotal;
+		TNSecSpan WaitMax;
+		TNSecSpan HoldTotal;
+		TNSecSpan HoldMax;
+		THistogram::TSnapshot Waits;
+
+		TString toString(void) const;
+	};
+
+protected:
+	LONG64 volatile _Acquired = 0;
+	LONG64 volatile _Contended = 0;
+	LONG64 volatile _Sampled = 0;
+	LONG64 volatile _WaitTotal = 0;
+	LONG64 volatile _WaitMax = 0;
+	LONG64 volatile _HoldTotal = 0;
+	LONG64 volatile _HoldMax = 0;
+	UINT64 const _SampleMask;
+	THistogram _Waits;
+
+	static void __Max(LONG64 volatile &Max, LONG64 Value) {
+		LONG64 Current = Max;
+		while (Value > Current) {
+			LONG64 Prev = InterlockedCompareExchange64(&Max, Value, Current);
+			if (Prev == Current) break;
+			Current = Prev;
+		}
+	}
+
+public:
+	TString const Name;
+
+	/**
+	 * Register a profile record
+	 * @note Only one in every SampleRate (power of 2) acquisitions is timed, all are counted
+	 **/
+	TLockProfile(TString const &xName, unsigned int SampleRate = 1);
+	~TLockProfile(void);
+
+	// Copy and move constructions would confuse the registry
+	TLockProfile(_this const &) = delete;
+	TLockProfile(_this &&) = delete;
+	_this& operator=(_this const &) = delete;
+	_this& operator=(_this &&) = delete;
+
+	/**
+	 * Cheap monotonic clock, in performance counter ticks
+	 **/
+	static UINT64 Ticks(void) {
+		return TMonotonicStamp::Now().GetTicks();
+	}
+
+	static TNSecSpan Span(UINT64 Ticks) {
+		return TMonotonicStamp::toNSec(Ticks);
+	}
+
+	/**
+	 * Check whether the next acquisition should be timed
+	 **/
+	bool Sample(void) const {
+		return !(_Acquired & _SampleMask);
+	}
+
+	/**
+	 * Record an acquisition
+	 **/
+	void Acquired(bool Contended, UINT64 WaitTicks, bool Timed) {
+		InterlockedIncrement64(&_Acquired);
+		if (Contended) InterlockedIncrement64(&_Contended);
+		if (Timed) {
+			InterlockedIncrement64(&_Sampled);
+			InterlockedExchangeAdd64(&_WaitTotal, (LONG64)WaitTicks);
+			__Max(_WaitMax, (LONG64)WaitTicks);
+			_Waits.Record(Span(WaitTicks));
+		}
+	}
+
+	/**
+	 * Record a (timed) hold period
+	 **/
+	void Released(UINT64 HoldTicks) {
+		InterlockedExchangeAdd64(&_HoldTotal, (LONG64)HoldTicks);
+		__Max(_HoldMax, (LONG64)HoldTicks);
+	}
+
+	/**
+	 * Remember when the current thread took a (timed) hold of a lockable
+	 **/
+	static void HoldBegin(void const *Lockable, UINT64 Start);
+
+	/**
+	 * Return when the current thread took its latest timed hold of a lockable, and forget it
+	 * @return 0 if the hold was not timed, or was taken by another thread
+	 **/
+	static UINT64 HoldEnd(void const *Lockable);
+
+	/**
+	 * Take a (loosely consistent) snapshot of the counters
+	 **/
+	TStats Stats(void) const;
+
+	/**
+	 * Collect statistics of the most contended locks
+	 **/
+	static std::vector<TStats> Top(size_t Count = LOCKPROFILE_TOPN);
+
+	/**
+	 * Log statistics of the most contended locks
+	 **/
+	static void Dump(size_t Count = LOCKPROFILE_TOPN);
+};
+
+/**
+ * @ingroup Threading
+ * @brief Profiled lockable adapter
+ *
+ * Wraps any lockable to record acquisition, contention, wait and hold statistics under a name
+ * - An acquisition is contended if the lock could not be taken on the first try
+ * - Shared Lock_Read() / TryLock_Read() of reader-writer lockables are profiled along with exclusive ones
+ * Note: Hold time is only recorded if the lock is released on the acquiring thread
+ **/
+template<class L>
+class TLockableProfiled : public L {
+	ENFORCE_DERIVE(TLockable, L);
+	typedef TLockableProfiled _this;
+
+protected:
+	TLockProfile _Profile;
+
+	TLockable::TLock& __Acquired(TLockable::TLock &Lock, bool Contended, UINT64 WaitStart) {
+		if (Lock) {
+			bool Timed = WaitStart != 0;
+			UINT64 Now = Timed ? TLockProfile::Ticks() : 0;
+			_Profile.Acquired(Contended, Now - WaitStart, Timed);
+			if (Timed) TLockProfile::HoldBegin(this, Now);
+		}
+		return Lock;
+	}
+
+	void __Unlock(TLockable::TLockInfo *LockInfo) override {
+		if (UINT64 HoldStart = TLockProfile::HoldEnd(this))
+			_Profile.Released(TLockProfile::Ticks() - HoldStart);
+		L::__Unlock(LockInfo);
+	}
+
+public:
+	TLockableProfiled(TString const &Name = EMPTY_TSTRING(), unsigned int SampleRate = 1) :
+		_Profile(Name, SampleRate) {}
+
+	TLockable::TLock Lock(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) override {
+		UINT64 WaitStart = _Profile.Sample() ? TLockProfile::Ticks() : 0;
+		auto iRet = L::TryLock(1);
+		bool Contended = !iRet;
+		if (Contended) {
+			FLIGHTREC("Lock Wait", this, 0);
+			iRet = L::Lock(Timeout, AbortEvent);
+			FLIGHTREC("Lock Acquired", this, (bool)iRet);
+		}
+		return std::move(__Acquired(iRet, Contended, WaitStart));
+	}
+
+	TLockable::TLock LockUntil(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) override {
+		UINT64 WaitStart = _Profile.Sample() ? TLockProfile::Ticks() : 0;
+		auto iRet = L::TryLock(1);
+		bool Contended = !iRet;
+		if (Contended) {
+			FLIGHTREC("Lock Wait", this, 0);
+			iRet = L::LockUntil(Deadline, AbortEvent);
+			FLIGHTREC("Lock Acquired", this, (bool)iRet);
+		}
+		return std::move(__Acquired(iRet, Contended, WaitStart));
+	}
+
+	TLockable::TLock TryLock(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) override {
+		UINT64 WaitStart = _Profile.Sample() ? TLockProfile::Ticks() : 0;
+		auto iRet = L::TryLock(1);
+		bool Contended = !iRet && SpinCount > 1;
+		if (Contended) iRet = L::TryLock(SpinCount - 1);
+		return std::move(__Acquired(iRet, Contended, WaitStart));
+	}
+
+	TLockable::TLock Lock_Read(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
+		return Lock_Read(TDeadline(Timeout), AbortEvent);
+	}
+
+	TLockable::TLock Lock_Read(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) {
+		UINT64 WaitStart = _Profile.Sample() ? TLockProfile::Ticks() : 0;
+		auto iRet = L::TryLock_Read(1);
+		bool Contended = !iRet;
+		if (Contended) {
+			FLIGHTREC("Lock Read Wait", this, 0);
+			iRet = L::Lock_Read(Deadline, AbortEvent);
+			FLIGHTREC("Lock Read Acquired", this, (bool)iRet);
+		}
+		return std::move(__Acquired(iRet, Contended, WaitStart));
+	}
+
+	TLockable::TLock TryLock_Read(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) {
+		UINT64 WaitStart = _Profile.Sample() ? TLockProfile::Ticks() : 0;
+		auto iRet = L::TryLock_Read(1);
+		bool Contended = !iRet && SpinCount > 1;
+		if (Contended) iRet = L::TryLock_Read(SpinCount - 1);
+		return std::move(__Acquired(iRet, Contended, WaitStart));
+	}
+
+	TLockProfile const& Profile(void) const {
+		return _Profile;
+	}
+};
+
+/**
+ * @ingroup Threading
+ * @brief Periodic lock contention reporter
+ *
+ * Logs the most contended locks at a fixed interval on a background thread
+ **/
+class TLockProfileReporter {
+	typedef TLockProfileReporter _this;
+
+protected:
+	MRWorkerThread _Thread;
+
+public:
+	TLockProfileReporter(TimeSpan const &Interval, size_t Count = LOCKPROFILE_TOPN);
+	~TLockProfileReporter(void);
+};
+
+#endif
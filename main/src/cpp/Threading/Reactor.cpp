@@ -0,0 +1,140 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// [Threading] Single-threaded Reactor
+
+#include "Reactor.h"
+
+#ifdef __ZWUTILS_SYNC_WAITSET
+
+TReactor::TReactor(void) : _WaitSet(TWaitSet::Create()) {
+	_WaitSet->Add(_WakeEvent);
+}
+
+TReactor::~TReactor(void) {
+	for (auto &Entry : _Watches) _WaitSet->Remove(*Entry.second);
+	_WaitSet->Remove(_WakeEvent);
+}
+
+TReactor::TToken TReactor::__Watch(THandleWaitable &&Waitable, TClosure const &Handler) {
+	TToken Token = ++_NextToken;
+	MRWatch Watch(CONSTRUCTION::EMPLACE, std::move(Waitable), Token, Handler);
+	__Dispatch([=] {
+		_WaitSet->Add(*Watch);
+		_Watches.emplace(Token, Watch);
+	});
+	return Token;
+}
+
+TReactor::TToken TReactor::Schedule(TDeadline const &Deadline, TAlarmCallback const &Callback) {
+	TToken Token = ++_NextToken;
+	TMonotonicStamp Due = Deadline.Due();
+	__Dispatch([=] {
+		_Timers.emplace(Token, _Schedule.emplace(Due, std::make_pair(Token, Callback)));
+	});
+	return Token;
+}
+
+void TReactor::__Cancel(TToken Token) {
+	auto Watch = _Watches.find(Token);
+	if (Watch != _Watches.end()) {
+		_WaitSet->Remove(*Watch->second);
+		// Keep the watch alive until the end of current round, in case it is in the ready list
+		_Retired.push_back(std::move(Watch->second));
+		_Watches.erase(Watch);
+		return;
+	}
+	auto Timer = _Timers.find(Token);
+	if (Timer != _Timers.end()) {
+		_Schedule.erase(Timer->second);
+		_Timers.erase(Timer);
+	}
+}
+
+void TReactor::Post(TClosure const &Closure) {
+	_Posted.Pickup()->push_back(Closure);
+	_WakeEvent.Set();
+}
+
+void TReactor::__RunPosted(void) {
+	std::vector<TClosure> Posted;
+	_Posted.Pickup()->swap(Posted);
+	for (auto &Closure : Posted) Closure();
+}
+
+void TReactor::__RunTimers(void) {
+	TMonotonicStamp Now = TMonotonicStamp::Now();
+	while (!_Schedule.empty() && _Schedule.begin()->first <= Now) {
+		auto Entry = _Schedule.begin();
+		TimeStamp DueTS = TimeStamp::Now(Entry->first - Now);
+		TAlarmCallback Callback = std::move(Entry->second.second);
+		_Timers.erase(Entry->second.first);
+		_Schedule.erase(Entry);
+		Callback(DueTS);
+	}
+}
+
+WAITTIME TReactor::__NextTimeout(void) {
+	if (_Schedule.empty()) return FOREVER;
+	// Rounded up, so we do not wake up just before the deadline
+	return TDeadline(_Schedule.begin()->first).Remaining();
+}
+
+void TReactor::Run(void) {
+	if (_LoopThread.CompareAndSwap(0, GetCurrentThreadId()) != 0)
+		FAIL(_T("Reactor is already running"));
+	TInitResource<DWORD> LoopThread(~_LoopThread, [&](DWORD &) {
+		_LoopThread = 0;
+		_Stopping = 0;
+	});
+
+	TWaitSet::TReady Ready;
+	while (!~_Stopping) {
+		__RunPosted();
+		__RunTimers();
+		if (~_Stopping) break;
+
+		if (_WaitSet->Wait(Ready, __NextTimeout()) != WaitResult::Signaled) continue;
+		for (auto Waitable : Ready) {
+			if (Waitable == &_WakeEvent) continue;
+			TWatch *Watch = static_cast<TWatch*>(Waitable);
+			// Skip watches cancelled by an earlier callback of this round
+			if (_Watches.find(Watch->Token) != _Watches.end()) Watch->Handler();
+		}
+		_Retired.clear();
+	}
+}
+
+void TReactor::Stop(void) {
+	_Stopping = 1;
+	_WakeEvent.Set();
+}
+
+#endif
@@ -0,0 +1,189 @@
+/*
+Copyright (c) 2005 - 2017, Zhenyu Wu; 2012 - 2017, NEC Labs America Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of ZWUtils-VCPP nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @addtogroup Threading Threading Support Utilities
+ * @file
+ * @brief Single-threaded Reactor
+ **/
+
+#ifndef ZWUtils_Reactor_H
+#define ZWUtils_Reactor_H
+
+ // Project global control 
+#include "Misc/Global.h"
+
+#include "Misc/TString.h"
+#include "Misc/Timing.h"
+
+#include "Memory/ManagedRef.h"
+
+#include "SyncElements.h"
+#include "SyncObjects.h"
+#include "SyncContainers.h"
+
+#include <functional>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+#ifdef __ZWUTILS_SYNC_WAITSET
+
+/**
+ * @ingroup Threading
+ * @brief Single-threaded event loop
+ *
+ * Runs waitable readiness callbacks, queue content callbacks, deadline timers and posted closures on one thread
+ * - Registrations can be made from any thread, they take effect on the loop thread
+ * - Cancellation on the loop thread (e.g. from a callback) is immediate, otherwise a callback may still run once
+ * - Exceptions escaping from a callback terminate Run()
+ * - Timers run on the monotonic clock, wall clock adjustments do not move them
+ **/
+class TReactor {
+	typedef TReactor _this;
+
+public:
+	typedef unsigned long long TToken;
+	typedef std::function<void(void)> TClosure;
+
+protected:
+	class TWatch : public THandleWaitable, public ManagedObj {
+	public:
+		TToken const Token;
+		TClosure const Handler;
+
+		TWatch(THandleWaitable &&xWaitable, TToken xToken, TClosure const &xHandler) :
+			THandleWaitable(std::move(xWaitable)), Token(xToken), Handler(xHandler) {}
+	};
+	typedef ManagedRef<TWatch> MRWatch;
+
+	typedef std::multimap<TMonotonicStamp, std::pair<TToken, TAlarmCallback>> TSchedule;
+
+	MRWaitSet _WaitSet;
+	TEvent _WakeEvent;
+	TInterlockedOrdinal64<TToken> _NextToken = 0;
+	TInterlockedOrdinal32<DWORD> _LoopThread = 0;
+	TInterlockedOrdinal32<long> _Stopping = 0;
+	TSyncObj<std::vector<TClosure>> _Posted;
+
+	// Only accessed on the loop thread
+	std::unordered_map<TToken, MRWatch> _Watches;
+	std::vector<MRWatch> _Retired;
+	TSchedule _Schedule;
+	std::unordered_map<TToken, TSchedule::iterator> _Timers;
+
+	bool __OnLoop(void) const {
+		return ~_LoopThread == GetCurrentThreadId();
+	}
+
+	void __Dispatch(TClosure const &Closure) {
+		if (__OnLoop()) Closure();
+		else Post(Closure);
+	}
+
+	TToken __Watch(THandleWaitable &&Waitable, TClosure const &Handler);
+	void __Cancel(TToken Token);
+
+	void __RunPosted(void);
+	void __RunTimers(void);
+	WAITTIME __NextTimeout(void);
+
+public:
+	TReactor(void);
+	~TReactor(void);
+
+	// Copy and move constructions are hard to reason, therefore better disable it
+	TReactor(_this const &) = delete;
+	TReactor(_this &&) = delete;
+	_this& operator=(_this const &) = delete;
+	_this& operator=(_this &&) = delete;
+
+	/**
+	 * Call handler whenever the waitable is signaled
+	 * @note A level-triggered signal (e.g. manual-reset event) is reported on every loop iteration until reset
+	 **/
+	TToken Watch(THandleWaitable &Waitable, TClosure const &Handler) {
+		return __Watch(Waitable.DupWaitable(), Handler);
+	}
+
+	/**
+	 * Call handler whenever the queue has content, the handler is expected to drain it
+	 **/
+	template<class T, class P>
+	TToken WatchContent(TSyncBlockingDeque<T, P> &Queue, TClosure const &Handler) {
+		return __Watch(Queue.ContentWaitable(), Handler);
+	}
+
+	/**
+	 * Call back once at a deadline
+	 * @note The callback receives the due time on the wall clock, as of when it runs
+	 **/
+	TToken Schedule(TDeadline const &Deadline, TAlarmCallback const &Callback);
+
+	/**
+	 * Call back once after a duration
+	 **/
+	TToken Schedule(TimeSpan const &Duration, TAlarmCallback const &Callback) {
+		return Schedule(TDeadline(Duration), Callback);
+	}
+
+	/**
+	 * Call back once at a wall clock time, the offset from now is captured once
+	 **/
+	TToken Schedule(TimeStamp const &Clock, TAlarmCallback const &Callback) {
+		return Schedule(TDeadline(Clock), Callback);
+	}
+
+	/**
+	 * Cancel a watch or a timer
+	 **/
+	void Cancel(TToken Token) {
+		__Dispatch([=] { __Cancel(Token); });
+	}
+
+	/**
+	 * Run a closure on the loop thread
+	 **/
+	void Post(TClosure const &Closure);
+
+	/**
+	 * Run the event loop on the calling thread, until stopped
+	 **/
+	void Run(void);
+
+	/**
+	 * Signal the event loop to return
+	 **/
+	void Stop(void);
+};
+
+#endif
+
+#endif
@@ -43,41 +43,158 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Misc/Global.h"
 
 #include "Misc/TString.h"
+#include "Misc/Histogram.h"
 
 #include "Debug/Debug.h"
 #include "Debug/Exception.h"
+#include "Debug/Logging.h"
+#include "Debug/FlightRecorder.h"
 
 #include "SyncElements.h"
 #include "SyncObjects.h"
 
 #include <deque>
-
-// Lite version performs 20% better in low contention scenario, via bypassing SyncObj layer
-#define __SDQ_LITE
+#include <type_traits>
 
 #define __SDQ_SYNCSPIN	DEFAULT_CRITICALSECTION_SPIN
 
-// Enables iterator access to the underlying deque
-// - The queue must be Push+Pop locked, otherwise iterators do not make sense (iterating a changing deque?)
-#define __SDQ_ITERATORS
+// Iterator support modes, selected by the queue policy
+struct __SDQIter_None {};
+struct __SDQIter_Const {};
+struct __SDQIter_Exclusive {};
+struct __SDQIter_Shared {};
+
+/**
+ * @ingroup Threading
+ * @brief Synchronized queue feature policy
+ *
+ * Selects at compile time which features a queue instance pays for
+ * - Lite: Bypass the SyncObj layer, performs 20% better in low contention scenario
+ * - Iterators: Enables iterator access to the underlying deque
+ *     The queue must be Push+Pop locked, otherwise iterators do not make sense (iterating a changing deque?)
+ * - MutableIterators: Enables mutable iterator access to the underlying deque
+ *     If disabled, only const iterators will be available, and they are concurrently avaiable to all threads;
+ *     If enabled, without concurrent const iterator support, any iterator will only be available to one thread at a time.
+ * - ConcurrentConstIterators: Enables concurrent const iterator support
+ *     Mutable iterators will only be available to one thread at a time, while const iterators will be
+ *     concurrently avaiable to all threads *when there are no active mutable iterator(s)*;
+ *     When an active mutable iterator present, only thread that owns it will have concurrent access to const
+ *     iterators, all other threads have to wait to access either mutable or const iterators.
+ **/
+template<bool xLite, bool xIterators, bool xMutableIterators, bool xConcurrentConstIterators>
+struct TSDQPolicy {
+	static_assert(xIterators || !xMutableIterators, "Mutable iterators require iterator support");
+	static_assert(xMutableIterators || !xConcurrentConstIterators, "Concurrent const iterators require mutable iterator support");
+
+	static bool const Lite = xLite;
+	static bool const Iterators = xIterators;
+	static bool const MutableIterators = xMutableIterators;
+	static bool const ConcurrentConstIterators = xConcurrentConstIterators;
+
+	typedef typename std::conditional<!xIterators, __SDQIter_None,
+		typename std::conditional<!xMutableIterators, __SDQIter_Const,
+		typename std::conditional<!xConcurrentConstIterators, __SDQIter_Exclusive,
+		__SDQIter_Shared>::type>::type>::type TIterMode;
+};
+
+//! Plain FIFO queue, just a lock and a deque
+typedef TSDQPolicy<true, false, false, false> TSDQPolicy_FIFO;
+//! Const iterators only, shared across all threads
+typedef TSDQPolicy<true, true, false, false> TSDQPolicy_ConstIter;
+//! Mutable and const iterators, available to one thread at a time
+typedef TSDQPolicy<true, true, true, false> TSDQPolicy_ExclusiveIter;
+//! Mutable iterators for one thread at a time, const iterators shared when no mutable one is active
+typedef TSDQPolicy<true, true, true, true> TSDQPolicy_SharedIter;
+
+// Queue storage, with or without the SyncObj layer
+template<class Container, bool Lite>
+class __TSDQStore;
+
+template<class Container>
+class __TSDQStore<Container, true> {
+protected:
+	TLockableCS _Sync;
+	Container _Queue;
+
+public:
+	typedef Container* TAccessor;
+
+	TLockable::TLock Lock(void) {
+		return _Sync.Lock();
+	}
+
+	TAccessor Pickup(void) {
+		return _Sync.Acquire(), &_Queue;
+	}
 
-#ifdef __SDQ_ITERATORS
-// Enables mutable iterator access to the underlying deque
-// - If disabled, only const iterators will be available, and they are concurrently avaiable to all threads;
-// - If enabled, without concurrent const iterator support, any iterator will only be available to one thread at a time.
-#define __SDQ_MUTABLE_ITERATORS
+	TAccessor TryPickup(void) {
+		return _Sync.TryAcquire() ? &_Queue : nullptr;
+	}
 
-#ifdef __SDQ_MUTABLE_ITERATORS
-// Enables concurrent const iterator support
-// - If enabled, mutable iterators will only be available to one thread at a time, while const iterators will be
-//     concurrently avaiable to all threads *when there are no active mutable iterator(s)*;
-//     * When an active mutable iterator present, only thread that owns it will have concurrent access to const
-//       iterators, all other threads have to wait to access either mutable or const iterators.
-#define __SDQ_CONCURRENT_CONST_ITERATORS
+	TAccessor NullAccessor(void) {
+		return nullptr;
+	}
 
-#endif //__SDQ_MUTABLE_ITERATORS
+	void Leave(void) {
+		_Sync.Release();
+	}
+};
 
-#endif //__SDQ_ITERATORS
+template<class Container>
+class __TSDQStore<Container, false> {
+protected:
+	typedef TSyncObj<Container> TSyncDeque;
+	TSyncDeque SyncDeque;
+
+public:
+	typedef typename TSyncDeque::Accessor TAccessor;
+
+	TLockable::TLock Lock(void) {
+		return SyncDeque.Lock();
+	}
+
+	TAccessor Pickup(void) {
+		return SyncDeque.Pickup();
+	}
+
+	TAccessor TryPickup(void) {
+		return SyncDeque.TryPickup(__SDQ_SYNCSPIN);
+	}
+
+	TAccessor NullAccessor(void) {
+		return SyncDeque.NullAccessor();
+	}
+
+	void Leave(void) {
+		// Accessor releases the lock on destruction
+	}
+};
+
+// Iterator synchronization, per iterator support mode
+template<class IterMode>
+struct __TSDQIterSync;
+
+template<>
+struct __TSDQIterSync<__SDQIter_None> {};
+
+template<>
+struct __TSDQIterSync<__SDQIter_Const> {};
+
+template<>
+struct __TSDQIterSync<__SDQIter_Exclusive> {
+	TLockableCS ExclusiveSync;
+};
+
+#ifdef __ZWUTILS_SYNC_SLIMRWLOCK
+template<>
+struct __TSDQIterSync<__SDQIter_Shared> {
+	TLockableSRW SRWSync;
+	TInterlockedArchInt IterWaiters = 0;
+	TEvent IterWaitEvent = TEvent(CONSTRUCTION::DEFER);
+};
+#else
+// Lack of slim RW lock support, cannot support mutable iterators + concurrent const iterators!
+#endif
 
 /**
  * @ingroup Threading
@@ -86,17 +203,17 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * Synchronized blocking double-ended queue with no upper limit
  * Note: Currently implementation does not have faireness guarantee
  **/
-template<class T>
+template<class T, class P = TSDQPolicy_FIFO>
 class TSyncBlockingDeque : public TLockable, public TWaitable {
-	typedef TSyncBlockingDeque<T> _this;
+	typedef TSyncBlockingDeque<T, P> _this;
 	typedef std::deque<T> Container;
+	typedef typename P::TIterMode TIterMode;
 
-#ifdef __SDQ_ITERATORS
 protected:
 	template<class Iter>
 	class __Locked_Iterator : public Iter {
 		typedef __Locked_Iterator<Iter> _this;
-		friend class TSyncBlockingDeque<T>;
+		friend class TSyncBlockingDeque<T, P>;
 
 	protected:
 		MRLock _LockRef;
@@ -123,35 +240,23 @@ protected:
 
 		bool Valid(void) { return !_LockRef.Empty() && *_LockRef; }
 	};
-#endif // __SDQ_ITERATORS
 
 public:
 	using size_type = typename Container::size_type;
 
-#ifdef __SDQ_ITERATORS
-
-#ifdef __SDQ_MUTABLE_ITERATORS
 	typedef __Locked_Iterator<typename Container::iterator> iterator;
 	typedef __Locked_Iterator<typename Container::reverse_iterator> reverse_iterator;
-#endif
 	typedef __Locked_Iterator<typename Container::const_iterator> const_iterator;
 	typedef __Locked_Iterator<typename Container::const_reverse_iterator> const_reverse_iterator;
-#endif // __SDQ_ITERATORS
 
 protected:
 	volatile bool __Cleanup = false;
 	//volatile __ARC_INT PopWaiters = 0;
 	//volatile __ARC_INT EmptyWaiters = 0;
 
-#ifdef __SDQ_LITE
-	TLockableCS _Sync;
-	Container _Queue;
-	typedef Container* TQueueAccessor;
-#else
-	typedef TSyncObj<Container> TSyncDeque;
-	typedef typename TSyncDeque::Accessor TQueueAccessor;
-	TSyncDeque SyncDeque;
-#endif
+	typedef __TSDQStore<Container, P::Lite> TQueueStore;
+	typedef typename TQueueStore::TAccessor TQueueAccessor;
+	TQueueStore _Store;
 
 	typedef TInterlockedOrdinal32<long> TSyncCounter;
 	TSyncCounter PushHold = 0;
@@ -163,52 +268,30 @@ protected:
 	TEvent EmptyWait = { true, true };
 	TEvent ContentWait = { true, false };
 
-#if defined(__SDQ_ITERATORS) && defined(__SDQ_MUTABLE_ITERATORS)
+	THistogram *_PopWaits = nullptr;
 
-#ifdef __SDQ_CONCURRENT_CONST_ITERATORS
-#ifdef __ZWUTILS_SYNC_SLIMRWLOCK
-	TLockableSRW SRWSync;
-	TInterlockedArchInt IterWaiters = 0;
-	TEvent IterWaitEvent = TEvent(CONSTRUCTION::DEFER);
-#else
-#error Lack of slim RW lock support, cannot support mutable iterators + concurrent const iterators!
-#endif
-#else
-#pragma WARNING("Iterator concurrency not enabled, iterators will be available to one thread at a time!")
-	TLockableCS ExclusiveSync;
-#endif
-
-#endif // __SDQ_ITERATORS && __SDQ_MUTABLE_ITERATORS
+	__TSDQIterSync<TIterMode> _IterSync;
 
 	class TSDQBaseLockInfo : public TLockInfo {
 	public:
-		bool const Push, Pop;
-		TSDQBaseLockInfo(bool xPush, bool xPop) : Push(xPush), Pop(xPop) {}
-#ifdef __SDQ_MUTABLE_ITERATORS
-		virtual ~TSDQBaseLockInfo(void) {}
-#endif
+		bool const Push, Pop, Dynamic;
+		TSDQBaseLockInfo(bool xPush, bool xPop, bool xDynamic = false) :
+			Push(xPush), Pop(xPop), Dynamic(xDynamic) {}
 	};
 
 	static TSDQBaseLockInfo __PushLockInfo;
 	static TSDQBaseLockInfo __PopLockInfo;
+	static TSDQBaseLockInfo __PushPopLockInfo;
 
-#ifdef __SDQ_ITERATORS
-	template<class Iter>
-	using FCIterGetter = Iter(Container::*)(void) const;
-
-#ifdef __SDQ_MUTABLE_ITERATORS
-	template<class Iter>
-	using FMIterGetter = Iter(Container::*)(void);
-
-#ifdef __SDQ_CONCURRENT_CONST_ITERATORS
-#ifdef __ZWUTILS_SYNC_SLIMRWLOCK
+	// Dynamically allocated lock info, only handed out by mutable iterator policies
 	class TSDQDynamicLockInfo : public TSDQBaseLockInfo {
 	protected:
-		TSDQDynamicLockInfo(bool xPush, bool xPop) : TSDQBaseLockInfo(xPush, xPop) {}
+		TSDQDynamicLockInfo(bool xPush, bool xPop) : TSDQBaseLockInfo(xPush, xPop, true) {}
 	public:
-		virtual void __Release(TSyncBlockingDeque<T> &SDQueue) {};
+		virtual ~TSDQDynamicLockInfo(void) {}
 	};
 
+	// Shared iterator mode: push-pop lock tracking the linked iterator locks
 	class TSDQPushPopLockInfo : public TSDQDynamicLockInfo {
 	public:
 		TLock * _SharedLock = nullptr;
@@ -217,6 +300,7 @@ protected:
 		TSDQPushPopLockInfo(void) : TSDQDynamicLockInfo(true, true) {}
 	};
 
+	// Shared iterator mode: iterator lock linked to a push-pop lock
 	class TSDQIterLockInfo : public TSDQDynamicLockInfo {
 	public:
 		MRLock _IterLock;
@@ -227,79 +311,91 @@ protected:
 			_IterLock(CONSTRUCTION::EMPLACE, std::move(xIterLock)),
 			_SDQLock(&xSDQLock) {}
 
-		void __Release(TSyncBlockingDeque<T> &SDQueue) override;
+		void __Release(TSyncBlockingDeque<T, P> &SDQueue);
 	};
 
-	TSDQPushPopLockInfo* __PushPopLock_Check(TLock const &Lock) const;
-
-	void __Lock_Demote(TSDQPushPopLockInfo *LockInfo, bool isExclusive);
-
-	MRLock __GetExclusiveIterLock(TLock& BaseLock, TSDQPushPopLockInfo *LockInfo, WAITTIME Timeout, THandleWaitable *AbortEvent);
-	MRLock __GetSharedIterLock(TLock& BaseLock, TSDQPushPopLockInfo *LockInfo, WAITTIME Timeout, THandleWaitable *AbortEvent);
-
-#else
-#error Unimplemented sharing support!
-#endif
-
-#else
-	class TSDQDynamicLockInfo : public TSDQBaseLockInfo {
+	// Exclusive iterator mode: iterator lock holding on to the push-pop lock
+	class TSDQExclusiveLockInfo : public TSDQDynamicLockInfo {
 	protected:
 		MRLock _IterLock;
 		MRLock _SDQLock;
 	public:
-		TSDQDynamicLockInfo(TLock &&xIterLock, MRLock &xSDQLock) :
-			TSDQBaseLockInfo(false, false),
+		TSDQExclusiveLockInfo(TLock &&xIterLock, MRLock &xSDQLock) :
+			TSDQDynamicLockInfo(false, false),
 			_IterLock(CONSTRUCTION::EMPLACE, std::move(xIterLock)),
 			_SDQLock(xSDQLock) {}
 	};
 
-	static TSDQBaseLockInfo __PushPopLockInfo;
-	void __PushPopLock_Check(TLock const &Lock) const;
-#endif
+	template<class Iter>
+	using FCIterGetter = Iter(Container::*)(void) const;
+
+	template<class Iter>
+	using FMIterGetter = Iter(Container::*)(void);
 
+	TSDQBaseLockInfo* __PushPopLock_Check(TLock const &Lock) const;
+
+	void __Lock_Demote(TSDQPushPopLockInfo *LockInfo, bool isExclusive);
+
+	MRLock __GetExclusiveIterLock(TLock& BaseLock, TSDQPushPopLockInfo *LockInfo, TDeadline const &Deadline, THandleWaitable *AbortEvent);
+	MRLock __GetSharedIterLock(TLock& BaseLock, TSDQPushPopLockInfo *LockInfo, TDeadline const &Deadline, THandleWaitable *AbortEvent);
 
 	template<class Iter>
 	__Locked_Iterator<Iter> __Create_Iterator(FCIterGetter<Iter> const &IterGetter, MRLock &LockRef,
-											  WAITTIME Timeout, THandleWaitable *AbortEvent) const;
+											  TDeadline const &Deadline, THandleWaitable *AbortEvent, __SDQIter_Const const&) const;
+
+	template<class Iter>
+	__Locked_Iterator<Iter> __Create_Iterator(FCIterGetter<Iter> const &IterGetter, MRLock &LockRef,
+											  TDeadline const &Deadline, THandleWaitable *AbortEvent, __SDQIter_Exclusive const&) const;
 
 	template<class Iter>
 	__Locked_Iterator<Iter> __Create_Iterator(FMIterGetter<Iter> const &IterGetter, MRLock &LockRef,
-											  WAITTIME Timeout, THandleWaitable *AbortEvent);
-#else 
-	static TSDQBaseLockInfo __PushPopLockInfo;
-	void __PushPopLock_Check(TLock const &Lock) const;
+											  TDeadline const &Deadline, THandleWaitable *AbortEvent, __SDQIter_Exclusive const&);
 
 	template<class Iter>
-	__Locked_Iterator<Iter> __Create_Iterator(FCIterGetter<Iter> const &IterGetter, MRLock &LockRef) const;
-#endif
+	__Locked_Iterator<Iter> __Create_Iterator(FCIterGetter<Iter> const &IterGetter, MRLock &LockRef,
+											  TDeadline const &Deadline, THandleWaitable *AbortEvent, __SDQIter_Shared const&) const;
 
-#else
-	static TSDQBaseLockInfo __PushPopLockInfo;
-#endif // __SDQ_ITERATORS
+	template<class Iter>
+	__Locked_Iterator<Iter> __Create_Iterator(FMIterGetter<Iter> const &IterGetter, MRLock &LockRef,
+											  TDeadline const &Deadline, THandleWaitable *AbortEvent, __SDQIter_Shared const&);
+
+	TLockInfo* __New_PushPopLockInfo(__SDQIter_Shared const&) {
+		return DEFAULT_NEW(TSDQPushPopLockInfo);
+	}
+
+	template<class IterMode>
+	TLockInfo* __New_PushPopLockInfo(IterMode const&) {
+		return &__PushPopLockInfo;
+	}
+
+	void __Release_Dynamic(TSDQDynamicLockInfo *LockInfo, __SDQIter_Shared const&) {
+		if (!LockInfo->Push) static_cast<TSDQIterLockInfo*>(LockInfo)->__Release(*this);
+		DEFAULT_DESTROY(TSDQDynamicLockInfo, LockInfo);
+	}
+
+	template<class IterMode>
+	void __Release_Dynamic(TSDQDynamicLockInfo *LockInfo, IterMode const&) {
+		DEFAULT_DESTROY(TSDQDynamicLockInfo, LockInfo);
+	}
 
 	void __Lock_Sanity(TLock const &Lock) const;
 	void __Unlock(TLockInfo *LockInfo) override;
 
 	TLock __Accessor_Sync(void) {
-#ifdef __SDQ_LITE
-		return _Sync.Lock();
-#else
-		return SyncDeque.Lock();
-#endif
+		return _Store.Lock();
 	}
 
-	static WaitResult __WaitFor_Event(TEvent &Event, TimeStamp &EntryTS, WAITTIME &Timeout, THandleWaitable *AbortEvent);
-
 	TQueueAccessor __Accessor_Pickup_Safe(void);
-	TQueueAccessor __Accessor_Pickup_Gated(TSyncCounter &Hold, TEvent &Sync, TimeStamp &EntryTS,
-										   WAITTIME &Timeout, THandleWaitable *AbortEvent);
-
-#define __Impl__Push(method)					\
-	if (Accessor->empty()) {					\
-		EmptyWait.Reset();						\
-		ContentWait.Set();						\
-	}											\
-	Accessor->method;							\
+	TQueueAccessor __Accessor_Pickup_Gated(TSyncCounter &Hold, TEvent &Sync,
+										   TDeadline const &Deadline, THandleWaitable *AbortEvent);
+
+#define __Impl__Push(method)							\
+	if (Accessor->empty()) {							\
+		EmptyWait.Reset();								\
+		ContentWait.Set();								\
+	}													\
+	Accessor->method;									\
+	FLIGHTREC("SyncDQ Push", this, Accessor->size());	\
 	return Accessor->size();
 
 	size_type __Push_Front(TQueueAccessor &Accessor, T const &entry) {
@@ -318,12 +414,13 @@ protected:
 		__Impl__Push(push_back(std::move(entry)));
 	}
 
-#define __Impl__Pop(dir)						\
-	entry = std::move(Accessor->dir());			\
-	Accessor->pop_##dir();						\
-	if (Accessor->empty()) {					\
-		EmptyWait.Set();						\
-		ContentWait.Reset();					\
+#define __Impl__Pop(dir)								\
+	entry = std::move(Accessor->dir());					\
+	Accessor->pop_##dir();								\
+	FLIGHTREC("SyncDQ Pop", this, Accessor->size());	\
+	if (Accessor->empty()) {							\
+		EmptyWait.Set();								\
+		ContentWait.Reset();							\
 	}
 
 	void __Pop_Front(TQueueAccessor &Accessor, T &entry) {
@@ -341,6 +438,14 @@ public:
 	TSyncBlockingDeque(TString &&xName) : Name(std::move(xName)) {}
 	~TSyncBlockingDeque(void) override;
 
+	/**
+	 * Record the time each blocking pop spends waiting into the histogram (nullptr to stop)
+	 * @note Pops that find content right away are not recorded
+	 **/
+	void RecordPopWaits(THistogram *Histogram) {
+		_PopWaits = Histogram;
+	}
+
 	TLock Lock_Push(void) {
 		if (!PushHold++) PushWait.Reset();
 		return __New_Lock(&__PushLockInfo);
@@ -354,11 +459,7 @@ public:
 	TLock Lock_PushPop(void) {
 		if (!PushHold++) PushWait.Reset();
 		if (!PopHold++) PopWait.Reset();
-#if defined(__SDQ_ITERATORS) && defined(__SDQ_MUTABLE_ITERATORS) && defined(__SDQ_CONCURRENT_CONST_ITERATORS)
-		return __New_Lock(DEFAULT_NEW(TSDQPushPopLockInfo));
-#else
-		return __New_Lock(&__PushPopLockInfo);
-#endif // __SDQ_ITERATORS && __SDQ_MUTABLE_ITERATORS && __SDQ_CONCURRENT_CONST_ITERATORS
+		return __New_Lock(__New_PushPopLockInfo(TIterMode()));
 	}
 
 	void Sync(TLock const &Lock) {
@@ -389,111 +490,146 @@ public:
 		return ContentWait.DupWaitable();
 	}
 
-#ifdef __SDQ_ITERATORS
-
-#ifdef __SDQ_MUTABLE_ITERATORS
-	// Mutable iterators are available for a thread at a time
-	iterator begin(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr);
-	iterator end(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr);
-	reverse_iterator rbegin(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr);
-	reverse_iterator rend(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr);
+	// Mutable iterators are available for a thread at a time (requires policy MutableIterators)
+	iterator begin(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
+		return begin(PushPopLock, TDeadline(Timeout), AbortEvent);
+	}
+	iterator begin(MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
+	iterator end(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
+		return end(PushPopLock, TDeadline(Timeout), AbortEvent);
+	}
+	iterator end(MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
+	reverse_iterator rbegin(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
+		return rbegin(PushPopLock, TDeadline(Timeout), AbortEvent);
+	}
+	reverse_iterator rbegin(MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
+	reverse_iterator rend(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
+		return rend(PushPopLock, TDeadline(Timeout), AbortEvent);
+	}
+	reverse_iterator rend(MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
 
 	iterator erase(iterator &Iter);
 	iterator insert(iterator &Iter, T const &Val);
 	reverse_iterator erase(reverse_iterator &Iter);
 	reverse_iterator insert(reverse_iterator &Iter, T const &Val);
 
-#ifdef __SDQ_CONCURRENT_CONST_ITERATORS
-	// Constant iterators are shared across all threads, block/by mutable iterators
-#else
-	// Constant iterators are available for a thread at a time
-#endif
-	const_iterator cbegin(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) const;
-	const_iterator cend(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) const;
-	const_reverse_iterator crbegin(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) const;
-	const_reverse_iterator crend(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) const;
-#else
-	// Constant iterators are shared across all threads
-	const_iterator cbegin(MRLock &PushPopLock) const;
-	const_iterator cend(MRLock &PushPopLock) const;
-	const_reverse_iterator crbegin(MRLock &PushPopLock) const;
-	const_reverse_iterator crend(MRLock &PushPopLock) const;
-#endif
-
-#endif // __SDQ_ITERATORS
+	// Constant iterators (requires policy Iterators)
+	// - Without mutable iterators, shared across all threads (Timeout and AbortEvent are not used)
+	// - With concurrent const iterators, shared across all threads, block/by mutable iterators
+	// - Otherwise, available for a thread at a time
+	const_iterator cbegin(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) const {
+		return cbegin(PushPopLock, TDeadline(Timeout), AbortEvent);
+	}
+	const_iterator cbegin(MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) const;
+	const_iterator cend(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) const {
+		return cend(PushPopLock, TDeadline(Timeout), AbortEvent);
+	}
+	const_iterator cend(MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) const;
+	const_reverse_iterator crbegin(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) const {
+		return crbegin(PushPopLock, TDeadline(Timeout), AbortEvent);
+	}
+	const_reverse_iterator crbegin(MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) const;
+	const_reverse_iterator crend(MRLock &PushPopLock, WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) const {
+		return crend(PushPopLock, TDeadline(Timeout), AbortEvent);
+	}
+	const_reverse_iterator crend(MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) const;
 
 	/**
 	 * Put an object into the queue-front
 	 **/
 	size_type Push_Front(T const &entry, WAITTIME const &Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
-		WAITTIME _Timeout = Timeout;
-		return Push_Front(entry, _Timeout, AbortEvent);
+		return Push_Front(entry, TDeadline(Timeout), AbortEvent);
 	}
 	size_type Push_Front(T &&entry, WAITTIME const &Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
-		WAITTIME _Timeout = Timeout;
-		return Push_Front(std::move(entry), _Timeout, AbortEvent);
+		return Push_Front(std::move(entry), TDeadline(Timeout), AbortEvent);
+	}
+	size_type Push_Front(T const &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr) {
+		TDeadline Deadline(Timeout);
+		auto Ret = Push_Front(entry, Deadline, AbortEvent);
+		return Timeout = Deadline.Remaining(), Ret;
 	}
-	size_type Push_Front(T const &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr);
-	size_type Push_Front(T &&entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr);
+	size_type Push_Front(T &&entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr) {
+		TDeadline Deadline(Timeout);
+		auto Ret = Push_Front(std::move(entry), Deadline, AbortEvent);
+		return Timeout = Deadline.Remaining(), Ret;
+	}
+	size_type Push_Front(T const &entry, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
+	size_type Push_Front(T &&entry, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
 
 	/**
 	 * Put an object into the queue-back
 	 **/
 	size_type Push_Back(T const &entry, WAITTIME const &Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
-		WAITTIME _Timeout = Timeout;
-		return Push_Back(entry, _Timeout, AbortEvent);
+		return Push_Back(entry, TDeadline(Timeout), AbortEvent);
 	}
 	size_type Push_Back(T &&entry, WAITTIME const &Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
-		WAITTIME _Timeout = Timeout;
-		return Push_Back(std::move(entry), _Timeout, AbortEvent);
+		return Push_Back(std::move(entry), TDeadline(Timeout), AbortEvent);
+	}
+	size_type Push_Back(T const &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr) {
+		TDeadline Deadline(Timeout);
+		auto Ret = Push_Back(entry, Deadline, AbortEvent);
+		return Timeout = Deadline.Remaining(), Ret;
 	}
-	size_type Push_Back(T const &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr);
-	size_type Push_Back(T &&entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr);
+	size_type Push_Back(T &&entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr) {
+		TDeadline Deadline(Timeout);
+		auto Ret = Push_Back(std::move(entry), Deadline, AbortEvent);
+		return Timeout = Deadline.Remaining(), Ret;
+	}
+	size_type Push_Back(T const &entry, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
+	size_type Push_Back(T &&entry, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
 
 	/**
 	 * Try get an object from the queue-front with given timeout
 	 **/
 	bool Pop_Front(T &entry, WAITTIME const &Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
-		WAITTIME _Timeout = Timeout;
-		return Pop_Front(entry, _Timeout, AbortEvent);
+		return Pop_Front(entry, TDeadline(Timeout), AbortEvent);
+	}
+	bool Pop_Front(T &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr) {
+		TDeadline Deadline(Timeout);
+		auto Ret = Pop_Front(entry, Deadline, AbortEvent);
+		return Timeout = Deadline.Remaining(), Ret;
 	}
-	bool Pop_Front(T &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr);
+	bool Pop_Front(T &entry, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
 
 	/**
 	 * Try get an object from the queue-back with given timeout
 	 **/
 	bool Pop_Back(T &entry, WAITTIME const &Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
-		WAITTIME _Timeout = Timeout;
-		return Pop_Back(entry, _Timeout, AbortEvent);
+		return Pop_Back(entry, TDeadline(Timeout), AbortEvent);
+	}
+	bool Pop_Back(T &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr) {
+		TDeadline Deadline(Timeout);
+		auto Ret = Pop_Back(entry, Deadline, AbortEvent);
+		return Timeout = Deadline.Remaining(), Ret;
 	}
-	bool Pop_Back(T &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr);
+	bool Pop_Back(T &entry, TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
 
 	/**
 	 * Return the instantaneous length of the queue
 	 **/
 	size_type Length(void) const {
 		auto Ret = (const_cast<_this*>(this)->__Accessor_Pickup_Safe())->size();
-#ifdef __SDQ_LITE
-		(*const_cast<_this*>(this)->_Sync).Leave();
-#endif
+		const_cast<_this*>(this)->_Store.Leave();
 		return Ret;
 	}
 
 	void Deflate(void) const {
 		(const_cast<_this*>(this)->__Accessor_Pickup_Safe())->shrink_to_fit();
-#ifdef __SDQ_LITE
-		(*const_cast<_this*>(this)->_Sync).Leave();
-#endif
+		const_cast<_this*>(this)->_Store.Leave();
 	}
 
 	/**
 	 * Try waiting for queue to become empty and hold lock on the queue
 	 **/
 	TLock DrainAndLock(WAITTIME const &Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
-		WAITTIME _Timeout = Timeout;
-		return DrainAndLock(_Timeout, AbortEvent);
+		return DrainAndLock(TDeadline(Timeout), AbortEvent);
 	}
-	TLock DrainAndLock(WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr);
+	TLock DrainAndLock(WAITTIME &Timeout, THandleWaitable *AbortEvent = nullptr) {
+		TDeadline Deadline(Timeout);
+		auto Ret = DrainAndLock(Deadline, AbortEvent);
+		return Timeout = Deadline.Remaining(), std::move(Ret);
+	}
+	TLock DrainAndLock(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
 
 	WaitResult WaitFor(WAITTIME Timeout) const override {
 		return ContentWait.WaitFor(Timeout);
@@ -512,8 +648,8 @@ class TSyncBlockingDequeException : public Exception {
 public:
 	TString const ContainerName;
 
-	template <typename T, typename... Params>
-	TSyncBlockingDequeException(TSyncBlockingDeque<T> const &xContainer, TString &&xSource,
+	template <typename T, typename P, typename... Params>
+	TSyncBlockingDequeException(TSyncBlockingDeque<T, P> const &xContainer, TString &&xSource,
 								LPCTSTR ReasonFmt, Params&&... xParams) :
 		Exception(std::move(xSource), ReasonFmt, std::forward<Params>(xParams)...), ContainerName(xContainer.Name) {}
 
@@ -546,90 +682,68 @@ public:
 }
 
 //! Perform logging within a synchronized queue
-#define SDQLOG(s, ...) LOG(SDQLogHeader s, Name.c_str(), __VA_ARGS__)
-#define SDQLOGV(s, ...) LOGV(SDQLogHeader s, Name.c_str(), __VA_ARGS__)
-#define SDQLOGVV(s, ...) LOGVV(SDQLogHeader s, Name.c_str(), __VA_ARGS__)
+extern TLogModule LOGMODULE_SYNCDQ;
 
-#define DESTRUCTION_MESSAGE _T("Destruction in progress...")
+#define SDQLOG(s, ...) MLOG(LOGMODULE_SYNCDQ, SDQLogHeader s, Name.c_str(), __VA_ARGS__)
+#define SDQLOGV(s, ...) MLOGV(LOGMODULE_SYNCDQ, SDQLogHeader s, Name.c_str(), __VA_ARGS__)
+#define SDQLOGVV(s, ...) MLOGVV(LOGMODULE_SYNCDQ, SDQLogHeader s, Name.c_str(), __VA_ARGS__)
 
-template<class T>
-typename TSyncBlockingDeque<T>::TSDQBaseLockInfo TSyncBlockingDeque<T>::__PushLockInfo = { true,false };
+#define SDQ_WARNLOG_RATE	10
 
-template<class T>
-typename TSyncBlockingDeque<T>::TSDQBaseLockInfo TSyncBlockingDeque<T>::__PopLockInfo = { false,true };
+#define DESTRUCTION_MESSAGE _T("Destruction in progress...")
 
-#ifdef __SDQ_ITERATORS
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::TSDQBaseLockInfo TSyncBlockingDeque<T, P>::__PushLockInfo = { true,false };
 
-#if defined(__SDQ_MUTABLE_ITERATORS) && defined(__SDQ_CONCURRENT_CONST_ITERATORS)
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::TSDQBaseLockInfo TSyncBlockingDeque<T, P>::__PopLockInfo = { false,true };
 
-#ifdef __ZWUTILS_SYNC_SLIMRWLOCK
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::TSDQBaseLockInfo TSyncBlockingDeque<T, P>::__PushPopLockInfo = { true,true };
 
-template<class T>
-void TSyncBlockingDeque<T>::TSDQIterLockInfo::__Release(TSyncBlockingDeque<T> &SDQueue) {
-	auto LinkedLockBaseInfo = static_cast<TSDQBaseLockInfo*>(__LockInfo(*_SDQLock));
-	auto LinkedLockInfo = dynamic_cast<TSDQPushPopLockInfo*>(LinkedLockBaseInfo);
-	SDQueue.__Lock_Demote(LinkedLockInfo, SDQueue.SRWSync.ForWrite(*_IterLock));
+template<class T, class P>
+void TSyncBlockingDeque<T, P>::TSDQIterLockInfo::__Release(TSyncBlockingDeque<T, P> &SDQueue) {
+	auto LinkedLockInfo = static_cast<TSDQPushPopLockInfo*>(__LockInfo(*_SDQLock));
+	SDQueue.__Lock_Demote(LinkedLockInfo, SDQueue._IterSync.SRWSync.ForWrite(*_IterLock));
 
 	// Release lock and then send signal if needed
 	_IterLock.Clear();
-	if (~SDQueue.IterWaiters) {
+	if (~SDQueue._IterSync.IterWaiters) {
 		// We are in a transient state of deferred event creation
 		// Just hold the breath for a while
-		while (!SDQueue.IterWaitEvent.Allocated()) SwitchToThread();
-		SDQueue.IterWaitEvent.Set();
+		while (!SDQueue._IterSync.IterWaitEvent.Allocated()) SwitchToThread();
+		SDQueue._IterSync.IterWaitEvent.Set();
 	}
 }
 
-#else
-#error Unimplemented sharing support!
-#endif
-
-#endif
-
-#endif // __SDQ_ITERATORS
-
 #define SDQFAIL(...) __SDQFAIL(*this, __VA_ARGS__)
 
-#ifdef __SDQ_LITE
-#define __SyncLock_RAII		TInitResource<int> __RAII(0, [&](int &) {(*_Sync).Leave(); })
-#define __SyncLock_RAII_C	TInitResource<int> __RAII(0, [&](int &) {(*const_cast<_this*>(this)->_Sync).Leave(); })
-#else
-#define __SyncLock_RAII
-#define __SyncLock_RAII_C
-#endif
-
-#ifdef __SDQ_ITERATORS
+#define __SyncLock_RAII		TInitResource<int> __RAII(0, [&](int &) { _Store.Leave(); })
+#define __SyncLock_RAII_C	TInitResource<int> __RAII(0, [&](int &) { const_cast<_this*>(this)->_Store.Leave(); })
 
-#ifdef __SDQ_MUTABLE_ITERATORS
-
-#ifdef __SDQ_CONCURRENT_CONST_ITERATORS
-
-template<class T>
-typename TSyncBlockingDeque<T>::TSDQPushPopLockInfo*
-TSyncBlockingDeque<T>::__PushPopLock_Check(TLock const &Lock) const {
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::TSDQBaseLockInfo*
+TSyncBlockingDeque<T, P>::__PushPopLock_Check(TLock const &Lock) const {
 	__Lock_Sanity(Lock);
 	TSDQBaseLockInfo *__Info = static_cast<TSDQBaseLockInfo*>(__LockInfo(Lock));
-	auto PushPopLockInfo = dynamic_cast<TSDQPushPopLockInfo*>(__Info);
-	if (!PushPopLockInfo) SDQFAIL(_T("Operation requires a push-pop lock"));
-	return PushPopLockInfo;
+	if (!__Info->Push || !__Info->Pop) SDQFAIL(_T("Operation requires a push-pop lock"));
+	return __Info;
 }
 
-template<class T>
-void TSyncBlockingDeque<T>::__Lock_Demote(TSDQPushPopLockInfo *LockInfo, bool isExclusive) {
+template<class T, class P>
+void TSyncBlockingDeque<T, P>::__Lock_Demote(TSDQPushPopLockInfo *LockInfo, bool isExclusive) {
 	if (isExclusive) {
 		if (LockInfo->_SharedLock) {
 			// Downgrade to shared lock
 			auto QueueLock = __Accessor_Sync();
 			{
-				auto LinkedLockBaseInfo = static_cast<TSDQBaseLockInfo*>(__LockInfo(*LockInfo->_ExclusiveLock));
-				auto LinkedLockInfo = dynamic_cast<TSDQIterLockInfo*>(LinkedLockBaseInfo);
+				auto LinkedLockInfo = static_cast<TSDQIterLockInfo*>(__LockInfo(*LockInfo->_ExclusiveLock));
 				__LockDrop(*LinkedLockInfo->_IterLock);
 			}
-			(*SRWSync).EndWrite();
+			(*_IterSync.SRWSync).EndWrite();
 			{
-				auto LinkedLockBaseInfo = static_cast<TSDQBaseLockInfo*>(__LockInfo(*LockInfo->_SharedLock));
-				auto LinkedLockInfo = dynamic_cast<TSDQIterLockInfo*>(LinkedLockBaseInfo);
-				*LinkedLockInfo->_IterLock = SRWSync.Lock_Read();
+				auto LinkedLockInfo = static_cast<TSDQIterLockInfo*>(__LockInfo(*LockInfo->_SharedLock));
+				*LinkedLockInfo->_IterLock = _IterSync.SRWSync.Lock_Read();
 			}
 		}
 		LockInfo->_ExclusiveLock = nullptr;
@@ -639,8 +753,8 @@ void TSyncBlockingDeque<T>::__Lock_Demote(TSDQPushPopLockInfo *LockInfo, bool is
 }
 
 #define __IMPL_IterLockOp(sync_raii, free_olock, regain_olock_raii, replace_olock, spin_nlock, single_nlock, opname)	\
-	TAllocResource<__ARC_INT> WaitCounter([&] { return IterWaiters++; }, [&](__ARC_INT &) { --IterWaiters; });			\
-	TimeStamp EntryTS;																									\
+	TAllocResource<__ARC_INT> WaitCounter([&] { return _IterSync.IterWaiters++; },										\
+										  [&](__ARC_INT &) { --_IterSync.IterWaiters; });								\
 	while (true) {																										\
 		{																												\
 			sync_raii;																									\
@@ -655,7 +769,7 @@ void TSyncBlockingDeque<T>::__Lock_Demote(TSDQPushPopLockInfo *LockInfo, bool is
 				if (!WaitCounter.Allocated()) {																			\
 					if (*WaitCounter) {																					\
 						/* Check if we are racing against the event object allocation */								\
-						while (!IterWaitEvent.Allocated()) SwitchToThread();											\
+						while (!_IterSync.IterWaitEvent.Allocated()) SwitchToThread();									\
 					}																									\
 					/* Check again before wait */																		\
 					if (single_nlock) {																					\
@@ -665,21 +779,8 @@ void TSyncBlockingDeque<T>::__Lock_Demote(TSDQPushPopLockInfo *LockInfo, bool is
 				}																										\
 			}																											\
 		}																												\
-		/* Calculate remaining wait time */																				\
-		if (Timeout != FOREVER) {																						\
-			if (!EntryTS) {																								\
-				EntryTS = TimeStamp::Now();																				\
-			} else {																									\
-				TimeStamp Now = TimeStamp::Now();																		\
-				INT64 WaitDur = (Now - EntryTS).GetValue(TimeUnit::MSEC);												\
-				Timeout = Timeout > WaitDur ? Timeout - (WAITTIME)WaitDur : 0;											\
-				EntryTS = Now;																							\
-			}																											\
-		}																												\
 		/* Perform the wait */																							\
-		WaitResult WRet = AbortEvent ?																					\
-			WaitMultiple({ IterWaitEvent, *AbortEvent }, false, Timeout) :												\
-			IterWaitEvent.WaitFor(Timeout);																				\
+		WaitResult WRet = _IterSync.IterWaitEvent.WaitUntil(Deadline, AbortEvent);										\
 		/* Analyze the result */																						\
 		switch (WRet) {																									\
 			case WaitResult::Error: SYSFAIL(_T("Failed to ") opname);													\
@@ -699,167 +800,136 @@ void TSyncBlockingDeque<T>::__Lock_Demote(TSDQPushPopLockInfo *LockInfo, bool is
 		)																	\
 	)
 
-template<class T>
-typename TLockable::MRLock TSyncBlockingDeque<T>::__GetExclusiveIterLock(TLock& BaseLock,
-																		 TSDQPushPopLockInfo *LockInfo, WAITTIME Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+typename TLockable::MRLock TSyncBlockingDeque<T, P>::__GetExclusiveIterLock(TLock& BaseLock,
+																			TSDQPushPopLockInfo *LockInfo, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
 	// Check if we have already promoted
 	if (LockInfo->_ExclusiveLock) return { LockInfo->_ExclusiveLock };
 
-	MRLock Ret(CONSTRUCTION::EMPLACE, SRWSync.NullLock());
+	MRLock Ret(CONSTRUCTION::EMPLACE, _IterSync.SRWSync.NullLock());
 	// Check if we have a shared iterator lock
 	if (LockInfo->_SharedLock) {
-		auto LinkedLockBaseInfo = static_cast<TSDQBaseLockInfo*>(__LockInfo(*LockInfo->_SharedLock));
-		auto LinkedLockInfo = dynamic_cast<TSDQIterLockInfo*>(LinkedLockBaseInfo);
+		auto LinkedLockInfo = static_cast<TSDQIterLockInfo*>(__LockInfo(*LockInfo->_SharedLock));
 		__IMPL_IterLockOp(auto QueueLock = __Accessor_Sync(),
 						  {
-							  (*SRWSync).EndRead(); __LockDrop(*LinkedLockInfo->_IterLock);
+							  (*_IterSync.SRWSync).EndRead(); __LockDrop(*LinkedLockInfo->_IterLock);
 						  },
 						  TAllocResource<int> __LockRecover_RAII(0,
-																 [&](int &) { *LinkedLockInfo->_IterLock = SRWSync.Lock_Read(); }
+																 [&](int &) { *LinkedLockInfo->_IterLock = _IterSync.SRWSync.Lock_Read(); }
 						  ),
 						  {
 							  __IMPL_LinkLock(*Ret, BaseLock, LockInfo->_ExclusiveLock);
 							  __LockRecover_RAII.Invalidate();
 						  },
-							  *Ret = SRWSync.TryLock_Write(),
-							  *Ret = SRWSync.TryLock_Write(1),
+							  *Ret = _IterSync.SRWSync.TryLock_Write(),
+							  *Ret = _IterSync.SRWSync.TryLock_Write(1),
 							  _T("promote to exclusive lock")
 							  );
 	} else {
 		__IMPL_IterLockOp(auto QueueLock = __Accessor_Sync(), {}, {},
 						  __IMPL_LinkLock(*Ret, BaseLock, LockInfo->_ExclusiveLock),
-						  *Ret = SRWSync.TryLock_Write(),
-						  *Ret = SRWSync.TryLock_Write(1),
+						  *Ret = _IterSync.SRWSync.TryLock_Write(),
+						  *Ret = _IterSync.SRWSync.TryLock_Write(1),
 						  _T("acquire exclusive lock")
 		);
 	}
 	return std::move(Ret);
 }
 
-template<class T>
-typename TLockable::MRLock TSyncBlockingDeque<T>::__GetSharedIterLock(TLock& BaseLock,
-																	  TSDQPushPopLockInfo *LockInfo, WAITTIME Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+typename TLockable::MRLock TSyncBlockingDeque<T, P>::__GetSharedIterLock(TLock& BaseLock,
+																		 TSDQPushPopLockInfo *LockInfo, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
 	// Check if we already have a shared iterator lock
 	if (LockInfo->_SharedLock) return { LockInfo->_SharedLock };
 
-	MRLock Ret(CONSTRUCTION::EMPLACE, SRWSync.NullLock());
+	MRLock Ret(CONSTRUCTION::EMPLACE, _IterSync.SRWSync.NullLock());
 	// Check if we are in exclusive mode
 	if (LockInfo->_ExclusiveLock) {
 		__IMPL_LinkLock(*Ret, BaseLock, LockInfo->_SharedLock);
 	} else {
 		__IMPL_IterLockOp({}, {}, {},
 						  __IMPL_LinkLock(*Ret, BaseLock, LockInfo->_SharedLock),
-						  *Ret = SRWSync.TryLock_Read(),
-						  *Ret = SRWSync.TryLock_Read(1),
+						  *Ret = _IterSync.SRWSync.TryLock_Read(),
+						  *Ret = _IterSync.SRWSync.TryLock_Read(1),
 						  _T("acquire shared lock")
 		);
 	}
 	return std::move(Ret);
 }
 
-#define __IMPL_Create_Iterator												\
+#define __IMPL_Create_Shared_Iterator										\
 	if (*IterLock) {														\
 		auto Queue = const_cast<_this*>(this)->__Accessor_Pickup_Safe();	\
 		__SyncLock_RAII_C;													\
 		return { ((*Queue).*IterGetter)(), IterLock };						\
 	} else return {}
 
-template<class T>
+template<class T, class P>
 template<class Iter>
-typename TSyncBlockingDeque<T>::__Locked_Iterator<Iter> TSyncBlockingDeque<T>::__Create_Iterator(
-	FCIterGetter<Iter> const &IterGetter, MRLock &LockRef, WAITTIME Timeout, THandleWaitable *AbortEvent) const {
-	auto LockInfo = __PushPopLock_Check(*LockRef);
-	auto IterLock = const_cast<_this*>(this)->__GetSharedIterLock(*LockRef, LockInfo, Timeout, AbortEvent);
-	__IMPL_Create_Iterator;
+typename TSyncBlockingDeque<T, P>::template __Locked_Iterator<Iter> TSyncBlockingDeque<T, P>::__Create_Iterator(
+	FCIterGetter<Iter> const &IterGetter, MRLock &LockRef, TDeadline const &Deadline, THandleWaitable *AbortEvent,
+	__SDQIter_Shared const&) const {
+	auto LockInfo = static_cast<TSDQPushPopLockInfo*>(__PushPopLock_Check(*LockRef));
+	auto IterLock = const_cast<_this*>(this)->__GetSharedIterLock(*LockRef, LockInfo, Deadline, AbortEvent);
+	__IMPL_Create_Shared_Iterator;
 }
 
-template<class T>
+template<class T, class P>
 template<class Iter>
-typename TSyncBlockingDeque<T>::__Locked_Iterator<Iter> TSyncBlockingDeque<T>::__Create_Iterator(
-	FMIterGetter<Iter> const &IterGetter, MRLock &LockRef, WAITTIME Timeout, THandleWaitable *AbortEvent) {
-	auto LockInfo = __PushPopLock_Check(*LockRef);
-	auto IterLock = __GetExclusiveIterLock(*LockRef, LockInfo, Timeout, AbortEvent);
-	__IMPL_Create_Iterator;
-}
-
-#else
-
-template<class T>
-typename TSyncBlockingDeque<T>::TSDQBaseLockInfo TSyncBlockingDeque<T>::__PushPopLockInfo = { true,true };
-
-template<class T>
-void TSyncBlockingDeque<T>::__PushPopLock_Check(TLock const &Lock) const {
-	__Lock_Sanity(Lock);
-	TSDQBaseLockInfo *__Info = static_cast<TSDQBaseLockInfo*>(__LockInfo(Lock));
-	if (!__Info->Push || !__Info->Pop) SDQFAIL(_T("Operation requires a push-pop lock"));
+typename TSyncBlockingDeque<T, P>::template __Locked_Iterator<Iter> TSyncBlockingDeque<T, P>::__Create_Iterator(
+	FMIterGetter<Iter> const &IterGetter, MRLock &LockRef, TDeadline const &Deadline, THandleWaitable *AbortEvent,
+	__SDQIter_Shared const&) {
+	auto LockInfo = static_cast<TSDQPushPopLockInfo*>(__PushPopLock_Check(*LockRef));
+	auto IterLock = __GetExclusiveIterLock(*LockRef, LockInfo, Deadline, AbortEvent);
+	__IMPL_Create_Shared_Iterator;
 }
 
-#define __IMPL_Create_Iterator																			\
+#define __IMPL_Create_Exclusive_Iterator																\
 	__PushPopLock_Check(*LockRef);																		\
-	auto IterLock = (const_cast<_this*>(this)->ExclusiveSync).Lock(Timeout, AbortEvent);				\
+	auto IterLock = (const_cast<_this*>(this)->_IterSync.ExclusiveSync).LockUntil(Deadline, AbortEvent);	\
 	if (IterLock) {																						\
 		MRLock DynamicLock(CONSTRUCTION::EMPLACE, const_cast<_this*>(this)->__New_Lock(					\
-			DEFAULT_NEW(TSDQDynamicLockInfo, std::move(IterLock), LockRef)								\
+			DEFAULT_NEW(TSDQExclusiveLockInfo, std::move(IterLock), LockRef)							\
 		));																								\
 		auto Queue = const_cast<_this*>(this)->__Accessor_Pickup_Safe();								\
 		__SyncLock_RAII_C;																				\
 		return { ((*Queue).*IterGetter)(), DynamicLock };												\
 	} else return {}
 
-template<class T>
+template<class T, class P>
 template<class Iter>
-typename TSyncBlockingDeque<T>::__Locked_Iterator<Iter> TSyncBlockingDeque<T>::__Create_Iterator(
-	FCIterGetter<Iter> const &IterGetter, MRLock &LockRef, WAITTIME Timeout, THandleWaitable *AbortEvent) const {
-	__IMPL_Create_Iterator;
+typename TSyncBlockingDeque<T, P>::template __Locked_Iterator<Iter> TSyncBlockingDeque<T, P>::__Create_Iterator(
+	FCIterGetter<Iter> const &IterGetter, MRLock &LockRef, TDeadline const &Deadline, THandleWaitable *AbortEvent,
+	__SDQIter_Exclusive const&) const {
+	__IMPL_Create_Exclusive_Iterator;
 }
 
-template<class T>
+template<class T, class P>
 template<class Iter>
-typename TSyncBlockingDeque<T>::__Locked_Iterator<Iter> TSyncBlockingDeque<T>::__Create_Iterator(
-	FMIterGetter<Iter> const &IterGetter, MRLock &LockRef, WAITTIME Timeout, THandleWaitable *AbortEvent) {
-	__IMPL_Create_Iterator;
+typename TSyncBlockingDeque<T, P>::template __Locked_Iterator<Iter> TSyncBlockingDeque<T, P>::__Create_Iterator(
+	FMIterGetter<Iter> const &IterGetter, MRLock &LockRef, TDeadline const &Deadline, THandleWaitable *AbortEvent,
+	__SDQIter_Exclusive const&) {
+	__IMPL_Create_Exclusive_Iterator;
 }
 
-#endif
-
-#else
-
-template<class T>
-typename TSyncBlockingDeque<T>::TSDQBaseLockInfo TSyncBlockingDeque<T>::__PushPopLockInfo = { true,true };
-
-template<class T>
-void TSyncBlockingDeque<T>::__PushPopLock_Check(TLock const &Lock) const {
-	__Lock_Sanity(Lock);
-	TSDQBaseLockInfo *__Info = static_cast<TSDQBaseLockInfo*>(__LockInfo(Lock));
-	if (!__Info->Push || !__Info->Pop) SDQFAIL(_T("Operation requires a push-pop lock"));
-}
-
-template<class T>
+template<class T, class P>
 template<class Iter>
-typename TSyncBlockingDeque<T>::__Locked_Iterator<Iter> TSyncBlockingDeque<T>::__Create_Iterator(
-	FCIterGetter<Iter> const &IterGetter, MRLock &LockRef) const {
+typename TSyncBlockingDeque<T, P>::template __Locked_Iterator<Iter> TSyncBlockingDeque<T, P>::__Create_Iterator(
+	FCIterGetter<Iter> const &IterGetter, MRLock &LockRef, TDeadline const &Deadline, THandleWaitable *AbortEvent,
+	__SDQIter_Const const&) const {
 	__PushPopLock_Check(*LockRef);
 	auto Queue = const_cast<_this*>(this)->__Accessor_Pickup_Safe();
 	__SyncLock_RAII_C;
 	return { ((*Queue).*IterGetter)(), LockRef };
-	}
-
-#endif
-
-#else
-
-template<class T>
-typename TSyncBlockingDeque<T>::TSDQBaseLockInfo TSyncBlockingDeque<T>::__PushPopLockInfo = { true,true };
-
-#endif // __SDQ_ITERATORS
+}
 
-template<class T>
-void TSyncBlockingDeque<T>::__Lock_Sanity(TLock const &Lock) const {
+template<class T, class P>
+void TSyncBlockingDeque<T, P>::__Lock_Sanity(TLock const &Lock) const {
 	if (!By(Lock)) SDQFAIL(_T("Incorrect locking context"));
 }
 
-template<class T>
-void TSyncBlockingDeque<T>::__Unlock(TLockInfo *LockInfo) {
+template<class T, class P>
+void TSyncBlockingDeque<T, P>::__Unlock(TLockInfo *LockInfo) {
 	TSDQBaseLockInfo *__Info = static_cast<TSDQBaseLockInfo*>(LockInfo);
 	if (__Info->Push) {
 		if (!--PushHold) PushWait.Set();
@@ -868,79 +938,42 @@ void TSyncBlockingDeque<T>::__Unlock(TLockInfo *LockInfo) {
 		if (!--PopHold) PopWait.Set();
 	}
 
-#if defined(__SDQ_ITERATORS) && defined(__SDQ_MUTABLE_ITERATORS)
-	TSDQDynamicLockInfo *__AdvInfo = dynamic_cast<TSDQDynamicLockInfo*>(__Info);
-	if (__AdvInfo) {
-#ifdef __SDQ_CONCURRENT_CONST_ITERATORS
-		__AdvInfo->__Release(*this);
-#endif
-		DEFAULT_DESTROY(TSDQDynamicLockInfo, __AdvInfo);
-	}
-#endif // __SDQ_ITERATORS && __SDQ_MUTABLE_ITERATORS
-}
-
-template<class T>
-WaitResult TSyncBlockingDeque<T>::__WaitFor_Event(TEvent &Event, TimeStamp &EntryTS,
-												  WAITTIME &Timeout, THandleWaitable *AbortEvent) {
-	WaitResult WRet = AbortEvent ?
-		WaitMultiple({ Event, *AbortEvent }, false, Timeout) :
-		Event.WaitFor(Timeout);
-
-	if (Timeout != FOREVER) {
-		TimeStamp Now = TimeStamp::Now();
-		INT64 WaitDur = (Now - EntryTS).GetValue(TimeUnit::MSEC);
-		Timeout = Timeout > WaitDur ? Timeout - (WAITTIME)WaitDur : 0;
-		EntryTS = Now;
+	if (P::MutableIterators && __Info->Dynamic) {
+		__Release_Dynamic(static_cast<TSDQDynamicLockInfo*>(__Info), TIterMode());
 	}
-	return WRet;
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::TQueueAccessor TSyncBlockingDeque<T>::__Accessor_Pickup_Safe(void) {
-#ifdef __SDQ_LITE
-	(*_Sync).Enter();
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::TQueueAccessor TSyncBlockingDeque<T, P>::__Accessor_Pickup_Safe(void) {
+	auto Queue = _Store.Pickup();
 	if (__Cleanup) {
-		(*_Sync).Leave();
+		_Store.Leave();
 		SDQFAIL(DESTRUCTION_MESSAGE);
 	}
-	return &_Queue;
-#else
-	auto Queue = SyncDeque.Pickup();
-	if (__Cleanup) SDQFAIL(DESTRUCTION_MESSAGE);
 	return Queue;
-#endif
-	}
+}
 
-template<class T>
-typename TSyncBlockingDeque<T>::TQueueAccessor TSyncBlockingDeque<T>::__Accessor_Pickup_Gated(
-	TSyncCounter &Hold, TEvent &Sync, TimeStamp &EntryTS, WAITTIME &Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::TQueueAccessor TSyncBlockingDeque<T, P>::__Accessor_Pickup_Gated(
+	TSyncCounter &Hold, TEvent &Sync, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
 	while (true) {
 		while (~Hold) {
-			switch (__WaitFor_Event(Sync, EntryTS, Timeout, AbortEvent)) {
+			switch (Sync.WaitUntil(Deadline, AbortEvent)) {
 				case WaitResult::Error: SYSFAIL(_T("Failed to wait for pickup event"));
 				case WaitResult::Signaled:
 				case WaitResult::Signaled_0: break;
 				case WaitResult::Signaled_1:
-				case WaitResult::TimedOut:
-#ifdef __SDQ_LITE
-					return nullptr;
-#else
-					return SyncDeque.NullAccessor();
-#endif
+				case WaitResult::TimedOut: return _Store.NullAccessor();
 				default: SYSFAIL(_T("Unable to wait for pickup event"));
 			}
 			if (__Cleanup) SDQFAIL(DESTRUCTION_MESSAGE);
 		}
-#ifdef __SDQ_LITE
-		if ((*_Sync).TryEnter(__SDQ_SYNCSPIN)) return &_Queue;
-#else
-		if (auto Queue = SyncDeque.TryPickup(__SDQ_SYNCSPIN)) return Queue;
-#endif
-		}
+		if (auto Queue = _Store.TryPickup()) return Queue;
 	}
+}
 
-template<class T>
-TSyncBlockingDeque<T>::~TSyncBlockingDeque(void) {
+template<class T, class P>
+TSyncBlockingDeque<T, P>::~TSyncBlockingDeque(void) {
 	{
 		// Ensure concurrent operation finish, and future operation will be rejected
 		auto _Lock = Lock_PushPop();
@@ -949,21 +982,22 @@ TSyncBlockingDeque<T>::~TSyncBlockingDeque(void) {
 	}
 
 	{
-#ifdef __SDQ_LITE
-		auto _Queue = &this->_Queue;
-#else
-		auto _Queue = SyncDeque.Pickup();
-#endif
+		auto _Queue = _Store.Pickup();
+		__SyncLock_RAII;
+		// Many queues may be torn down together when a subsystem fails
 		if (size_t Size = _Queue->size()) {
-			SDQLOG(_T("WARNING: There are %d left over entries"), (int)Size);
+			MLOG_THROTTLED(LOGMODULE_SYNCDQ, TLogLevel::Normal, RATE_LIMITED(SDQ_WARNLOG_RATE),
+						   SDQLOG(_T("WARNING: There are %d left over entries"), (int)Size));
 		}
 		if (long Count = ~PushHold) {
-			SDQLOG(_T("WARNING: There are %d unreleased push hold"), Count);
+			MLOG_THROTTLED(LOGMODULE_SYNCDQ, TLogLevel::Normal, RATE_LIMITED(SDQ_WARNLOG_RATE),
+						   SDQLOG(_T("WARNING: There are %d unreleased push hold"), Count));
 		}
 		if (long Count = ~PopHold) {
-			SDQLOG(_T("WARNING: There are %d unreleased pop hold"), Count);
+			MLOG_THROTTLED(LOGMODULE_SYNCDQ, TLogLevel::Normal, RATE_LIMITED(SDQ_WARNLOG_RATE),
+						   SDQLOG(_T("WARNING: There are %d unreleased pop hold"), Count));
 		}
-}
+	}
 
 	PushWait.Set();
 	PopWait.Set();
@@ -971,169 +1005,138 @@ TSyncBlockingDeque<T>::~TSyncBlockingDeque(void) {
 	ContentWait.Set();
 }
 
-#ifdef __SDQ_ITERATORS
-
-#ifdef __SDQ_MUTABLE_ITERATORS
-
-template<class T>
-typename TSyncBlockingDeque<T>::iterator TSyncBlockingDeque<T>::begin(
-	MRLock &PushPopLock, WAITTIME Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::iterator TSyncBlockingDeque<T, P>::begin(
+	MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	static_assert(P::MutableIterators, "Queue policy does not enable mutable iterators");
 	return __Create_Iterator((FMIterGetter<typename Container::iterator>)&Container::begin,
-							 PushPopLock, Timeout, AbortEvent);
+							 PushPopLock, Deadline, AbortEvent, TIterMode());
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::iterator TSyncBlockingDeque<T>::end(
-	MRLock &PushPopLock, WAITTIME Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::iterator TSyncBlockingDeque<T, P>::end(
+	MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	static_assert(P::MutableIterators, "Queue policy does not enable mutable iterators");
 	return __Create_Iterator((FMIterGetter<typename Container::iterator>)&Container::end,
-							 PushPopLock, Timeout, AbortEvent);
+							 PushPopLock, Deadline, AbortEvent, TIterMode());
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::reverse_iterator TSyncBlockingDeque<T>::rbegin(
-	MRLock &PushPopLock, WAITTIME Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::reverse_iterator TSyncBlockingDeque<T, P>::rbegin(
+	MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	static_assert(P::MutableIterators, "Queue policy does not enable mutable iterators");
 	return __Create_Iterator((FMIterGetter<typename Container::reverse_iterator>)&Container::rbegin,
-							 PushPopLock, Timeout, AbortEvent);
+							 PushPopLock, Deadline, AbortEvent, TIterMode());
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::reverse_iterator TSyncBlockingDeque<T>::rend(
-	MRLock &PushPopLock, WAITTIME Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::reverse_iterator TSyncBlockingDeque<T, P>::rend(
+	MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	static_assert(P::MutableIterators, "Queue policy does not enable mutable iterators");
 	return __Create_Iterator((FMIterGetter<typename Container::reverse_iterator>)&Container::rend,
-							 PushPopLock, Timeout, AbortEvent);
+							 PushPopLock, Deadline, AbortEvent, TIterMode());
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::const_iterator TSyncBlockingDeque<T>::cbegin(
-	MRLock &PushPopLock, WAITTIME Timeout, THandleWaitable *AbortEvent) const {
-	return __Create_Iterator(&Container::cbegin, PushPopLock, Timeout, AbortEvent);
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::const_iterator TSyncBlockingDeque<T, P>::cbegin(
+	MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent) const {
+	static_assert(P::Iterators, "Queue policy does not enable iterators");
+	return __Create_Iterator(&Container::cbegin, PushPopLock, Deadline, AbortEvent, TIterMode());
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::const_iterator TSyncBlockingDeque<T>::cend(
-	MRLock &PushPopLock, WAITTIME Timeout, THandleWaitable *AbortEvent) const {
-	return __Create_Iterator(&Container::cend, PushPopLock, Timeout, AbortEvent);
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::const_iterator TSyncBlockingDeque<T, P>::cend(
+	MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent) const {
+	static_assert(P::Iterators, "Queue policy does not enable iterators");
+	return __Create_Iterator(&Container::cend, PushPopLock, Deadline, AbortEvent, TIterMode());
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::const_reverse_iterator TSyncBlockingDeque<T>::crbegin(
-	MRLock &PushPopLock, WAITTIME Timeout, THandleWaitable *AbortEvent) const {
-	return __Create_Iterator(&Container::crbegin, PushPopLock, Timeout, AbortEvent);
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::const_reverse_iterator TSyncBlockingDeque<T, P>::crbegin(
+	MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent) const {
+	static_assert(P::Iterators, "Queue policy does not enable iterators");
+	return __Create_Iterator(&Container::crbegin, PushPopLock, Deadline, AbortEvent, TIterMode());
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::const_reverse_iterator TSyncBlockingDeque<T>::crend(
-	MRLock &PushPopLock, WAITTIME Timeout, THandleWaitable *AbortEvent) const {
-	return __Create_Iterator(&Container::crend, PushPopLock, Timeout, AbortEvent);
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::const_reverse_iterator TSyncBlockingDeque<T, P>::crend(
+	MRLock &PushPopLock, TDeadline const &Deadline, THandleWaitable *AbortEvent) const {
+	static_assert(P::Iterators, "Queue policy does not enable iterators");
+	return __Create_Iterator(&Container::crend, PushPopLock, Deadline, AbortEvent, TIterMode());
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::iterator TSyncBlockingDeque<T>::erase(iterator &Iter) {
-#ifdef __SDQ_LITE
-	return { std::move(Iter), _Queue.erase(Iter) };
-#else
-	return { std::move(Iter), __Accessor_Pickup_Safe()->erase(Iter) };
-#endif
-}
+#define __Impl_Iter_Modify(op)																	\
+	static_assert(P::MutableIterators, "Queue policy does not enable mutable iterators");		\
+	auto Queue = __Accessor_Pickup_Safe();														\
+	__SyncLock_RAII;																			\
+	return { std::move(Iter), Queue->op }
 
-template<class T>
-typename TSyncBlockingDeque<T>::iterator TSyncBlockingDeque<T>::insert(iterator &Iter, T const &Val) {
-#ifdef __SDQ_LITE
-	return { std::move(Iter), _Queue.insert(Iter, Val) };
-#else
-	return { std::move(Iter), __Accessor_Pickup_Safe()->insert(Iter, Val) };
-#endif
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::iterator TSyncBlockingDeque<T, P>::erase(iterator &Iter) {
+	__Impl_Iter_Modify(erase(Iter));
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::reverse_iterator TSyncBlockingDeque<T>::erase(reverse_iterator &Iter) {
-#ifdef __SDQ_LITE
-	return { std::move(Iter), _Queue.erase(Iter) };
-#else
-	return { std::move(Iter), __Accessor_Pickup_Safe()->erase(Iter) };
-#endif
-}
-
-template<class T>
-typename TSyncBlockingDeque<T>::reverse_iterator TSyncBlockingDeque<T>::insert(reverse_iterator &Iter, T const &Val) {
-#ifdef __SDQ_LITE
-	return { std::move(Iter), _Queue.insert(Iter, Val) };
-#else
-	return { std::move(Iter), __Accessor_Pickup_Safe()->insert(Iter, Val) };
-#endif
-}
-
-#else
-
-template<class T>
-typename TSyncBlockingDeque<T>::const_iterator TSyncBlockingDeque<T>::cbegin(MRLock &PushPopLock) const {
-	return __Create_Iterator(&Container::cbegin, PushPopLock);
-}
-
-template<class T>
-typename TSyncBlockingDeque<T>::const_iterator TSyncBlockingDeque<T>::cend(MRLock &PushPopLock) const {
-	return __Create_Iterator(&Container::cend, PushPopLock);
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::iterator TSyncBlockingDeque<T, P>::insert(iterator &Iter, T const &Val) {
+	__Impl_Iter_Modify(insert(Iter, Val));
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::const_reverse_iterator TSyncBlockingDeque<T>::crbegin(MRLock &PushPopLock) const {
-	return __Create_Iterator(&Container::crbegin, PushPopLock);
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::reverse_iterator TSyncBlockingDeque<T, P>::erase(reverse_iterator &Iter) {
+	__Impl_Iter_Modify(erase(Iter));
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::const_reverse_iterator TSyncBlockingDeque<T>::crend(MRLock &PushPopLock) const {
-	return __Create_Iterator(&Container::crend, PushPopLock);
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::reverse_iterator TSyncBlockingDeque<T, P>::insert(reverse_iterator &Iter, T const &Val) {
+	__Impl_Iter_Modify(insert(Iter, Val));
 }
 
-#endif
-
-#endif // __SDQ_ITERATORS
-
 #define __Impl_Push(dir,data)																	\
-	TimeStamp EntryTS = Timeout == FOREVER ? TimeStamp::Null : TimeStamp::Now();				\
-	auto Accessor = __Accessor_Pickup_Gated(PushHold, PushWait, EntryTS, Timeout, AbortEvent);	\
+	auto Accessor = __Accessor_Pickup_Gated(PushHold, PushWait, Deadline, AbortEvent);			\
 	if (!Accessor) return -1;																	\
 	{																							\
 		__SyncLock_RAII;																		\
 		return __Push_##dir(Accessor, data);													\
 	}
 
-template<class T>
-typename TSyncBlockingDeque<T>::size_type TSyncBlockingDeque<T>::Push_Front(
-	T const &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::size_type TSyncBlockingDeque<T, P>::Push_Front(
+	T const &entry, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
 	__Impl_Push(Front, entry);
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::size_type TSyncBlockingDeque<T>::Push_Front(
-	T &&entry, WAITTIME &Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::size_type TSyncBlockingDeque<T, P>::Push_Front(
+	T &&entry, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
 	__Impl_Push(Front, std::move(entry));
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::size_type TSyncBlockingDeque<T>::Push_Back(
-	T const &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::size_type TSyncBlockingDeque<T, P>::Push_Back(
+	T const &entry, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
 	__Impl_Push(Back, entry);
 }
 
-template<class T>
-typename TSyncBlockingDeque<T>::size_type TSyncBlockingDeque<T>::Push_Back(
-	T &&entry, WAITTIME &Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+typename TSyncBlockingDeque<T, P>::size_type TSyncBlockingDeque<T, P>::Push_Back(
+	T &&entry, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
 	__Impl_Push(Back, std::move(entry));
 }
 
 #define __Impl_Pop(dir)																							\
-	TimeStamp EntryTS = Timeout == FOREVER ? TimeStamp::Null : TimeStamp::Now();								\
+	THistogram::TScopedTimer __WaitTimer;																		\
 	while (true) {																								\
 		{																										\
-			auto Accessor = __Accessor_Pickup_Gated(PopHold, PopWait, EntryTS, Timeout, AbortEvent);			\
+			auto Accessor = __Accessor_Pickup_Gated(PopHold, PopWait, Deadline, AbortEvent);					\
 			if (!Accessor) return false;																		\
 			{																									\
 				__SyncLock_RAII;																				\
 				if (!Accessor->empty()) return __Pop_##dir(Accessor, entry), true;								\
 			}																									\
 		}																										\
-		switch (__WaitFor_Event(ContentWait, EntryTS, Timeout, AbortEvent)) {									\
+		/* Only time pops that block */																			\
+		if (!__WaitTimer.Started()) __WaitTimer.Start(_PopWaits);												\
+		switch (ContentWait.WaitUntil(Deadline, AbortEvent)) {													\
 			case WaitResult::Error: SYSFAIL(_T("Failed to wait for pop event"));								\
 			case WaitResult::Signaled:																			\
 			case WaitResult::Signaled_0: continue;																\
@@ -1143,19 +1146,18 @@ typename TSyncBlockingDeque<T>::size_type TSyncBlockingDeque<T>::Push_Back(
 		}																										\
 	}
 
-template<class T>
-bool TSyncBlockingDeque<T>::Pop_Front(T &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+bool TSyncBlockingDeque<T, P>::Pop_Front(T &entry, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
 	__Impl_Pop(Front);
 }
 
-template<class T>
-bool TSyncBlockingDeque<T>::Pop_Back(T &entry, WAITTIME &Timeout, THandleWaitable *AbortEvent) {
+template<class T, class P>
+bool TSyncBlockingDeque<T, P>::Pop_Back(T &entry, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
 	__Impl_Pop(Back);
 }
 
-template<class T>
-typename TLockable::TLock TSyncBlockingDeque<T>::DrainAndLock(WAITTIME &Timeout, THandleWaitable *AbortEvent) {
-	TimeStamp EntryTS = Timeout == FOREVER ? TimeStamp::Null : TimeStamp::Now();
+template<class T, class P>
+typename TLockable::TLock TSyncBlockingDeque<T, P>::DrainAndLock(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
 	auto _Lock = Lock_Push();
 	while (true) {
 		{
@@ -1165,7 +1167,7 @@ typename TLockable::TLock TSyncBlockingDeque<T>::DrainAndLock(WAITTIME &Timeout,
 				if (Accessor->empty()) return std::move(_Lock);
 			}
 		}
-		switch (__WaitFor_Event(EmptyWait, EntryTS, Timeout, AbortEvent)) {
+		switch (EmptyWait.WaitUntil(Deadline, AbortEvent)) {
 			case WaitResult::Error: SYSFAIL(_T("Failed to wait for queue drain"));
 			case WaitResult::Signaled:
 			case WaitResult::Signaled_0: break;
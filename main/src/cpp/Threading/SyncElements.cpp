@@ -53,12 +53,12 @@ TString WaitResultToString(WaitResult const &WRet) {
 		case WaitResult::Message: return _T("Message");
 		default:
 			if (WRet >= WaitResult::Signaled_0 && WRet <= WaitResult::Signaled_MAX) {
-				return TStringCast(_T("Signaled #") << WaitSlot_Signaled(WRet));
+				return TStringFmt(_T("Signaled #") << WaitSlot_Signaled(WRet));
 			} else if (WRet >= WaitResult::Abandoned_0 && WRet <= WaitResult::Abandoned_MAX) {
-				return TStringCast(_T("Abandoned #") << WaitSlot_Abandoned(WRet));
+				return TStringFmt(_T("Abandoned #") << WaitSlot_Abandoned(WRet));
 			}
 	}
-	return TStringCast(_T("Unknown Wait Result (") << std::hex << std::uppercase << (unsigned int)WRet << _T(')'));
+	return TStringFmt(_T("Unknown Wait Result (") << FmtHex((unsigned int)WRet) << _T(')'));
 }
 
 HANDLE DupWaitHandle(HANDLE const &sHandle, HANDLE const &sProcess = GetCurrentProcess(),
@@ -123,7 +123,67 @@ WaitResult WaitMultiple(std::vector<HANDLE> const &WaitHandles, bool WaitAll, WA
 	}
 }
 
+// Wait for any of the waitables, the token among them interrupts the wait with an APC instead of its kernel event
+static WaitResult __WaitAny_Cancellable(TWaitables const &Waitables, size_t TokenIdx, WAITTIME Timeout, bool WaitAPC, bool WaitMsg) {
+	TCancelToken &Token = *Waitables[TokenIdx].get().CancelToken();
+	TWaitables Others(Waitables);
+	Others.erase(Others.begin() + TokenIdx);
+
+	TDeadline Deadline(Timeout);
+	TCancelToken::TAlertScope Alert(&Token);
+	while (true) {
+		if (Token.Cancelled()) {
+			// Same priority as a real wait, a signaled waitable ahead of the token wins
+			if (TokenIdx) {
+				WaitResult WRet = WaitMultiple(TWaitables(Waitables.begin(), Waitables.begin() + TokenIdx), false, 0, false, false);
+				if (WRet != WaitResult::TimedOut) return WRet;
+			}
+			return (WaitResult)((size_t)WaitResult::Signaled_0 + TokenIdx);
+		}
+		WaitResult WRet = WaitMultiple(Others, false, Deadline.Remaining(), true, WaitMsg);
+		if (WRet == WaitResult::APC) {
+			// Either the token was cancelled, or the caller asked for APCs
+			if (WaitAPC && !Token.Cancelled()) return WRet;
+			continue;
+		}
+		// Slots after the token shift back into place
+		if (WRet >= WaitResult::Signaled_0 && WRet <= WaitResult::Signaled_MAX) {
+			if (WaitSlot_Signaled(WRet) >= TokenIdx) WRet = (WaitResult)((size_t)WRet + 1);
+		} else if (WRet >= WaitResult::Abandoned_0 && WRet <= WaitResult::Abandoned_MAX) {
+			if (WaitSlot_Abandoned(WRet) >= TokenIdx) WRet = (WaitResult)((size_t)WRet + 1);
+		}
+		return WRet;
+	}
+}
+
 WaitResult WaitMultiple(TWaitables const &Waitables, bool WaitAll, WAITTIME Timeout, bool WaitAPC, bool WaitMsg) {
+	if (!WaitAll) {
+		// Cancellation tokens are checked in user mode, so their kernel events are not created needlessly
+		size_t TokenIdx = Waitables.size();
+		size_t TokenCnt = 0;
+		for (size_t i = 0; i < Waitables.size(); i++) {
+			TCancelToken *Token = Waitables[i].get().CancelToken();
+			if (!Token) continue;
+			if (Token->Cancelled()) {
+				// Same priority as a real wait, a signaled waitable ahead of the token wins
+				if (i) {
+					WaitResult WRet = WaitMultiple(TWaitables(Waitables.begin(), Waitables.begin() + i), false, 0, false, false);
+					if (WRet != WaitResult::TimedOut) return WRet;
+				}
+				return (WaitResult)((size_t)WaitResult::Signaled_0 + i);
+			}
+			TokenIdx = i;
+			TokenCnt++;
+		}
+		if (TokenCnt == 1) {
+			if (Waitables.size() > 1) return __WaitAny_Cancellable(Waitables, TokenIdx, Timeout, WaitAPC, WaitMsg);
+			if (!WaitAPC && !WaitMsg) {
+				WaitResult WRet = Waitables[TokenIdx].get().WaitFor(Timeout);
+				return WRet == WaitResult::Signaled ? WaitResult::Signaled_0 : WRet;
+			}
+		}
+	}
+
 	class TRawWaitHandles : public std::vector<HANDLE> {
 	private:
 		std::vector<THandle> Handles;
@@ -153,6 +213,22 @@ WaitResult WaitSingle(THandleWaitable &Waitable, WAITTIME Timeout, bool WaitAPC,
 	return WaitSingle(*Waitable.WaitHandle(), Timeout, WaitAPC, WaitMsg);
 }
 
+// --- TDeadline
+TDeadline::TDeadline(WAITTIME Timeout) :
+	_Due(Timeout == FOREVER ? TMonotonicStamp(MAXINT64) : TMonotonicStamp::Now(TimeSpan(Timeout))) {}
+
+TNSecSpan TDeadline::Left(void) const {
+	if (Forever()) return TNSecSpan(MAXINT64);
+	TNSecSpan Ret = _Due.Since(TMonotonicStamp::Now());
+	return Ret.Positive() ? Ret : TNSecSpan();
+}
+
+WAITTIME TDeadline::Remaining(void) const {
+	if (Forever()) return FOREVER;
+	long long Ret = Left().Ceil<TimeUnit::MSEC>().Count();
+	return (WAITTIME)std::min(Ret, (long long)FOREVER - 1);
+}
+
 // --- THandleWaitable
 WaitResult THandleWaitable::WaitFor(WAITTIME Timeout) const {
 	return WaitSingle(const_cast<_this*>(this)->Refer(), Timeout, false, false);
@@ -162,6 +238,75 @@ THandle THandleWaitable::WaitHandle(void) {
 	return WaitOnly ? THandle::Unmanaged(Refer()) : DupWaitable();
 }
 
+#if (_WIN32_WINNT >= 0x0600)
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION	0x00000002
+#endif
+
+class TPreciseTimer {
+private:
+	HANDLE _Timer;
+
+public:
+	// Not available before Windows 10 (1803), waits fall back to millisecond timeouts
+	TPreciseTimer(void) :
+		_Timer(CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS)) {}
+
+	~TPreciseTimer(void) {
+		if (_Timer) SafeCloseHandle(_Timer);
+	}
+
+	HANDLE Arm(TNSecSpan const &Duration) {
+		if (!_Timer) return nullptr;
+		LARGE_INTEGER Due;
+		// Negative value means relative, in 100ns units
+		Due.QuadPart = -std::max(Duration.Ceil<TimeUnit::HNSEC>().Count(), 1LL);
+		if (!SetWaitableTimerEx(_Timer, &Due, 0, nullptr, nullptr, nullptr, 0))
+			SYSFAIL(_T("Failed to arm precise wait timer"));
+		return _Timer;
+	}
+};
+
+static thread_local TPreciseTimer __PreciseTimer;
+
+#endif
+
+WaitResult THandleWaitable::WaitUntil(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	HANDLE WaitHandles[3] = { Refer() };
+	DWORD ObjCnt = 1;
+	// A cancellation token interrupts the wait with an APC, so an uncancelled wait stays on the single handle
+	TCancelToken *Token = AbortEvent ? AbortEvent->CancelToken() : nullptr;
+	if (AbortEvent && !Token) WaitHandles[ObjCnt++] = AbortEvent->Refer();
+
+	TCancelToken::TAlertScope Alert(Token);
+	while (true) {
+		if (Token && Token->Cancelled()) {
+			// Same priority as a real wait, the waited object wins if it is also signaled
+			DWORD Ret = WaitForSingleObjectEx(WaitHandles[0], 0, FALSE);
+			return Ret == WAIT_TIMEOUT ? WaitResult::Signaled_1 : __FilterWaitResult(Ret, 1, false);
+		}
+
+		DWORD WaitCnt = ObjCnt;
+		WAITTIME Timeout = Deadline.Remaining();
+		bool Precise = false;
+#if (_WIN32_WINNT >= 0x0600)
+		if (Timeout && Timeout < PRECISEWAIT_THRESHOLD) {
+			if (HANDLE Timer = __PreciseTimer.Arm(Deadline.Left())) {
+				WaitHandles[WaitCnt++] = Timer;
+				Timeout = FOREVER;
+				Precise = true;
+			}
+		}
+#endif
+		DWORD Ret = WaitForMultipleObjectsEx(WaitCnt, WaitHandles, FALSE, Timeout, Token != nullptr);
+		// Woken by an APC, check the token again
+		if (Ret == WAIT_IO_COMPLETION) continue;
+		if (Precise && Ret == WAIT_OBJECT_0 + WaitCnt - 1) return WaitResult::TimedOut;
+		return __FilterWaitResult(Ret, WaitCnt, false);
+	}
+}
+
 THandleWaitable THandleWaitable::DupWaitable(void) {
 	THandleWaitable Ret([&] { return DupWaitHandle(Refer()); });
 	Ret.WaitOnly = true;
@@ -172,6 +317,103 @@ THandleWaitable THandleWaitable::Create(THandle &Handle) {
 	return { CONSTRUCTION::HANDOFF, DupWaitHandle(*Handle) };
 }
 
+// --- TCancelToken
+#if (_WIN32_WINNT >= 0x0602)
+#pragma comment(lib, "Synchronization.lib")
+#endif
+
+HANDLE TCancelToken::__Materialize(void) {
+	HANDLE Event = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+	if (Event == nullptr)
+		SYSFAIL(_T("Failed to create cancellation event"));
+	// Concurrent first waiters race to publish, all of them adopt the winner
+	if (HANDLE Published = InterlockedCompareExchangePointer(&_Event, Event, nullptr)) {
+		SafeCloseHandle(Event);
+		return Published;
+	}
+	// Cancel() may have missed the event, which was not yet published when it checked
+	if (_Cancelled && !SetEvent(Event))
+		SYSFAIL(_T("Failed to signal cancellation event"));
+	return Event;
+}
+
+static VOID CALLBACK __CancelAPC(ULONG_PTR) {
+	// Only interrupts the alertable wait, the waiter checks the token
+}
+
+void TCancelToken::Cancel(void) {
+	if (InterlockedExchange(&_Cancelled, 1)) return;
+#if (_WIN32_WINNT >= 0x0602)
+	WakeByAddressAll((PVOID)&_Cancelled);
+#endif
+	_WaitersLock.Enter();
+	for (TWaiter *Waiter = _Waiters; Waiter; Waiter = Waiter->Next) {
+		if (!QueueUserAPC(&__CancelAPC, Waiter->Thread, 0))
+			SYSERRLOG(_T("WARNING: Failed to interrupt cancellable wait"));
+	}
+	_WaitersLock.Leave();
+	if (HANDLE Event = _Event) {
+		if (!SetEvent(Event)) SYSFAIL(_T("Failed to signal cancellation event"));
+	}
+}
+
+// Handle of the current thread for queuing APCs, kept until the thread exits
+class TAPCThreadHandle {
+public:
+	HANDLE Handle = nullptr;
+
+	~TAPCThreadHandle(void) {
+		if (Handle) SafeCloseHandle(Handle);
+	}
+
+	HANDLE Refer(void) {
+		if (!Handle && !DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &Handle, THREAD_SET_CONTEXT, FALSE, 0))
+			SYSFAIL(_T("Failed to duplicate thread handle"));
+		return Handle;
+	}
+};
+
+static thread_local TAPCThreadHandle __APCThreadHandle;
+
+TCancelToken::TAlertScope::TAlertScope(TCancelToken *Token) : _Token(Token) {
+	if (!_Token) return;
+	_Waiter.Thread = __APCThreadHandle.Refer();
+	// Cancel() either finds us in the list, or has set the flag before we check it
+	_Token->_WaitersLock.Enter();
+	_Waiter.Next = _Token->_Waiters;
+	_Token->_Waiters = &_Waiter;
+	_Token->_WaitersLock.Leave();
+}
+
+TCancelToken::TAlertScope::~TAlertScope(void) {
+	if (!_Token) return;
+	_Token->_WaitersLock.Enter();
+	TWaiter **Link = &_Token->_Waiters;
+	while (*Link != &_Waiter) Link = &(*Link)->Next;
+	*Link = _Waiter.Next;
+	_Token->_WaitersLock.Leave();
+	// An APC is only queued after cancellation, do not leave it to interrupt an unrelated wait
+	if (_Token->Cancelled()) SleepEx(0, TRUE);
+}
+
+WaitResult TCancelToken::WaitFor(WAITTIME Timeout) const {
+#if (_WIN32_WINNT >= 0x0602)
+	TDeadline Deadline(Timeout);
+	LONG Pending = 0;
+	while (!_Cancelled) {
+		WAITTIME Remaining = Deadline.Remaining();
+		if (!Remaining) return WaitResult::TimedOut;
+		if (!WaitOnAddress((PVOID)&_Cancelled, &Pending, sizeof(LONG), Remaining)) {
+			if (GetLastError() != ERROR_TIMEOUT)
+				SYSFAIL(_T("Failed to wait for cancellation"));
+		}
+	}
+	return WaitResult::Signaled;
+#else
+	return _Cancelled ? WaitResult::Signaled : THandleWaitable::WaitFor(Timeout);
+#endif
+}
+
 // --- TSemaphore
 HANDLE DupSemSignalHandle(HANDLE const &sHandle, HANDLE const &sProcess = GetCurrentProcess(),
 						  HANDLE const &tProcess = GetCurrentProcess(), BOOL Inheritable = FALSE) {
@@ -265,6 +507,54 @@ void TEvent::Pulse(void) {
 		SYSFAIL(_T("Failed to pulse event"));
 }
 
+// --- TAdaptiveSpin
+
+__ARC_UINT const TAdaptiveSpin::__ProcessorCount = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+
+void TAdaptiveSpin::__Adjust(void) {
+	static INT64 const __ParkCost = TMonotonicStamp::toTicks(TNSecSpan(ADAPTIVESPIN_PARK_NSEC));
+	__ARC_UINT Budget;
+	if (__ProcessorCount < 2 || _HoldTicks > __ParkCost) {
+		// Nobody can release the lock while we spin, or the holder will not be done any time soon
+		Budget = ADAPTIVESPIN_MIN;
+	} else {
+		Budget = (__ARC_UINT)std::min(std::max(_SpinWait * 2, (INT64)ADAPTIVESPIN_MIN), (INT64)ADAPTIVESPIN_MAX);
+	}
+	if (_Budget != Budget) _Budget = Budget;
+}
+
+void TAdaptiveSpin::Acquired(__ARC_UINT Attempts) {
+	if (Attempts) ++_Spins;
+	_SpinWait += ((INT64)Attempts - _SpinWait) >> ADAPTIVESPIN_EWMA_SHIFT;
+	__Adjust();
+}
+
+void TAdaptiveSpin::Parked(UINT64 Duration) {
+	static INT64 const __ParkCost = TMonotonicStamp::toTicks(TNSecSpan(ADAPTIVESPIN_PARK_NSEC));
+	++_Parks;
+	_ParkTicks += ((INT64)Duration - _ParkTicks) >> ADAPTIVESPIN_EWMA_SHIFT;
+	// The lock came free about as soon as we parked, lean towards a larger budget (unless the hold time says otherwise)
+	if ((INT64)Duration < __ParkCost) {
+		_SpinWait += ((INT64)_Budget * 2 - _SpinWait) >> ADAPTIVESPIN_EWMA_SHIFT;
+		__Adjust();
+	}
+}
+
+void TAdaptiveSpin::Held(UINT64 Duration) {
+	_HoldTicks += ((INT64)Duration - _HoldTicks) >> ADAPTIVESPIN_EWMA_SHIFT;
+}
+
+TAdaptiveSpin::TStats TAdaptiveSpin::Stats(void) const {
+	return { _Budget, _HoldTicks, _SpinWait, _ParkTicks, ~_Spins, ~_Parks };
+}
+
+TString TAdaptiveSpin::toString(void) const {
+	TStats S = Stats();
+	return TStringFmt(_T("Spin budget ") << S.Budget << _T(" (hold ~") << S.HoldTicks
+					  << _T(" ticks, wait ~") << S.SpinWait << _T(" attempts; ")
+					  << S.Spins << _T(" spun, ") << S.Parks << _T(" parked ~") << S.ParkTicks << _T(" ticks)"));
+}
+
 #if (_WIN32_WINNT >= 0x0600)
 
 // --- TConditionVariable
@@ -496,4 +786,135 @@ WaitResult TWaitableAlarmClock::WaitFor(WAITTIME Timeout) const {
 	return WRet;
 }
 
+#ifdef __ZWUTILS_SYNC_WAITSET
+
+#include <unordered_map>
+
+// --- TWaitSet
+
+#define WAITSET_BATCH	64
+
+class TWaitSet_Impl : public TWaitSet {
+	typedef TWaitSet_Impl _this;
+
+private:
+	class TMember : public ManagedObj {
+	public:
+		HANDLE const Port;
+		THandleWaitable * const Waitable;
+		ULONG_PTR const ID;
+		THandle Handle;
+		PTP_WAIT Wait;
+
+		static VOID CALLBACK __Notify(PTP_CALLBACK_INSTANCE Instance, PVOID Context, PTP_WAIT TPWait, TP_WAIT_RESULT TPWaitResult) {
+			TMember *Member = static_cast<TMember*>(Context);
+			// The member ID tells apart stale notifications of a removed (and maybe re-added) waitable
+			PostQueuedCompletionStatus(Member->Port, 0, (ULONG_PTR)Member->Waitable, (LPOVERLAPPED)Member->ID);
+		}
+
+		TMember(HANDLE xPort, THandleWaitable &xWaitable, ULONG_PTR xID) :
+			Port(xPort), Waitable(&xWaitable), ID(xID), Handle(xWaitable.WaitHandle()) {
+			Wait = CreateThreadpoolWait(__Notify, this, nullptr);
+			if (!Wait) SYSFAIL(_T("Unable to create thread pool wait"));
+			Arm();
+		}
+
+		~TMember(void) {
+			SetThreadpoolWait(Wait, nullptr, nullptr);
+			WaitForThreadpoolWaitCallbacks(Wait, TRUE);
+			CloseThreadpoolWait(Wait);
+		}
+
+		void Arm(void) {
+			SetThreadpoolWait(Wait, *Handle, nullptr);
+		}
+	};
+	typedef ManagedRef<TMember> MRMember;
+	typedef std::unordered_map<THandleWaitable*, MRMember> TMembers;
+
+	THandle _Port;
+	mutable TSyncObj<TMembers> _Members;
+	ULONG_PTR _NextID = 0;
+	TReady _Rearm;
+
+	static HANDLE __CreatePort(void) {
+		HANDLE iRet = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+		if (!iRet) SYSFAIL(_T("Unable to create completion port"));
+		return iRet;
+	}
+
+	bool __Collect(OVERLAPPED_ENTRY const *Entries, ULONG Count, TReady &Ready) {
+		auto Members(_Members.Pickup());
+		for (ULONG i = 0; i < Count; i++) {
+			auto Waitable = (THandleWaitable*)Entries[i].lpCompletionKey;
+			auto Iter = Members->find(Waitable);
+			if (Iter == Members->end() || Iter->second->ID != (ULONG_PTR)Entries[i].lpOverlapped) continue;
+			Ready.push_back(Waitable);
+		}
+		return !Ready.empty();
+	}
+
+	void __Rearm(void) {
+		auto Members(_Members.Pickup());
+		for (auto Waitable : _Rearm) {
+			auto Iter = Members->find(Waitable);
+			if (Iter != Members->end()) Iter->second->Arm();
+		}
+		_Rearm.clear();
+	}
+
+public:
+	TWaitSet_Impl(void) : _Port(CONSTRUCTION::HANDOFF, __CreatePort()) {}
+
+	void Add(THandleWaitable &Waitable) override {
+		auto Members(_Members.Pickup());
+		if (Members->find(&Waitable) != Members->end()) FAIL(_T("Waitable already registered"));
+		Members->emplace(&Waitable, MRMember(CONSTRUCTION::EMPLACE, *_Port, Waitable, ++_NextID));
+	}
+
+	bool Remove(THandleWaitable &Waitable) override {
+		// Destruction of the member waits for in-flight notifications
+		return _Members.Pickup()->erase(&Waitable) != 0;
+	}
+
+	size_t Count(void) const override {
+		return _Members.Pickup()->size();
+	}
+
+	WaitResult Wait(TReady &Ready, WAITTIME Timeout) override {
+		__Rearm();
+		Ready.clear();
+
+		OVERLAPPED_ENTRY Entries[WAITSET_BATCH];
+		ULONGLONG Deadline = GetTickCount64() + Timeout;
+		WAITTIME Remainder = Timeout;
+		while (true) {
+			ULONG Count = 0;
+			if (!GetQueuedCompletionStatusEx(*_Port, Entries, WAITSET_BATCH, &Count, Ready.empty() ? Remainder : 0, FALSE)) {
+				if (GetLastError() != WAIT_TIMEOUT) SYSFAIL(_T("Unable to wait on completion port"));
+				Count = 0;
+			}
+			__Collect(Entries, Count, Ready);
+			// A full batch may be followed by more, otherwise we are done if anything is collected
+			if (Count == WAITSET_BATCH) continue;
+			if (!Ready.empty()) break;
+
+			// Nothing but stale notifications, keep waiting for the remainder of time
+			if (Timeout != FOREVER) {
+				ULONGLONG Now = GetTickCount64();
+				if (Now >= Deadline) return WaitResult::TimedOut;
+				Remainder = (WAITTIME)(Deadline - Now);
+			}
+		}
+		_Rearm = Ready;
+		return WaitResult::Signaled;
+	}
+};
+
+MRWaitSet TWaitSet::Create(void) {
+	return { DEFAULT_NEW(TWaitSet_Impl), CONSTRUCTION::HANDOFF };
+}
+
+#endif
+
 #endif
@@ -44,6 +44,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Misc/TString.h"
 #include "Misc/Types.h"
+#include "Misc/Timing.h"
 
 #include "Debug/Debug.h"
 #include "Debug/Logging.h"
@@ -73,6 +74,9 @@ __SYNC_DEBUG(extern __declspec(thread) bool __IN_LOG);
 typedef unsigned int WAITTIME;
 extern WAITTIME const FOREVER;
 
+// Millisecond timeouts are quantized to the scheduler tick, shorter deadlines need a precise timer
+#define PRECISEWAIT_THRESHOLD	16
+
 enum class WaitResult : unsigned int {
 	Signaled,
 	TimedOut,
@@ -115,6 +119,57 @@ unsigned int WaitSlot(WaitResult const &X, WaitResult const &Base);
 
 TString WaitResultToString(WaitResult const &WRet);
 
+/**
+ * @ingroup Threading
+ * @brief Wait deadline
+ *
+ * A fixed due point on the monotonic clock, so a sequence of waits shares one time budget
+ *  without accumulating rounding errors or following wall clock adjustments
+ **/
+class TDeadline {
+	typedef TDeadline _this;
+
+protected:
+	TMonotonicStamp _Due;
+
+public:
+	/**
+	 * Create a deadline that never expires
+	 **/
+	TDeadline(void) : _Due(MAXINT64) {}
+	explicit TDeadline(WAITTIME Timeout);
+	explicit TDeadline(TimeSpan const &Duration) : _Due(TMonotonicStamp::Now(Duration)) {}
+	template<TimeUnit U>
+	explicit TDeadline(TTypedSpan<U> const &Duration) : _Due(TMonotonicStamp::Now() + Duration) {}
+	explicit TDeadline(TMonotonicStamp const &Due) : _Due(Due) {}
+	/**
+	 * Create a deadline at a wall clock time, the offset from now is captured once
+	 **/
+	explicit TDeadline(TimeStamp const &Clock) : TDeadline(Clock - TimeStamp::Now()) {}
+
+	TMonotonicStamp const& Due(void) const {
+		return _Due;
+	}
+
+	bool Forever(void) const {
+		return _Due.GetTicks() == MAXINT64;
+	}
+
+	bool Expired(void) const {
+		return !Forever() && TMonotonicStamp::Now() >= _Due;
+	}
+
+	/**
+	 * Get the precise remaining time, Null if expired
+	 **/
+	TNSecSpan Left(void) const;
+
+	/**
+	 * Get the remaining wait time, rounded up to the next millisecond
+	 **/
+	WAITTIME Remaining(void) const;
+};
+
 /**
  * @ingroup Threading
  * @brief Waitable base class
@@ -153,6 +208,8 @@ public:
 #endif
 };
 
+class TCancelToken;
+
 /**
  * @ingroup Threading
  * @brief Handle waitable base class
@@ -191,6 +248,21 @@ public:
 	 **/
 	virtual THandle WaitHandle(void);
 
+	/**
+	 * Get the cancellation token behind this waitable, if it is one
+	 **/
+	virtual TCancelToken* CancelToken(void) {
+		return nullptr;
+	}
+
+	/**
+	 * Wait until signaled, the deadline passes, or the abort waitable is signaled
+	 * @return Signaled_0, TimedOut, or Signaled_1 if aborted
+	 * @note Unlike WaitMultiple(), the handles are waited on directly without duplication
+	 * @note Deadlines closer than the scheduler tick are kept by a high resolution timer where supported
+	 **/
+	WaitResult WaitUntil(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr);
+
 	/**
 	 * Get a duplicated THandleWaitable instance
 	 **/
@@ -325,10 +397,97 @@ class TConditionVariable;
 
 #define __ZWUTILS_SYNC_CONDITIONVAIRABLE
 #define __ZWUTILS_SYNC_SLIMRWLOCK
+#define __ZWUTILS_SYNC_WAITSET
 #endif
 
 #define DEFAULT_CRITICALSECTION_SPIN	1024
 
+#define ADAPTIVESPIN_MIN			16
+#define ADAPTIVESPIN_MAX			(DEFAULT_CRITICALSECTION_SPIN * 4)
+#define ADAPTIVESPIN_PAUSE_LIMIT	64
+// Approximate cost of a park / wake round trip (ns), holds longer than this are not worth spinning for
+#define ADAPTIVESPIN_PARK_NSEC		5000
+#define ADAPTIVESPIN_EWMA_SHIFT		3
+
+/**
+ * @ingroup Threading
+ * @brief Adaptive spin policy
+ *
+ * Tracks recent hold times, spin outcomes and park waits of a lock, and tunes the spin budget before parking
+ * - Times are measured in monotonic counter ticks (TMonotonicStamp)
+ * @note Statistics are updated without synchronization, lost updates only delay adaptation
+ **/
+class TAdaptiveSpin {
+	typedef TAdaptiveSpin _this;
+
+protected:
+	static __ARC_UINT const __ProcessorCount;
+
+	__ARC_UINT volatile _Budget = DEFAULT_CRITICALSECTION_SPIN;
+	INT64 volatile _HoldTicks = 0;
+	INT64 volatile _SpinWait = 0;
+	INT64 volatile _ParkTicks = 0;
+	TInterlockedArchUInt _Spins = 0;
+	TInterlockedArchUInt _Parks = 0;
+
+	void __Adjust(void);
+
+public:
+	struct TStats {
+		__ARC_UINT Budget;
+		INT64 HoldTicks;
+		INT64 SpinWait;
+		INT64 ParkTicks;
+		__ARC_UINT Spins;
+		__ARC_UINT Parks;
+	};
+
+	static UINT64 Ticks(void) {
+		return TMonotonicStamp::Now().GetTicks();
+	}
+
+	/**
+	 * Current number of acquisition attempts before parking
+	 **/
+	__ARC_UINT Budget(void) const {
+		return _Budget;
+	}
+
+	/**
+	 * Record an acquisition after given number of failed attempts
+	 **/
+	void Acquired(__ARC_UINT Attempts);
+
+	/**
+	 * Record a kernel wait after spinning exhausted the budget, must be called once per actual wait
+	 **/
+	void Parked(UINT64 Duration);
+
+	/**
+	 * Record the duration a lock was held
+	 **/
+	void Held(UINT64 Duration);
+
+	/**
+	 * Attempt acquisition with pause backoff within the budget, return false if caller should park
+	 * @note The caller reports the resulting wait via Parked()
+	 **/
+	template<class F>
+	bool Spin(F const &TryAcquire) {
+		__ARC_UINT Limit = _Budget;
+		__ARC_UINT Pause = 1;
+		for (__ARC_UINT Attempt = 0; Attempt < Limit; Attempt++) {
+			if (TryAcquire()) return Acquired(Attempt), true;
+			for (__ARC_UINT i = 0; i < Pause; i++) YieldProcessor();
+			if (Pause < ADAPTIVESPIN_PAUSE_LIMIT) Pause <<= 1;
+		}
+		return TryAcquire();
+	}
+
+	TStats Stats(void) const;
+	TString toString(void) const;
+};
+
 /**
  * @ingroup Threading
  * @brief Critical Section
@@ -373,10 +532,17 @@ public:
 #ifdef _DEBUG
 		if (!SpinCount) FAIL(_T("Spin count must be a natrual number"));
 #endif
-		while (--SpinCount && !TryEnterCriticalSection(&rCriticalSection));
+		while (--SpinCount && !TryEnterCriticalSection(&rCriticalSection)) YieldProcessor();
 		return SpinCount || TryEnterCriticalSection(&rCriticalSection) != 0;
 	}
 
+	/**
+	 * Set the number of spins before entering critical section parks
+	 **/
+	void SpinCount(unsigned int SpinCount) {
+		SetCriticalSectionSpinCount(&rCriticalSection, SpinCount);
+	}
+
 	/**
 	 * Leave the critical section
 	 **/
@@ -385,6 +551,80 @@ public:
 	}
 };
 
+/**
+ * @ingroup Threading
+ * @brief Cancellation token
+ *
+ * Cooperative cancellation flag, usable wherever an abort waitable is accepted
+ * - Cancel() is a single interlocked store, plus wake-ups only when someone is waiting
+ * - The kernel event backing the waitable handle is only created when a handle is first requested
+ * - As an abort waitable, the token does not add a handle to the wait: the wait is made alertable,
+ *   and Cancel() interrupts it with a user APC
+ * @note Abortable waits on a token are alertable, other APCs queued to the waiting thread may run
+ * @note Once cancelled, a token stays cancelled
+ **/
+class TCancelToken : public THandleWaitable {
+	typedef TCancelToken _this;
+
+protected:
+	struct TWaiter {
+		HANDLE Thread;
+		TWaiter *Next;
+	};
+
+	LONG volatile _Cancelled = 0;
+	HANDLE volatile _Event = nullptr;
+	TCriticalSection _WaitersLock;
+	TWaiter *_Waiters = nullptr;
+
+	HANDLE __Materialize(void);
+
+public:
+	TCancelToken(void) : THandleWaitable([&] { return __Materialize(); }) {}
+
+	TCancelToken(_this const &) = delete;
+	TCancelToken(_this &&) = delete;
+	_this& operator=(_this const &) = delete;
+	_this& operator=(_this &&) = delete;
+
+	/**
+	 * Request cancellation, wakes all waiters
+	 **/
+	void Cancel(void);
+
+	bool Cancelled(void) const {
+		return _Cancelled != 0;
+	}
+
+	/**
+	 * Wait for cancellation, without creating the kernel event when supported
+	 **/
+	WaitResult WaitFor(WAITTIME Timeout = FOREVER) const override;
+
+	TCancelToken* CancelToken(void) override {
+		return this;
+	}
+
+	/**
+	 * Registers the current thread with a token (if any) for the duration of an alertable wait,
+	 * so that Cancel() interrupts the wait with a user APC
+	 **/
+	class TAlertScope {
+		typedef TAlertScope _this;
+
+	protected:
+		TCancelToken *_Token;
+		TWaiter _Waiter;
+
+	public:
+		TAlertScope(TCancelToken *Token);
+		~TAlertScope(void);
+
+		TAlertScope(_this const &) = delete;
+		_this& operator=(_this const &) = delete;
+	};
+};
+
 #ifdef __ZWUTILS_SYNC_SLIMRWLOCK
 
 /**
@@ -427,7 +667,7 @@ public:
 #ifdef _DEBUG
 		if (!SpinCount) FAIL(_T("Spin count must be a natrual number"));
 #endif
-		while (--SpinCount && !TryAcquireSRWLockShared(&rSRWlock));
+		while (--SpinCount && !TryAcquireSRWLockShared(&rSRWlock)) YieldProcessor();
 		return SpinCount || TryAcquireSRWLockShared(&rSRWlock) != 0;
 	}
 
@@ -452,7 +692,7 @@ public:
 #ifdef _DEBUG
 		if (!SpinCount) FAIL(_T("Spin count must be a natrual number"));
 #endif
-		while (--SpinCount && !TryAcquireSRWLockExclusive(&rSRWlock));
+		while (--SpinCount && !TryAcquireSRWLockExclusive(&rSRWlock)) YieldProcessor();
 		return SpinCount || TryAcquireSRWLockExclusive(&rSRWlock) != 0;
 	}
 
@@ -658,4 +898,60 @@ public:
 	WaitResult WaitFor(WAITTIME Timeout = FOREVER) const override;
 };
 
+#ifdef __ZWUTILS_SYNC_WAITSET
+
+class TWaitSet;
+typedef ManagedRef<TWaitSet> MRWaitSet;
+
+/**
+* @ingroup Threading
+* @brief Persistent wait set
+*
+* Waitables are registered once, and a wait returns all members signaled so far, with no cap on the member count
+* - Members are watched by the system thread pool, satisfied waits are queued to a completion port
+* - A reported member is re-armed on the next Wait(), so a persisting signal is reported again
+* @note Same as WaitMultiple(), a reported wait is satisfied (auto-reset events reset, semaphores decrement)
+* @note Members can be added or removed from any thread, but only one thread should wait at a time
+**/
+class TWaitSet {
+protected:
+	/**
+	 * Same as TAlarmClock, the implementation is hidden, call Create() to get an instance
+	 **/
+	TWaitSet(void) {}
+
+public:
+	typedef std::vector<THandleWaitable*> TReady;
+
+	virtual ~TWaitSet(void) {}
+
+	/**
+	 * Register a waitable, which must outlive its membership
+	 **/
+	virtual void Add(THandleWaitable &Waitable) = 0;
+
+	/**
+	 * Unregister a waitable, returns false if it is not a member
+	 **/
+	virtual bool Remove(THandleWaitable &Waitable) = 0;
+
+	/**
+	 * Get the number of members
+	 **/
+	virtual size_t Count(void) const = 0;
+
+	/**
+	 * Wait until any member is signaled, and collect all signaled members into Ready
+	 * @return Signaled, or TimedOut if no member is signaled in time
+	 **/
+	virtual WaitResult Wait(TReady &Ready, WAITTIME Timeout = FOREVER) = 0;
+
+	/**
+	 * Create an empty wait set
+	 **/
+	static MRWaitSet Create(void);
+};
+
+#endif
+
 #endif //ZWUtils_SyncElements_H
\ No newline at end of file
@@ -32,9 +32,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "SyncObjects.h"
 
-#define _IMPL_AbortableLock(spin_trylock, single_trylock, objname)										\
+// Wait durations are reported to the adaptive spin policy, if given
+#define _IMPL_AbortableLock(spin_trylock, single_trylock, spin_policy, objname)							\
 	TAllocResource<__ARC_INT> WaitCounter([&] { return WaitCnt++; }, [&](__ARC_INT &) { --WaitCnt; });	\
-	TimeStamp EntryTS;																					\
 	while (!spin_trylock) {																				\
 		/* Allocate wait counter */																		\
 		if (!WaitCounter.Allocated()) {																	\
@@ -45,21 +45,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 			/* Check again before wait */																\
 			if (single_trylock) break;																	\
 		}																								\
-		/* Calculate remaining wait time */																\
-		if (Timeout != FOREVER) {																		\
-			if (!EntryTS) {																				\
-				EntryTS = TimeStamp::Now();																\
-			} else {																					\
-				TimeStamp Now = TimeStamp::Now();														\
-				INT64 WaitDur = (Now - EntryTS).GetValue(TimeUnit::MSEC);								\
-				Timeout = Timeout > WaitDur ? Timeout - (WAITTIME)WaitDur : 0;							\
-				EntryTS = Now;																			\
-			}																							\
-		}																								\
 		/* Perform the wait */																			\
-		WaitResult WRet = AbortEvent ?																	\
-			WaitMultiple({ WaitEvent, *AbortEvent }, false, Timeout) :									\
-			WaitEvent.WaitFor(Timeout);																	\
+		TAdaptiveSpin *Policy = spin_policy;															\
+		UINT64 ParkStart = Policy ? TAdaptiveSpin::Ticks() : 0;											\
+		WaitResult WRet = WaitEvent.WaitUntil(Deadline, AbortEvent);									\
+		if (Policy) Policy->Parked(TAdaptiveSpin::Ticks() - ParkStart);									\
 		/* Analyze the result */																		\
 		switch (WRet) {																					\
 			case WaitResult::Error: SYSFAIL(_T("Failed to lock ") objname);								\
@@ -72,8 +62,30 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 	}																									\
 	return true;
 
-bool TLockableCS::__Lock_Abortable(WAITTIME Timeout, THandleWaitable *AbortEvent) {
-	_IMPL_AbortableLock(__TryLock(), TryEnter(), _T("critical section"));
+bool TLockableCS::__Lock_Abortable(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	_IMPL_AbortableLock(SpinPolicy.Spin([&] { return TryEnter(1); }), TryEnter(1), &SpinPolicy, _T("critical section"));
+}
+
+bool TLockableTTAS::__Lock_Abortable(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	_IMPL_AbortableLock(__TryLock(), __TryLock_Once(), nullptr, _T("TTAS spin lock"));
+}
+
+bool TLockableTicket::__Lock_Abortable(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	_IMPL_AbortableLock(__TryLock(), __TryLock_Once(), nullptr, _T("ticket lock"));
+}
+
+bool TLockableMCS::__Lock_Abortable(TMCSNode *Node, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	_IMPL_AbortableLock(__TryLock_Node(Node, DEFAULT_CRITICALSECTION_SPIN), __TryLock_Node(Node), nullptr, _T("MCS lock"));
+}
+
+TLockable::TLockInfo TLockableDRW::__WriteLockInfo;
+
+bool TLockableDRW::__Lock_Read_Abortable(TReaderSlot* &Slot, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	_IMPL_AbortableLock((Slot = __TryLock_Read(DEFAULT_CRITICALSECTION_SPIN)), (Slot = __Lock_Read_Probe()), nullptr, _T("distributed RW lock"));
+}
+
+bool TLockableDRW::__Lock_Write_Abortable(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	_IMPL_AbortableLock(__TryLock_Write(DEFAULT_CRITICALSECTION_SPIN), __Lock_Write_Probe(), nullptr, _T("distributed RW lock"));
 }
 
 #ifdef __ZWUTILS_SYNC_SLIMRWLOCK
@@ -81,12 +93,93 @@ bool TLockableCS::__Lock_Abortable(WAITTIME Timeout, THandleWaitable *AbortEvent
 TLockableSRW::TSRWLockInfo TLockableSRW::__ReadLockInfo = { false };
 TLockableSRW::TSRWLockInfo TLockableSRW::__WriteLockInfo = { true };
 
-bool TLockableSRW::__Lock_Read_Do(TInterlockedArchInt &WaitCnt, TEvent &WaitEvent, WAITTIME Timeout, THandleWaitable *AbortEvent) {
-	_IMPL_AbortableLock(__TryLock_Read(), __Lock_Read_Probe(1), _T("SRW lock"));
+bool TLockableSRW::__Lock_Read_Do(TInterlockedArchInt &WaitCnt, TEvent &WaitEvent, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	_IMPL_AbortableLock(SpinPolicy.Spin([&] { return __Lock_Read_Probe(1); }), __Lock_Read_Probe(1), &SpinPolicy, _T("SRW lock"));
+}
+
+bool TLockableSRW::__Lock_Write_Do(TInterlockedArchInt &WaitCnt, TEvent &WaitEvent, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+	_IMPL_AbortableLock(SpinPolicy.Spin([&] { return __Lock_Write_Probe(1); }), __Lock_Write_Probe(1), &SpinPolicy, _T("SRW lock"));
+}
+
+#endif
+
+class TRCUReader {
+	typedef TRCUReader _this;
+
+public:
+	// Zero when the thread is outside of any read-side section
+	TInterlockedOrdinal64<__int64> Epoch = 0;
+	unsigned int Nesting = 0;
+	bool Registered = false;
+
+	~TRCUReader(void);
+
+	// Registration is deferred to the first read-side section of the thread
+	bool Register(WAITTIME Timeout);
+};
+
+typedef std::vector<TRCUReader*> TRCUReaders;
+
+TSyncObj<TRCUReaders>& RCUREADERS(void) {
+	static TSyncObj<TRCUReaders> __IoFU;
+	return __IoFU;
+}
+
+TInterlockedOrdinal64<__int64>& RCUEPOCH(void) {
+	static TInterlockedOrdinal64<__int64> __IoFU(1);
+	return __IoFU;
+}
+
+bool TRCUReader::Register(WAITTIME Timeout) {
+	auto Readers(RCUREADERS().Pickup(Timeout));
+	if (!Readers) return false;
+	Readers->push_back(this);
+	return Registered = true;
+}
+
+TRCUReader::~TRCUReader(void) {
+	if (!Registered) return;
+	auto Readers(RCUREADERS().Pickup());
+	Readers->erase(std::find(Readers->begin(), Readers->end(), this));
+}
+
+thread_local TRCUReader __RCUReader;
+
+void TRCUDomain::Enter(void) {
+	TryEnter(FOREVER);
+}
+
+bool TRCUDomain::TryEnter(WAITTIME Timeout) {
+	if (!__RCUReader.Registered && !__RCUReader.Register(Timeout)) return false;
+	// Interlocked exchange is a full barrier, a writer unpublishing after this point will see us
+	if (!__RCUReader.Nesting++) __RCUReader.Epoch = ~RCUEPOCH();
+	return true;
+}
+
+void TRCUDomain::Leave(void) {
+	if (!--__RCUReader.Nesting) __RCUReader.Epoch = 0;
+}
+
+__int64 TRCUDomain::Retire(void) {
+	return ++RCUEPOCH();
 }
 
-bool TLockableSRW::__Lock_Write_Do(TInterlockedArchInt &WaitCnt, TEvent &WaitEvent, WAITTIME Timeout, THandleWaitable *AbortEvent) {
-	_IMPL_AbortableLock(__TryLock_Write(), __Lock_Write_Probe(1), _T("SRW lock"));
+__int64 TRCUDomain::Horizon(void) {
+	__int64 iRet = ~RCUEPOCH();
+	auto Readers(RCUREADERS().Pickup());
+	for (auto Reader : *Readers) {
+		__int64 Epoch = ~Reader->Epoch;
+		if (Epoch && Epoch < iRet) iRet = Epoch;
+	}
+	return iRet;
 }
 
-#endif
\ No newline at end of file
+void TRCUDomain::Synchronize(void) {
+	if (__RCUReader.Nesting) FAIL(_T("Cannot wait for readers inside a read-side section"));
+	__int64 Retired = Retire();
+	// Read-side sections are short, yield first and only sleep for the stragglers
+	for (unsigned int Round = 0; Horizon() < Retired; Round++) {
+		if (Round < SPINLOCK_YIELD_ROUNDS) SwitchToThread();
+		else Sleep(1);
+	}
+}
\ No newline at end of file
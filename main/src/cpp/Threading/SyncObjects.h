@@ -52,6 +52,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "SyncElements.h"
 
+#include <vector>
+#include <algorithm>
+
 //#define __LOCK_DEBUG
 
 #ifdef __LOCK_DEBUG
@@ -115,7 +118,7 @@ public:
 			__LOCK_DEBUG({
 				int NewCnt = ++Instance->__Cnt;
 				if (!__IN_LOG && __Info) {
-					LOGVV(_T("%s"), TStringCast(_T("+ Locked @") << Instance
+					LOGVV(_T("%s"), TStringFmt(_T("+ Locked @") << (void*)Instance
 						<< _T(" (") << NewCnt << _T(')')).c_str());
 				}
 				});
@@ -127,8 +130,8 @@ public:
 				__LOCK_DEBUG({
 					int NewCnt = --Instance->__Cnt;
 					if (!__IN_LOG) {
-						LOGVV(_T("%s"), TStringCast(_T("- ") << (NewCnt ? _T("Locked") : _T("Unlocked"))
-							<< _T(" @") << Instance << _T(" (") << NewCnt << _T(')')).c_str())
+						LOGVV(_T("%s"), TStringFmt(_T("- ") << (NewCnt ? _T("Locked") : _T("Unlocked"))
+							<< _T(" @") << (void*)Instance << _T(" (") << NewCnt << _T(')')).c_str())
 					}
 					});
 			}
@@ -205,6 +208,15 @@ public:
 		return __New_Lock(__Lock(Timeout, AbortEvent) ? (TLockInfo*)-1 : nullptr);
 	}
 
+	/**
+	 * Acquire the lock before the deadline
+	 * Lockables that cannot keep sub-millisecond deadlines wait in whole milliseconds
+	 * @note Not an overload of Lock(), which would be hidden by the overrides
+	 **/
+	virtual TLock LockUntil(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) {
+		return Lock(Deadline.Remaining(), AbortEvent);
+	}
+
 	virtual TLock TryLock(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) {
 		return __New_Lock(__TryLock(SpinCount) ? (TLockInfo*)-1 : nullptr);
 	}
@@ -246,6 +258,8 @@ class TLockableCS : public TLockableSyncPerms<TCriticalSection> {
 private:
 	TInterlockedArchInt WaitCnt = 0;
 	TEvent WaitEvent = { CONSTRUCTION::DEFER };
+	TAdaptiveSpin SpinPolicy;
+	UINT64 HoldStart = 0;
 
 	void __Signal_Event(TEvent &Event) {
 		// We are in a transient state of deferred event creation
@@ -254,28 +268,69 @@ private:
 		Event.Set();
 	}
 
-	bool __Lock_Abortable(WAITTIME Timeout, THandleWaitable *AbortEvent);
+	bool __Lock_Abortable(TDeadline const &Deadline, THandleWaitable *AbortEvent);
 
 protected:
+	bool __Lock_Until(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+		if (!Deadline.Forever() || AbortEvent) {
+			if (!__Lock_Abortable(Deadline, AbortEvent)) return false;
+			return HoldStart = TAdaptiveSpin::Ticks(), true;
+		}
+		return Acquire(), true;
+	}
+
 	bool __Lock(WAITTIME Timeout, THandleWaitable *AbortEvent) override {
-		if (Timeout != FOREVER || AbortEvent)
-			return __Lock_Abortable(Timeout, AbortEvent);
-		// Fallback to legacy CS behavior
-		return Enter(), true;
+		return __Lock_Until(TDeadline(Timeout), AbortEvent);
 	}
 
 	bool __TryLock(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) override {
-#ifdef _DEBUG
-		if (!SpinCount) FAIL(_T("Spin count must be a natrual number"));
-#endif
-		while (--SpinCount && !TryEnter());
-		return SpinCount || TryEnter();
+		return TryAcquire(SpinCount);
 	}
 
 	void __Unlock(TLockInfo *LockInfo) override {
-		Leave();
+		Release();
 		if (~WaitCnt) __Signal_Event(WaitEvent);
 	}
+
+public:
+	TLock LockUntil(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) override {
+		return __New_Lock(__Lock_Until(Deadline, AbortEvent) ? (TLockInfo*)-1 : nullptr);
+	}
+
+	/**
+	 * Spin within the adaptive budget, then park until acquired
+	 **/
+	void Acquire(void) {
+		if (!SpinPolicy.Spin([&] { return TryEnter(1); })) {
+			UINT64 ParkStart = TAdaptiveSpin::Ticks();
+			Enter();
+			SpinPolicy.Parked(TAdaptiveSpin::Ticks() - ParkStart);
+		}
+		HoldStart = TAdaptiveSpin::Ticks();
+	}
+
+	/**
+	 * Spin within the adaptive budget, return false instead of parking
+	 **/
+	bool TryAcquire(void) {
+		return SpinPolicy.Spin([&] { return TryEnter(1); }) ? HoldStart = TAdaptiveSpin::Ticks(), true : false;
+	}
+
+	bool TryAcquire(__ARC_UINT SpinCount) {
+		return TryEnter(SpinCount) ? HoldStart = TAdaptiveSpin::Ticks(), true : false;
+	}
+
+	/**
+	 * Release lock acquired via Acquire() or TryAcquire()
+	 **/
+	void Release(void) {
+		SpinPolicy.Held(TAdaptiveSpin::Ticks() - HoldStart);
+		Leave();
+	}
+
+	TAdaptiveSpin const& Spin(void) const {
+		return SpinPolicy;
+	}
 };
 
 #ifdef __ZWUTILS_SYNC_SLIMRWLOCK
@@ -288,6 +343,8 @@ private:
 	TInterlockedArchInt WWaitCnt = 0;
 	TEvent RWaitEvent = { CONSTRUCTION::DEFER };
 	TEvent WWaitEvent = { CONSTRUCTION::DEFER };
+	TAdaptiveSpin SpinPolicy;
+	UINT64 HoldStart = 0;
 
 	void __Signal_Event(TEvent &Event) {
 		// We are in a transient state of deferred event creation
@@ -299,8 +356,8 @@ public:
 	bool ReadYieldToWrite = false;
 
 protected:
-	bool __Lock_Read_Do(TInterlockedArchInt &WaitCnt, TEvent &WaitEvent, WAITTIME Timeout, THandleWaitable *AbortEvent);
-	bool __Lock_Write_Do(TInterlockedArchInt &WaitCnt, TEvent &WaitEvent, WAITTIME Timeout, THandleWaitable *AbortEvent);
+	bool __Lock_Read_Do(TInterlockedArchInt &WaitCnt, TEvent &WaitEvent, TDeadline const &Deadline, THandleWaitable *AbortEvent);
+	bool __Lock_Write_Do(TInterlockedArchInt &WaitCnt, TEvent &WaitEvent, TDeadline const &Deadline, THandleWaitable *AbortEvent);
 
 	bool __Lock_Read_Probe(__ARC_UINT SpinCount) {
 		if (ReadYieldToWrite && ~WWaitCnt) return false;
@@ -312,15 +369,15 @@ protected:
 		}
 		return false;
 	}
-	bool __Lock_Read(WAITTIME Timeout, THandleWaitable *AbortEvent) {
-		return __Lock_Read_Do(RWaitCnt, RWaitEvent, Timeout, AbortEvent);
+	bool __Lock_Read(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+		return __Lock_Read_Do(RWaitCnt, RWaitEvent, Deadline, AbortEvent);
 	}
 
 	bool __Lock_Write_Probe(__ARC_UINT SpinCount) {
-		return TryWrite(SpinCount);
+		return TryWrite(SpinCount) ? HoldStart = TAdaptiveSpin::Ticks(), true : false;
 	}
-	bool __Lock_Write(WAITTIME Timeout, THandleWaitable *AbortEvent) {
-		return __Lock_Write_Do(WWaitCnt, WWaitEvent, Timeout, AbortEvent);
+	bool __Lock_Write(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+		return __Lock_Write_Do(WWaitCnt, WWaitEvent, Deadline, AbortEvent);
 	}
 
 	bool __TryLock_Read(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) {
@@ -339,6 +396,7 @@ protected:
 		__Impl_Unlock(EndRead);
 	}
 	void __Unlock_Write(void) {
+		SpinPolicy.Held(TAdaptiveSpin::Ticks() - HoldStart);
 		__Impl_Unlock(EndWrite);
 	}
 
@@ -358,17 +416,29 @@ protected:
 
 public:
 	TLock Lock_Read(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
-		return __New_Lock(__Lock_Read(Timeout, AbortEvent) ? &__ReadLockInfo : nullptr);
+		return Lock_Read(TDeadline(Timeout), AbortEvent);
+	}
+
+	TLock Lock_Read(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) {
+		return __New_Lock(__Lock_Read(Deadline, AbortEvent) ? &__ReadLockInfo : nullptr);
 	}
 
 	TLock Lock_Write(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
-		return __New_Lock(__Lock_Write(Timeout, AbortEvent) ? &__WriteLockInfo : nullptr);
+		return Lock_Write(TDeadline(Timeout), AbortEvent);
+	}
+
+	TLock Lock_Write(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) {
+		return __New_Lock(__Lock_Write(Deadline, AbortEvent) ? &__WriteLockInfo : nullptr);
 	}
 
 	TLock Lock(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) override {
 		return Lock_Write(Timeout, AbortEvent);
 	}
 
+	TLock LockUntil(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) override {
+		return Lock_Write(Deadline, AbortEvent);
+	}
+
 	TLock TryLock_Read(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) {
 		return __New_Lock(__TryLock_Read(SpinCount) ? &__ReadLockInfo : nullptr);
 	}
@@ -390,6 +460,10 @@ public:
 		TSRWLockInfo *__Info = static_cast<TSRWLockInfo*>(TLockable::__LockInfo(Lock));
 		return __Info && __Info->Exclusive;
 	}
+
+	TAdaptiveSpin const& Spin(void) const {
+		return SpinPolicy;
+	}
 };
 
 #endif
@@ -402,9 +476,10 @@ class TLockableHandleWaitable : public TLockableSyncPerms<W> {
 
 protected:
 	bool __Lock(WAITTIME Timeout, THandleWaitable *AbortEvent) override {
-		WaitResult WRet = AbortEvent ?
-			WaitMultiple({ {*(THandleWaitable*)this}, {*AbortEvent} }, false, Timeout) :
-			WaitFor(Timeout);
+		return __Lock_Result(AbortEvent ? W::WaitUntil(TDeadline(Timeout), AbortEvent) : WaitFor(Timeout));
+	}
+
+	bool __Lock_Result(WaitResult WRet) {
 		switch (WRet) {
 			case WaitResult::Error: SYSFAIL(_T("Failed to lock synchronization premises"));
 			case WaitResult::Signaled:
@@ -432,6 +507,10 @@ protected:
 		while (--SpinCount && !__TryLock_Once());
 		return SpinCount || __TryLock_Once();
 	}
+public:
+	TLockable::TLock LockUntil(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) override {
+		return this->__New_Lock(__Lock_Result(W::WaitUntil(Deadline, AbortEvent)) ? (TLockable::TLockInfo*)-1 : nullptr);
+	}
 };
 
 // !Lockable using semaphore
@@ -454,6 +533,423 @@ protected:
 	}
 };
 
+#define SPINLOCK_CACHELINE		64
+#define SPINLOCK_BACKOFF_SHIFT	10
+#define SPINLOCK_YIELD_ROUNDS	16
+#define SPINLOCK_QUEUE_PAUSE	32	// Pauses per waiter ahead in a FIFO queue
+
+// !Base of user-mode spin locks, provides backoff and abortable waiting
+class TLockableSpin : public TLockable {
+	typedef TLockableSpin _this;
+
+protected:
+	TInterlockedArchInt WaitCnt = 0;
+	TEvent WaitEvent = { CONSTRUCTION::DEFER };
+
+	void __Signal_Waiters(void) {
+		if (~WaitCnt) {
+			// We are in a transient state of deferred event creation
+			// Just hold the breath for a while
+			while (!WaitEvent.Allocated()) SwitchToThread();
+			WaitEvent.Set();
+		}
+	}
+
+	// Exponential backoff, yield the processor if the lock holder is not making progress
+	static void __Backoff(__ARC_UINT &Round) {
+		if (++Round < SPINLOCK_YIELD_ROUNDS) {
+			__ARC_UINT Pause = (__ARC_UINT)1 << std::min(Round, (__ARC_UINT)SPINLOCK_BACKOFF_SHIFT);
+			while (Pause--) YieldProcessor();
+		} else SwitchToThread();
+	}
+
+	// Proportional backoff by queue position
+	// The next in line keeps spinning so it never sleeps through (or yields away) its turn
+	static void __Backoff_Queued(__ARC_UINT &Round, __ARC_UINT Ahead) {
+		if (Ahead > 1) {
+			if (++Round >= SPINLOCK_YIELD_ROUNDS) {
+				Round = 0;
+				SwitchToThread();
+				return;
+			}
+			__ARC_UINT Pause = (Ahead - 1) * SPINLOCK_QUEUE_PAUSE;
+			while (Pause--) YieldProcessor();
+		} else YieldProcessor();
+	}
+};
+
+/**
+ * @ingroup Threading
+ * @brief Test-and-test-and-set spin lock
+ *
+ * Cheapest lock for very short critical sections, no fairness guarantee
+ **/
+class TLockableTTAS : public TLockableSpin {
+	typedef TLockableTTAS _this;
+
+private:
+	TInterlockedOrdinal32<long> Flag = 0;
+
+	bool __Lock_Abortable(TDeadline const &Deadline, THandleWaitable *AbortEvent);
+
+protected:
+	bool __TryLock_Once(void) {
+		return !~Flag && !Flag.Exchange(1);
+	}
+
+	bool __Lock_Until(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+		if (!Deadline.Forever() || AbortEvent)
+			return __Lock_Abortable(Deadline, AbortEvent);
+		__ARC_UINT Round = 0;
+		while (!__TryLock_Once()) {
+			// Spin on a shared read, avoid bouncing the cache line with writes
+			while (~Flag) __Backoff(Round);
+		}
+		return true;
+	}
+
+	bool __Lock(WAITTIME Timeout, THandleWaitable *AbortEvent) override {
+		return __Lock_Until(TDeadline(Timeout), AbortEvent);
+	}
+
+	bool __TryLock(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) override {
+#ifdef _DEBUG
+		if (!SpinCount) FAIL(_T("Spin count must be a natrual number"));
+#endif
+		while (--SpinCount && !__TryLock_Once()) YieldProcessor();
+		return SpinCount || __TryLock_Once();
+	}
+
+	void __Unlock(TLockInfo *LockInfo) override {
+		Flag = 0;
+		__Signal_Waiters();
+	}
+
+public:
+	TLock LockUntil(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) override {
+		return __New_Lock(__Lock_Until(Deadline, AbortEvent) ? (TLockInfo*)-1 : nullptr);
+	}
+};
+
+/**
+ * @ingroup Threading
+ * @brief Ticket spin lock
+ *
+ * FIFO fair spin lock, waiters back off in proportion to their queue position
+ * Note: A ticket cannot be abandoned, so timed or abortable acquisitions do not take one;
+ *       they poll and only succeed when nobody is queued, hence are NOT fair and may time out
+ *       under sustained contention even if the lock is released many times in between
+ **/
+class TLockableTicket : public TLockableSpin {
+	typedef TLockableTicket _this;
+
+private:
+	TInterlockedOrdinal32<unsigned long> NextTicket = 0;
+	TInterlockedOrdinal32<unsigned long> NowServing = 0;
+
+	bool __Lock_Abortable(TDeadline const &Deadline, THandleWaitable *AbortEvent);
+
+protected:
+	bool __TryLock_Once(void) {
+		unsigned long Serving = ~NowServing;
+		return NextTicket.CompareAndSwap(Serving, Serving + 1) == Serving;
+	}
+
+	bool __Lock_Until(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+		if (!Deadline.Forever() || AbortEvent)
+			return __Lock_Abortable(Deadline, AbortEvent);
+		unsigned long Ticket = NextTicket++;
+		__ARC_UINT Round = 0;
+		while (unsigned long Ahead = Ticket - ~NowServing) __Backoff_Queued(Round, Ahead);
+		return true;
+	}
+
+	bool __Lock(WAITTIME Timeout, THandleWaitable *AbortEvent) override {
+		return __Lock_Until(TDeadline(Timeout), AbortEvent);
+	}
+
+	bool __TryLock(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) override {
+#ifdef _DEBUG
+		if (!SpinCount) FAIL(_T("Spin count must be a natrual number"));
+#endif
+		while (--SpinCount && !__TryLock_Once()) YieldProcessor();
+		return SpinCount || __TryLock_Once();
+	}
+
+	void __Unlock(TLockInfo *LockInfo) override {
+		++NowServing;
+		__Signal_Waiters();
+	}
+
+public:
+	TLock LockUntil(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) override {
+		return __New_Lock(__Lock_Until(Deadline, AbortEvent) ? (TLockInfo*)-1 : nullptr);
+	}
+};
+
+#define MCSLOCK_LOCKNODES		8	// Concurrent holders and waiters of an MCS lock served without allocation
+
+/**
+ * @ingroup Threading
+ * @brief MCS queue lock
+ *
+ * FIFO fair spin lock, each waiter spins on its own cache line so handoff does not
+ * generate coherence traffic proportional to the number of waiters
+ * Note: Queue nodes belong to the lock, not to the acquiring thread, so a lock may be released by
+ *       another thread, including after the acquiring thread has exited
+ * Note: A queued node cannot be abandoned, so timed or abortable acquisitions do not enqueue;
+ *       they poll and only succeed when nobody is queued, hence are NOT fair and may time out
+ *       under sustained contention even if the lock is released many times in between
+ **/
+class TLockableMCS : public TLockableSpin {
+	typedef TLockableMCS _this;
+
+protected:
+	// Each node takes a whole cache line, so waiters do not share the line they spin on
+	class alignas(SPINLOCK_CACHELINE) TMCSNode : public TLockInfo {
+	public:
+		TMCSNode * volatile Next = nullptr;
+		long volatile Waiting = 1;
+		long volatile InUse = 0;
+		bool Pooled = true;
+	};
+
+	TMCSNode * volatile Tail = nullptr;
+	// Embedded nodes, enough for the usual number of contenders, so acquisition does not allocate
+	TMCSNode _Nodes[MCSLOCK_LOCKNODES];
+
+	bool __Lock_Abortable(TMCSNode *Node, TDeadline const &Deadline, THandleWaitable *AbortEvent);
+
+	bool __TryLock_Node(TMCSNode *Node) {
+		return !Tail && !InterlockedCompareExchangePointer((PVOID volatile*)&Tail, Node, nullptr);
+	}
+
+	bool __TryLock_Node(TMCSNode *Node, __ARC_UINT SpinCount) {
+#ifdef _DEBUG
+		if (!SpinCount) FAIL(_T("Spin count must be a natrual number"));
+#endif
+		while (--SpinCount && !__TryLock_Node(Node)) YieldProcessor();
+		return SpinCount || __TryLock_Node(Node);
+	}
+
+	bool __Lock_Node(TMCSNode *Node, TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+		if (!Deadline.Forever() || AbortEvent)
+			return __Lock_Abortable(Node, Deadline, AbortEvent);
+		TMCSNode *Pred = (TMCSNode*)InterlockedExchangePointer((PVOID volatile*)&Tail, Node);
+		if (Pred) {
+			Pred->Next = Node;
+			__ARC_UINT Round = 0;
+			while (Node->Waiting) __Backoff(Round);
+		}
+		return true;
+	}
+
+	void __Unlock(TLockInfo *LockInfo) override {
+		TMCSNode *Node = static_cast<TMCSNode*>(LockInfo);
+		if (Node->Next || InterlockedCompareExchangePointer((PVOID volatile*)&Tail, nullptr, Node) != Node) {
+			// A successor is linking itself in, wait for it then hand over
+			while (!Node->Next) YieldProcessor();
+			InterlockedExchange(&Node->Next->Waiting, 0);
+		}
+		__Release_Node(Node);
+		__Signal_Waiters();
+	}
+
+	TMCSNode* __Acquire_Node(void) {
+		TMCSNode *Node = nullptr;
+		// Start from a per-thread position, so concurrent contenders rarely race for the same node
+		size_t Start = (GetCurrentThreadId() >> 2) % MCSLOCK_LOCKNODES;
+		for (size_t i = 0; i < MCSLOCK_LOCKNODES; i++) {
+			TMCSNode &LockNode = _Nodes[(Start + i) % MCSLOCK_LOCKNODES];
+			if (!LockNode.InUse && !InterlockedExchange(&LockNode.InUse, 1)) {
+				Node = &LockNode;
+				break;
+			}
+		}
+		if (!Node) {
+			// More contenders than the embedded nodes cover
+			void *Buf = _aligned_malloc(sizeof(TMCSNode), SPINLOCK_CACHELINE);
+			if (!Buf) FAIL(_T("Unable to allocate MCS lock node"));
+			Node = new (Buf) TMCSNode;
+			Node->Pooled = false;
+		}
+		Node->Next = nullptr;
+		Node->Waiting = 1;
+		return Node;
+	}
+
+	static void __Release_Node(TMCSNode *Node) {
+		if (Node->Pooled) Node->InUse = 0;
+		else _aligned_free(Node);
+	}
+
+	typedef TAllocResource<TMCSNode*> TNodeResource;
+
+	TNodeResource __New_Node(void) {
+		return { __Acquire_Node(), [](TMCSNode* &Node) { __Release_Node(Node); } };
+	}
+
+public:
+	TLock Lock(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) override {
+		return LockUntil(TDeadline(Timeout), AbortEvent);
+	}
+
+	TLock LockUntil(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) override {
+		auto Node = __New_Node();
+		if (!__Lock_Node(*Node, Deadline, AbortEvent)) return NullLock();
+		return __New_Lock(*Node.Drop());
+	}
+
+	TLock TryLock(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) override {
+		auto Node = __New_Node();
+		if (!__TryLock_Node(*Node, SpinCount)) return NullLock();
+		return __New_Lock(*Node.Drop());
+	}
+};
+
+#define DISTRIBUTEDRW_SLOTS		64
+
+/**
+ * @ingroup Threading
+ * @brief Distributed reader-writer lock
+ *
+ * Big-reader lock for read-mostly state: a reader only touches the counter slot of its current
+ * processor, a writer raises a flag and sweeps all slots until active readers drain
+ * Note: Writer preferred, a pending writer holds off new readers
+ **/
+class TLockableDRW : public TLockableSpin {
+	typedef TLockableDRW _this;
+
+protected:
+	// Each slot, and the writer flag, on its own cache line
+	class alignas(SPINLOCK_CACHELINE) TReaderSlot : public TLockInfo {
+	public:
+		TInterlockedOrdinal32<long> Readers = 0;
+	};
+
+	alignas(SPINLOCK_CACHELINE) TInterlockedOrdinal32<long> Writer = 0;
+	TReaderSlot Slots[DISTRIBUTEDRW_SLOTS];
+
+	static TLockInfo __WriteLockInfo;
+
+	bool __Lock_Read_Abortable(TReaderSlot* &Slot, TDeadline const &Deadline, THandleWaitable *AbortEvent);
+	bool __Lock_Write_Abortable(TDeadline const &Deadline, THandleWaitable *AbortEvent);
+
+	TReaderSlot* __Lock_Read_Probe(void) {
+		if (!~Writer) {
+			TReaderSlot *Slot = &Slots[GetCurrentProcessorNumber() % DISTRIBUTEDRW_SLOTS];
+			++Slot->Readers;
+			// Interlocked increment is a full barrier, a writer raising its flag after this point will see us
+			if (!~Writer) return Slot;
+			--Slot->Readers;
+			__Signal_Waiters();
+		}
+		return nullptr;
+	}
+
+	bool __Readers_Drained(void) {
+		for (auto &Slot : Slots) if (~Slot.Readers) return false;
+		return true;
+	}
+
+	bool __Lock_Write_Probe(void) {
+		if (~Writer || Writer.CompareAndSwap(0, 1)) return false;
+		if (__Readers_Drained()) return true;
+		// Do not hold off readers while we are not committed to wait
+		Writer = 0;
+		__Signal_Waiters();
+		return false;
+	}
+
+	TReaderSlot* __TryLock_Read(__ARC_UINT SpinCount) {
+#ifdef _DEBUG
+		if (!SpinCount) FAIL(_T("Spin count must be a natrual number"));
+#endif
+		TReaderSlot *Slot = nullptr;
+		while (--SpinCount && !(Slot = __Lock_Read_Probe())) YieldProcessor();
+		return SpinCount ? Slot : __Lock_Read_Probe();
+	}
+
+	bool __TryLock_Write(__ARC_UINT SpinCount) {
+#ifdef _DEBUG
+		if (!SpinCount) FAIL(_T("Spin count must be a natrual number"));
+#endif
+		while (--SpinCount && !__Lock_Write_Probe()) YieldProcessor();
+		return SpinCount || __Lock_Write_Probe();
+	}
+
+	TReaderSlot* __Lock_Read(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+		TReaderSlot *Slot = nullptr;
+		if (!Deadline.Forever() || AbortEvent)
+			return __Lock_Read_Abortable(Slot, Deadline, AbortEvent) ? Slot : nullptr;
+		__ARC_UINT Round = 0;
+		while (!(Slot = __Lock_Read_Probe())) {
+			while (~Writer) __Backoff(Round);
+		}
+		return Slot;
+	}
+
+	bool __Lock_Write(TDeadline const &Deadline, THandleWaitable *AbortEvent) {
+		if (!Deadline.Forever() || AbortEvent)
+			return __Lock_Write_Abortable(Deadline, AbortEvent);
+		__ARC_UINT Round = 0;
+		while (~Writer || Writer.CompareAndSwap(0, 1)) __Backoff(Round);
+		// Flag raised, new readers back off, wait for active readers to drain
+		Round = 0;
+		for (auto &Slot : Slots) {
+			while (~Slot.Readers) __Backoff(Round);
+		}
+		return true;
+	}
+
+	void __Unlock(TLockInfo *LockInfo) override {
+		if (LockInfo == &__WriteLockInfo) Writer = 0;
+		else --static_cast<TReaderSlot*>(LockInfo)->Readers;
+		__Signal_Waiters();
+	}
+
+public:
+	TLock Lock_Read(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
+		return Lock_Read(TDeadline(Timeout), AbortEvent);
+	}
+
+	TLock Lock_Read(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) {
+		return __New_Lock(__Lock_Read(Deadline, AbortEvent));
+	}
+
+	TLock Lock_Write(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
+		return Lock_Write(TDeadline(Timeout), AbortEvent);
+	}
+
+	TLock Lock_Write(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) {
+		return __New_Lock(__Lock_Write(Deadline, AbortEvent) ? &__WriteLockInfo : nullptr);
+	}
+
+	TLock Lock(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) override {
+		return Lock_Write(Timeout, AbortEvent);
+	}
+
+	TLock LockUntil(TDeadline const &Deadline, THandleWaitable *AbortEvent = nullptr) override {
+		return Lock_Write(Deadline, AbortEvent);
+	}
+
+	TLock TryLock_Read(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) {
+		return __New_Lock(__TryLock_Read(SpinCount));
+	}
+
+	TLock TryLock_Write(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) {
+		return __New_Lock(__TryLock_Write(SpinCount) ? &__WriteLockInfo : nullptr);
+	}
+
+	TLock TryLock(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) override {
+		return TryLock_Write(SpinCount);
+	}
+
+	bool ForWrite(TLock const &Lock) const {
+		return TLockable::__LockInfo(Lock) == &__WriteLockInfo;
+	}
+};
+
 //#define __SyncObj_Lite
 
 /**
@@ -516,12 +1012,12 @@ public:
 
 		template<typename X = TObject>
 		auto _toString(void) const -> decltype(std::enable_if<Has_toString<X>::value, TString>::type()) {
-			return Valid() ? TStringCast(_T("#SObj(L):") << (*this)->toString()) : TStringCast(_T("#SObj(U)") << _AccessObjRef());
+			return Valid() ? TStringFmt(_T("#SObj(L):") << (*this)->toString()) : TStringFmt(_T("#SObj(U)") << (void*)_AccessObjRef());
 		}
 
 		template<typename X = TObject, typename = void>
 		auto _toString(void) const -> decltype(std::enable_if<!Has_toString<X>::value, TString>::type()) {
-			return TStringCast(_T("#SObj(") << (Valid() ? _T('L') : _T('U')) << _T("):") << _AccessObjRef());
+			return TStringFmt(_T("#SObj(") << (Valid() ? _T('L') : _T('U')) << _T("):") << (void*)_AccessObjRef());
 		}
 
 		TObject* _ObjPointer(void) const {
@@ -636,39 +1132,41 @@ public:
 
 	// Note: For performance reasons, we do not have a virtual destructor
 	// Hence we seal this class and do not allow further derivation
-	class Accessor final {
-		typedef Accessor _this;
+	// Shared lock holders get a const view of the instance
+	template<typename TTarget>
+	class TAccessor final {
+		typedef TAccessor _this;
 		friend class TSyncObj<TObject, L>;
 
 	protected:
 		TLock _Lock;
 
-		Accessor(TLock &&xLock) : _Lock(std::move(xLock)) {}
+		TAccessor(TLock &&xLock) : _Lock(std::move(xLock)) {}
 
 		MEMBERFUNC_PROBE(toString);
 
-		TObject* _AccessObjRef(void) const {
+		TTarget* _AccessObjRef(void) const {
 			return std::addressof(static_cast<TSyncObj*>(TLockable::__SyncInst(_Lock))->_Instance);
 		}
 
 		template<typename X = TObject>
 		auto _toString(void) const -> decltype(std::enable_if<Has_toString<X>::value, TString>::type()) {
-			return Valid() ? TStringCast(_T("#SObj(L):") << (*this)->toString()) : TStringCast(_T("#SObj(U)") << _AccessObjRef());
+			return Valid() ? TStringFmt(_T("#SObj(L):") << (*this)->toString()) : TStringFmt(_T("#SObj(U)") << (void*)_AccessObjRef());
 		}
 
 		template<typename X = TObject, typename = void>
 		auto _toString(void) const -> decltype(std::enable_if<!Has_toString<X>::value, TString>::type()) {
-			return TStringCast(_T("#SObj(") << (Valid() ? _T('L') : _T('U')) << _T("):") << _AccessObjRef());
+			return TStringFmt(_T("#SObj(") << (Valid() ? _T('L') : _T('U')) << _T("):") << (void*)_AccessObjRef());
 		}
 
-		TObject* _ObjPointer(void) const {
+		TTarget* _ObjPointer(void) const {
 			if (!Valid()) FAIL(_T("Invalid accessor state"));
 			return _AccessObjRef();
 		}
 
 	public:
 		// Move construction for returning accessors
-		Accessor(_this &&xAccessor) : _Lock(std::move(xAccessor._Lock)) {}
+		TAccessor(_this &&xAccessor) : _Lock(std::move(xAccessor._Lock)) {}
 
 		TString toString(void) const {
 			return _toString();
@@ -690,18 +1188,21 @@ public:
 			return this;
 		}
 
-		TObject* operator&(void) const {
+		TTarget* operator&(void) const {
 			return _ObjPointer();
 		}
-		TObject& operator*(void) const {
+		TTarget& operator*(void) const {
 			return *_ObjPointer();
 		}
-		TObject* operator->(void) const {
+		TTarget* operator->(void) const {
 			return _ObjPointer();
 		}
 
 	};
 
+	typedef TAccessor<TObject> Accessor;
+	typedef TAccessor<TObject const> ReadAccessor;
+
 	TLock Lock(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) override {
 		auto iRet = _Lockable->Lock(Timeout, AbortEvent);
 		return std::move(__Adopt(iRet));
@@ -730,6 +1231,24 @@ public:
 		return { std::move(const_cast<TSyncObj*>(this)->__Adopt(iRet)) };
 	}
 
+	/**
+	 * Lock for shared reading and return a const accessor of managed T instance
+	 * @note Requires a reader-writer lockable
+	 **/
+	ReadAccessor Pickup_Read(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) const {
+		auto iRet = _Lockable->Lock_Read(Timeout, AbortEvent);
+		return { std::move(const_cast<TSyncObj*>(this)->__Adopt(iRet)) };
+	}
+
+	/**
+	 * Try to lock for shared reading and return a const accessor of managed T instance, check validty before access
+	 * @note Requires a reader-writer lockable
+	 **/
+	ReadAccessor TryPickup_Read(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) const {
+		auto iRet = _Lockable->TryLock_Read(SpinCount);
+		return { std::move(const_cast<TSyncObj*>(this)->__Adopt(iRet)) };
+	}
+
 	/**
 	 * Return an invalid accessor
 	 **/
@@ -741,4 +1260,397 @@ public:
 
 #endif
 
+// Readers rely on load ordering, x86 / x64 never reorder loads with other loads
+#if defined(_M_ARM) || defined(_M_ARM64)
+#define __SEQLOCK_READ_FENCE()	MemoryBarrier()
+#else
+#define __SEQLOCK_READ_FENCE()	_ReadBarrier()
+#endif
+
+/**
+ * @ingroup Threading
+ * @brief Sequence lock protected object
+ *
+ * For small trivially copyable objects that are read far more often than written
+ * - Writers serialize through the lockable, and bump a sequence counter around each update
+ * - Readers copy the object optimistically and retry if a write overlapped, never writing to shared memory
+ **/
+template<class TObject, class L = TLockableCS>
+class TSeqLockObj : public TLockable {
+	ENFORCE_DERIVE(TLockable, L);
+	static_assert(std::is_trivially_copyable<TObject>::value, "Sequence lock requires trivially copyable object");
+	typedef TSeqLockObj _this;
+
+protected:
+	TInterlockedOrdinal32<long> _Sequence = 0;
+	TObject _Instance;
+	mutable L _Lockable;
+
+	TLock& __Begin_Write(TLock &Lock) {
+		// Odd sequence marks an update in progress
+		if (Lock) ++_Sequence;
+		return __Adopt(Lock);
+	}
+
+	void __Unlock(TLockInfo *LockInfo) override {
+		++_Sequence;
+		__Cascade_Unlock(&_Lockable, LockInfo);
+	}
+
+public:
+	template<typename... Params>
+	TSeqLockObj(Params&&... xParams) : _Instance(std::forward<Params>(xParams)...) {}
+
+	// Copy and move constructions are hard to reason, therefore better disable it
+	TSeqLockObj(_this const &xSyncObj) = delete;
+	TSeqLockObj(_this &&xSyncObj) = delete;
+
+	// Assignment operations are wacky, the meaning is hard to reason, therefore better disable it
+	_this& operator=(_this const &) = delete;
+	_this& operator=(_this &&) = delete;
+
+	// Note: For performance reasons, we do not have a virtual destructor
+	// Hence we seal this class and do not allow further derivation
+	class Accessor final {
+		typedef Accessor _this;
+		friend class TSeqLockObj<TObject, L>;
+
+	protected:
+		TLock _Lock;
+
+		Accessor(TLock &&xLock) : _Lock(std::move(xLock)) {}
+
+		TObject* _ObjPointer(void) const {
+			if (!Valid()) FAIL(_T("Invalid accessor state"));
+			return std::addressof(static_cast<TSeqLockObj*>(TLockable::__SyncInst(_Lock))->_Instance);
+		}
+
+	public:
+		// Move construction for returning accessors
+		Accessor(_this &&xAccessor) : _Lock(std::move(xAccessor._Lock)) {}
+
+		bool Valid(void) const {
+			return _Lock;
+		}
+
+		operator bool() const {
+			return Valid();
+		}
+
+		TObject& operator*(void) const {
+			return *_ObjPointer();
+		}
+		TObject* operator->(void) const {
+			return _ObjPointer();
+		}
+	};
+
+	TLock Lock(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) override {
+		auto iRet = _Lockable.Lock(Timeout, AbortEvent);
+		return std::move(__Begin_Write(iRet));
+	}
+
+	TLock TryLock(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) override {
+		auto iRet = _Lockable.TryLock(SpinCount);
+		return std::move(__Begin_Write(iRet));
+	}
+
+	/**
+	 * Lock for writing and return an accessor of managed T instance
+	 **/
+	Accessor Pickup(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
+		return { Lock(Timeout, AbortEvent) };
+	}
+
+	/**
+	 * Try to lock for writing and return an accessor of managed T instance, check validty before access
+	 **/
+	Accessor TryPickup(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) {
+		return { TryLock(SpinCount) };
+	}
+
+	/**
+	 * Return an invalid accessor
+	 **/
+	Accessor NullAccessor(void) const {
+		return { NullLock() };
+	}
+
+	/**
+	 * Optimistically copy out a consistent snapshot of managed T instance
+	 **/
+	void Read(TObject &Snapshot) const {
+		__ARC_UINT Round = 0;
+		while (true) {
+			long Sequence = ~_Sequence;
+			if (!(Sequence & 1)) {
+				__SEQLOCK_READ_FENCE();
+				memcpy(std::addressof(Snapshot), std::addressof(_Instance), sizeof(TObject));
+				__SEQLOCK_READ_FENCE();
+				if (~_Sequence == Sequence) return;
+			}
+			// Writer in progress, back off and yield if it does not finish soon
+			if (++Round < SPINLOCK_YIELD_ROUNDS) YieldProcessor();
+			else SwitchToThread();
+		}
+	}
+
+	TObject Read(void) const {
+		typename std::aligned_storage<sizeof(TObject), alignof(TObject)>::type Snapshot;
+		Read(*reinterpret_cast<TObject*>(&Snapshot));
+		return *reinterpret_cast<TObject*>(&Snapshot);
+	}
+};
+
+/**
+ * @ingroup Threading
+ * @brief Read-copy-update grace period tracking
+ *
+ * Every reading thread publishes the global epoch at which it entered a read-side section,
+ * a retired version can be reclaimed once no thread is still inside a section entered before its retirement
+ **/
+class TRCUDomain {
+	typedef TRCUDomain _this;
+
+public:
+	/**
+	 * Enter a read-side section on the current thread (nestable)
+	 **/
+	static void Enter(void);
+
+	/**
+	 * Enter a read-side section on the current thread, unless registering the thread as a reader takes longer than timeout
+	 * @return false if the section was not entered
+	 **/
+	static bool TryEnter(WAITTIME Timeout);
+
+	/**
+	 * Leave a read-side section on the current thread
+	 **/
+	static void Leave(void);
+
+	/**
+	 * Advance the global epoch, and return the retirement epoch for a version just unpublished
+	 **/
+	static __int64 Retire(void);
+
+	/**
+	 * Return the entry epoch of the oldest active read-side section
+	 * @note Versions retired at or before the returned epoch are safe to reclaim
+	 **/
+	static __int64 Horizon(void);
+
+	/**
+	 * Wait until every read-side section entered before the call has left
+	 * @note Must not be called inside a read-side section of the current thread
+	 **/
+	static void Synchronize(void);
+};
+
+/**
+ * @ingroup Threading
+ * @brief Read-copy-update protected object
+ *
+ * For shared state that is read on every operation and written almost never
+ * - Readers take a const snapshot of the current version, without locking or writing to shared memory
+ * - Writers serialize through the lockable, modify a private copy, and publish it atomically on release
+ * - Unpublished versions are reclaimed by later writers after all readers that may still see them have left
+ * Note: A snapshot must be released on the thread that took it
+ **/
+template<class TObject, class L = TLockableCS>
+class TRCUObj : public TLockable {
+	ENFORCE_DERIVE(TLockable, L);
+	typedef TRCUObj _this;
+
+protected:
+	class TVersion {
+	public:
+		TObject Instance;
+		__int64 Retired = 0;
+
+		template<typename... Params>
+		TVersion(Params&&... xParams) : Instance(std::forward<Params>(xParams)...) {}
+	};
+
+	TInterlockedOrdinal<TVersion*> _Current;
+	TVersion *_Draft = nullptr;
+	unsigned int _Writers = 0;
+	std::vector<TVersion*> _Retired;
+	mutable L _Lockable;
+
+	TLock& __Begin_Write(TLock &Lock) {
+		if (Lock) {
+			// Nested writers (via recursive lockables) share the same private copy
+			if (!_Writers) _Draft = DEFAULT_NEW(TVersion, (~_Current)->Instance);
+			++_Writers;
+		}
+		return __Adopt(Lock);
+	}
+
+	void __Reclaim(void) {
+		__int64 Horizon = TRCUDomain::Horizon();
+		auto Iter = std::remove_if(_Retired.begin(), _Retired.end(), [&](TVersion *Version) {
+			if (Version->Retired > Horizon) return false;
+			DEFAULT_DESTROY(TVersion, Version);
+			return true;
+		});
+		_Retired.erase(Iter, _Retired.end());
+	}
+
+	void __Publish(void) {
+		TVersion *Version = _Current.Exchange(_Draft);
+		_Draft = nullptr;
+		Version->Retired = TRCUDomain::Retire();
+		_Retired.push_back(Version);
+		__Reclaim();
+	}
+
+	void __Unlock(TLockInfo *LockInfo) override {
+		if (!--_Writers) __Publish();
+		__Cascade_Unlock(&_Lockable, LockInfo);
+	}
+
+public:
+	template<typename... Params>
+	TRCUObj(Params&&... xParams) : _Current(DEFAULT_NEW(TVersion, std::forward<Params>(xParams)...)) {}
+
+	~TRCUObj(void) {
+		// Readers must not outlive the object, so all versions can go right away
+		for (auto Version : _Retired) DEFAULT_DESTROY(TVersion, Version);
+		DEFAULT_DESTROY(TVersion, ~_Current);
+	}
+
+	// Copy and move constructions are hard to reason, therefore better disable it
+	TRCUObj(_this const &xSyncObj) = delete;
+	TRCUObj(_this &&xSyncObj) = delete;
+
+	// Assignment operations are wacky, the meaning is hard to reason, therefore better disable it
+	_this& operator=(_this const &) = delete;
+	_this& operator=(_this &&) = delete;
+
+	// Note: For performance reasons, we do not have a virtual destructor
+	// Hence we seal this class and do not allow further derivation
+	class Accessor final {
+		typedef Accessor _this;
+		friend class TRCUObj<TObject, L>;
+
+	protected:
+		TLock _Lock;
+
+		Accessor(TLock &&xLock) : _Lock(std::move(xLock)) {}
+
+		TObject* _ObjPointer(void) const {
+			if (!Valid()) FAIL(_T("Invalid accessor state"));
+			return std::addressof(static_cast<TRCUObj*>(TLockable::__SyncInst(_Lock))->_Draft->Instance);
+		}
+
+	public:
+		// Move construction for returning accessors
+		Accessor(_this &&xAccessor) : _Lock(std::move(xAccessor._Lock)) {}
+
+		bool Valid(void) const {
+			return _Lock;
+		}
+
+		operator bool() const {
+			return Valid();
+		}
+
+		TObject& operator*(void) const {
+			return *_ObjPointer();
+		}
+		TObject* operator->(void) const {
+			return _ObjPointer();
+		}
+	};
+
+	class Snapshot final {
+		typedef Snapshot _this;
+		friend class TRCUObj<TObject, L>;
+
+	protected:
+		TVersion const *_Version;
+
+		Snapshot(TVersion const *xVersion) : _Version(xVersion) {}
+
+	public:
+		// Move construction for returning snapshots
+		Snapshot(_this &&xSnapshot) : _Version(xSnapshot._Version) {
+			xSnapshot._Version = nullptr;
+		}
+
+		~Snapshot(void) {
+			if (_Version) TRCUDomain::Leave();
+		}
+
+		bool Valid(void) const {
+			return _Version != nullptr;
+		}
+
+		operator bool() const {
+			return Valid();
+		}
+
+		Snapshot(_this const &) = delete;
+		_this& operator=(_this const &) = delete;
+		_this& operator=(_this &&) = delete;
+
+		TObject const& operator*(void) const {
+			return _Version->Instance;
+		}
+		TObject const* operator->(void) const {
+			return std::addressof(_Version->Instance);
+		}
+	};
+
+	TLock Lock(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) override {
+		auto iRet = _Lockable.Lock(Timeout, AbortEvent);
+		return std::move(__Begin_Write(iRet));
+	}
+
+	TLock TryLock(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) override {
+		auto iRet = _Lockable.TryLock(SpinCount);
+		return std::move(__Begin_Write(iRet));
+	}
+
+	/**
+	 * Lock for writing and return an accessor of a private copy of managed T instance
+	 * @note The copy is published when the last writer lock is released
+	 **/
+	Accessor Pickup(WAITTIME Timeout = FOREVER, THandleWaitable *AbortEvent = nullptr) {
+		return { Lock(Timeout, AbortEvent) };
+	}
+
+	/**
+	 * Try to lock for writing and return an accessor of a private copy of managed T instance, check validty before access
+	 **/
+	Accessor TryPickup(__ARC_UINT SpinCount = DEFAULT_CRITICALSECTION_SPIN) {
+		return { TryLock(SpinCount) };
+	}
+
+	/**
+	 * Return an invalid accessor
+	 **/
+	Accessor NullAccessor(void) const {
+		return { NullLock() };
+	}
+
+	/**
+	 * Return a snapshot of the currently published T instance
+	 **/
+	Snapshot Read(void) const {
+		TRCUDomain::Enter();
+		return { ~_Current };
+	}
+
+	/**
+	 * Return a snapshot of the currently published T instance, check validity before access
+	 * @note Only fails if the current thread is not yet a registered reader, and registration takes longer than timeout
+	 **/
+	Snapshot TryRead(WAITTIME Timeout) const {
+		if (!TRCUDomain::TryEnter(Timeout)) return { nullptr };
+		return { ~_Current };
+	}
+};
+
 #endif
\ No newline at end of file
@@ -115,18 +115,20 @@ static void SetThreadName(DWORD dwThreadID, LPCSTR threadName) {
 #define WTLogTag _T("WThread '%s'")
 #define WTLogHeader _T("{") WTLogTag _T("} ")
 
+LOGMODULE_DEFINE(LOGMODULE_WTHREAD, _T("WThread"));
+
 void TWorkerThread::__StateNotify(State const &rState) {
-	auto LSubscriberList(LSubscribers[(unsigned int)rState].Pickup());
+	auto LSubscriberList(LSubscribers[(unsigned int)rState].Read());
 	for (size_t i = 0; i < LSubscriberList->size(); i++) {
 		auto & entry = LSubscriberList->at(i);
-		LOGVV(WTLogHeader _T("Notifying [%s] local event '%s'..."), Name.c_str(), STR_State(rState), entry.first.c_str());
+		MLOGVV(LOGMODULE_WTHREAD, WTLogHeader _T("Notifying [%s] local event '%s'..."), Name.c_str(), STR_State(rState), entry.first.c_str());
 		entry.second(*this, rState);
 	}
 
-	auto GSubscriberList(GSubscribers[(unsigned int)rState].Pickup());
+	auto GSubscriberList(GSubscribers[(unsigned int)rState].Read());
 	for (size_t i = 0; i < GSubscriberList->size(); i++) {
 		auto & entry = GSubscriberList->at(i);
-		LOGVV(WTLogHeader _T("Notifying [%s] global event '%s'..."), Name.c_str(), STR_State(rState), entry.first.c_str());
+		MLOGVV(LOGMODULE_WTHREAD, WTLogHeader _T("Notifying [%s] global event '%s'..."), Name.c_str(), STR_State(rState), entry.first.c_str());
 		entry.second(*this, rState);
 	}
 }
@@ -148,12 +150,12 @@ TWorkerThread::TNotificationStub TWorkerThread::StateNotify(TString const &Name,
 				return;
 			}
 		}
-		LOG(WTLogHeader _T("WARNING: Failed to unregister [%s] event '%s'"), Name.c_str(), STR_State(rState), EvtName.c_str());
+		MLOG(LOGMODULE_WTHREAD, WTLogHeader _T("WARNING: Failed to unregister [%s] event '%s'"), Name.c_str(), STR_State(rState), EvtName.c_str());
 		}
 	};
 }
 
-TSyncObj<TWorkerThread::TSubscriberList> TWorkerThread::GSubscribers[(unsigned int)State::__MAX_STATES];
+TRCUObj<TWorkerThread::TSubscriberList> TWorkerThread::GSubscribers[(unsigned int)State::__MAX_STATES];
 
 TWorkerThread::TNotificationStub TWorkerThread::GStateNotify(TString const &Name, State const &rState, TStateNotice const &Func) {
 	auto SubscriberList(GSubscribers[(unsigned int)rState].Pickup());
@@ -192,9 +194,9 @@ TWorkerThread::TNotificationStub TWorkerThread::GStateNotify(TString const &Name
 }
 
 //! Perform logging within a worker thread
-#define WTLOG(s, ...) LOG(WTLogHeader s, Name.c_str(), __VA_ARGS__)
-#define WTLOGV(s, ...) LOGV(WTLogHeader s, Name.c_str(), __VA_ARGS__)
-#define WTLOGVV(s, ...) LOGVV(WTLogHeader s, Name.c_str(), __VA_ARGS__)
+#define WTLOG(s, ...) MLOG(LOGMODULE_WTHREAD, WTLogHeader s, Name.c_str(), __VA_ARGS__)
+#define WTLOGV(s, ...) MLOGV(LOGMODULE_WTHREAD, WTLogHeader s, Name.c_str(), __VA_ARGS__)
+#define WTLOGVV(s, ...) MDLOGVV(LOGMODULE_WTHREAD, WTLogHeader s, Name.c_str(), __VA_ARGS__)
 
 PCTCHAR TWorkerThread::STR_State(State const &xState) {
 	static PCTCHAR _STR_State[] = {
@@ -225,8 +225,8 @@ public:
 
 protected:
 	typedef std::vector<std::pair<TString, TStateNotice>> TSubscriberList;
-	TSyncObj<TSubscriberList> LSubscribers[(unsigned int)State::__MAX_STATES];
-	static TSyncObj<TSubscriberList> GSubscribers[(unsigned int)State::__MAX_STATES];
+	TRCUObj<TSubscriberList> LSubscribers[(unsigned int)State::__MAX_STATES];
+	static TRCUObj<TSubscriberList> GSubscribers[(unsigned int)State::__MAX_STATES];
 
 	void __StateNotify(State const &rState);
 };
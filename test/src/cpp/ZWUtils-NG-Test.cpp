@@ -51,7 +51,9 @@ void TestSyncObj_1();
 void TestWorkerThread();
 void TestSyncObj_2(bool Robust = false);
 void TestSyncQueue(bool Profiling = false);
+void TestReactor();
 void TestNamedPipe();
+void TestAsyncLog();
 
 #ifdef WINDOWS
 int _tmain(int argc, _TCHAR* argv[])
@@ -64,8 +66,8 @@ int _tmain(int argc, _TCHAR* argv[])
 		if (argc != 2)
 			FAIL(_T("Require 1 parameter: <TestType> = 'ALL' | ")
 				 _T("'Exception' / 'ErrCode' / 'StringConv' / 'SyncPrems' / 'DynBuffer' / ")
-				 _T("'ManagedObj' / 'SyncObj' / 'Size' / 'Timing' / 'WorkerThread' / 'SyncQueue'")
-				 _T("'SyncQueueProf' / 'SyncObjRobust'"));
+				 _T("'ManagedObj' / 'SyncObj' / 'Size' / 'Timing' / 'WorkerThread' / 'SyncQueue' / 'Reactor'")
+				 _T("'SyncQueueProf' / 'SyncObjRobust' / 'AsyncLog'"));
 
 		bool TestAll = _tcsicmp(argv[1], _T("ALL")) == 0;
 		if (TestAll || (_tcsicmp(argv[1], _T("Exception")) == 0)) {
@@ -104,9 +106,15 @@ int _tmain(int argc, _TCHAR* argv[])
 		if (TestAll || (_tcsicmp(argv[1], _T("SyncQueue")) == 0)) {
 			TestSyncQueue();
 		}
+		if (TestAll || (_tcsicmp(argv[1], _T("Reactor")) == 0)) {
+			TestReactor();
+		}
 		if (TestAll || _tcsicmp(argv[1], _T("NamedPipe")) == 0) {
 			TestNamedPipe();
 		}
+		if (TestAll || _tcsicmp(argv[1], _T("AsyncLog")) == 0) {
+			TestAsyncLog();
+		}
 		if (_tcsicmp(argv[1], _T("SyncQueueProf")) == 0) {
 			TestSyncQueue(true);
 		}
@@ -210,9 +218,54 @@ void TestStringConv(void) {
 	if (Test2.compare(Test2R) != 0)
 		FAIL(_T("String failed to round-trip!"));
 	_wsetlocale(LC_ALL, ACP_LOCALE());
+
+	WString Test3{ L"Mixed ASCII run longer than one block, \x00E9\x4E2D\xD83D\xDE00 and back to ASCII" };
+	CString Test3C = WStringtoUTF8(Test3);
+	if (Test3C.length() != Test3.length() + 1 + 2 + 2)
+		FAIL(_T("Unexpected UTF-8 length %d"), (int)Test3C.length());
+	if (Test3.compare(UTF8toWString(Test3C)) != 0)
+		FAIL(_T("String failed to round-trip!"));
+
+	TString ConvErrMsg;
+	WStringtoUTF8(WString{ L"Lone \xD800 surrogate" }, ConvErrMsg);
+	if (ConvErrMsg.empty())
+		FAIL(_T("Lone surrogate not reported"));
+	_LOG(_T("Expected conversion warning: %s"), ConvErrMsg.c_str());
+	bool Rejected = false;
+	try {
+		UTF8toWString(CString{ "Overlong \xC0\xAF" });
+	} catch (_ECR_ e) {
+		_LOG(_T("Expected exception: %s"), e.Why().c_str());
+		Rejected = true;
+	}
+	if (!Rejected)
+		FAIL(_T("Ill-formed UTF-8 not rejected"));
 #else
 	// TODO: need test case for non-unicode conversions
 #endif
+
+	_LOG(_T("*** Test String Formatting"));
+	TString Fmt1 = TStringFmt(_T("Int ") << -42 << _T(", hex ") << FmtHex(0xBEEFU, 8) << _T(", padded ") << FmtDec(7, 3)
+							  << _T(", real ") << 2.5);
+	if (Fmt1.compare(_T("Int -42, hex 0000BEEF, padded 007, real 2.5")) != 0)
+		FAIL(_T("Unexpected formatting result '%s'"), Fmt1.c_str());
+	TFormat<8> Fmt2;
+	for (int i = 0; i < 10; i++) Fmt2 << i << _T(',');
+	if (Fmt2.length() != 20) FAIL(_T("Spilled formatting lost data '%s'"), Fmt2.c_str());
+	enum TFmtEnum : char { FmtEnumValue = 65 };
+	if (TStringFmt(FmtEnumValue).compare(_T("65")) != 0) FAIL(_T("Unscoped enum not formatted as integer"));
+	_LOG(_T("Formatted: '%s', '%s'"), Fmt1.c_str(), Fmt2.c_str());
+
+	TString UUIDStr = UUIDToTString(UUIDFromTString(_T("0123abcd-4567-89ef-0a1b-2c3d4e5f6789")));
+	if (UUIDStr.compare(_T("0123ABCD-4567-89EF-0A1B-2C3D4E5F6789")) != 0)
+		FAIL(_T("UUID failed to round-trip '%s'"), UUIDStr.c_str());
+	Cardinal128 Card;
+	Card.fromString(_T("abc0123456789ABCDEF"));
+	if (Card.toString(-1).compare(_T("~0ABC0123456789ABCDEF")) != 0)
+		FAIL(_T("Cardinal failed to round-trip '%s'"), Card.toString(-1).c_str());
+	if (Card != Cardinal128(Card.toGUID()) || std::hash<Cardinal128>()(Card) != std::hash<GUID>()(Card.toGUID()))
+		FAIL(_T("Cardinal and GUID disagree on equality or hash"));
+	_LOG(_T("Hex: %s, %s"), UUIDStr.c_str(), Card.toString().c_str());
 }
 
 void TestSize(void) {
@@ -233,6 +286,8 @@ void TestSize(void) {
 	_LOG(_T(" - GB-MB unit, abbreviate: %s"), ToString(S1G1KN1B, SizeUnit::BYTE, true, true, SizeUnit::GB, SizeUnit::MB).c_str());
 }
 
+#include "Misc/Histogram.h"
+
 void TestTiming(void) {
 	_LOG(_T("*** Test Timing"));
 	TimeStamp Now(TimeStamp::Now());
@@ -277,6 +332,51 @@ void TestTiming(void) {
 	_LOG(_T("Current time - 3 minute: %s"), Now.Offset(-TS3M).toString().c_str());
 	_LOG(_T("Current time + 3 days: %s"), Now.Offset(TS3D).toString().c_str());
 	_LOG(_T("Current time + 3 days + 3 minute - 3 seconds: %s"), Now.Offset(TS3D3MN3S).toString().c_str());
+
+	_LOG(_T("--- Monotonic stamp"));
+	_LOG(_T("Counter frequency: %lld Hz"), TMonotonicStamp::Frequency());
+	TMonotonicStamp MStart(TMonotonicStamp::Now());
+	Sleep(10);
+	TimeSpan MElapsed = TMonotonicStamp::Now() - MStart;
+	_LOG(_T("Sleep 10ms: %s"), MElapsed.toString(false, true, TimeUnit::MSEC, TimeUnit::NSEC).c_str());
+	auto MDue = MStart + TS3S;
+	_LOG(_T("Start + 3 seconds - start: %s"), MDue.From(MStart).toString(TimeUnit::USEC).c_str());
+
+	_LOG(_T("--- Typed span"));
+	constexpr TMSecSpan TS1500MS(1500);
+	constexpr TUSecSpan TS1500MSUS = TS1500MS;
+	static_assert(TS1500MSUS.Count() == 1500000, "Widening conversion");
+	static_assert(TS1500MS.Truncate<TimeUnit::SEC>() == TSecSpan(1), "Truncated conversion");
+	static_assert(TS1500MS.Ceil<TimeUnit::SEC>() == TSecSpan(2), "Ceiling conversion");
+	static_assert(TS1500MSUS + TSecSpan(1) == TUSecSpan(2500000), "Mixed unit arithmetic");
+	TimeSpan TS1500(TS1500MS);
+	_LOG(_T("1500ms typed -> TimeSpan: %s"), TS1500.toString().c_str());
+	if (TUSecSpan(TS1500) != TS1500MSUS) FAIL(_T("TimeSpan round trip mismatch"));
+	auto MDueTyped = MStart + TSecSpan(3);
+	if (MDueTyped != MDue) FAIL(_T("Typed monotonic offset mismatch"));
+	_LOG(_T("Start + 3 seconds - start: %s"), MDueTyped.Since(MStart).toString(TimeUnit::USEC).c_str());
+
+	_LOG(_T("--- Histogram"));
+	THistogram Histogram(_T("Test"));
+	for (int i = 1; i <= 1000; i++) Histogram.Record(TUSecSpan(i));
+	auto Snapshot = Histogram.Snapshot();
+	_LOG(_T("1-1000us: %s"), Snapshot.toString().c_str());
+	auto P99 = Snapshot.Percentile(99).Count();
+	if (P99 < 990000 || P99 > 990000 + 990000 / (HISTOGRAM_SUBBUCKETS / 2))
+		FAIL(_T("Percentile out of precision bound (%lld)"), P99);
+	auto Encoded = Snapshot.Serialize();
+	auto Decoded = THistogram::TSnapshot::Deserialize(&Encoded, Encoded.GetSize());
+	_LOG(_T("Serialized into %d bytes: %s"), (int)Encoded.GetSize(), Decoded.toString().c_str());
+	if (Decoded.Count() != Snapshot.Count() || Decoded.Percentile(50) != Snapshot.Percentile(50))
+		FAIL(_T("Serialization round trip mismatch"));
+
+	_LOG(_T("--- Timestamp formatter"));
+	TTimeStampFormatter Formatter;
+	for (auto Stamp : { Now, Now + TimeSpan(1), Now + TimeSpan(1500), Now + TimeSpan(1, TimeUnit::DAY) }) {
+		PCTCHAR Text = Formatter.Format(Stamp);
+		_LOG(_T("%s"), Text);
+		if (Stamp.toString(TimeUnit::MSEC) != Text) FAIL(_T("Formatter mismatch"));
+	}
 }
 
 #include "Memory/ManagedObj.h"
@@ -457,6 +557,44 @@ void TestSyncPrems() {
 	_LOG(_T("A = %d"), ~A);
 	_LOG(_T("B = %d"), B);
 	_LOG(_T("D = %d"), D);
+
+	_LOG(_T("--- Wait set"));
+	{
+		std::vector<TEvent> Events;
+		Events.reserve(MAXIMUM_WAIT_OBJECTS * 2);
+		MRWaitSet WaitSet = TWaitSet::Create();
+		for (int i = 0; i < MAXIMUM_WAIT_OBJECTS * 2; i++) {
+			Events.emplace_back();
+			WaitSet->Add(Events.back());
+		}
+		Events[3].Set();
+		Events[MAXIMUM_WAIT_OBJECTS + 3].Set();
+		TWaitSet::TReady Ready;
+		WaitResult WRet;
+		// Notifications may trickle in from the thread pool
+		size_t Total = 0;
+		while ((WRet = WaitSet->Wait(Ready, 1000)) == WaitResult::Signaled) {
+			Total += Ready.size();
+			if (Total >= 2) break;
+		}
+		_LOG(_T("Ready %d of %d members"), (int)Total, (int)WaitSet->Count());
+		if (Total != 2) FAIL(_T("Unexpected number of ready members"));
+		WRet = WaitSet->Wait(Ready, 100);
+		_LOG(_T("Wait again: %s"), WaitResultToString(WRet).c_str());
+		if (WRet != WaitResult::TimedOut) FAIL(_T("Auto-reset events should not be reported again"));
+	}
+
+	_LOG(_T("--- Sub-millisecond deadline"));
+	{
+		TEvent Event;
+		TDeadline Deadline(TimeSpan(200, TimeUnit::USEC));
+		TMonotonicStamp Start = TMonotonicStamp::Now();
+		WaitResult WRet = Event.WaitUntil(Deadline);
+		TimeSpan Elapsed = TMonotonicStamp::Now() - Start;
+		_LOG(_T("Wait 200us: %s after %s"), WaitResultToString(WRet).c_str(), Elapsed.toString(TimeUnit::USEC).c_str());
+		if (WRet != WaitResult::TimedOut) FAIL(_T("Unexpected wait result"));
+		if (!Deadline.Expired()) FAIL(_T("Timed out before the deadline"));
+	}
 }
 
 #include "Memory/Resource.h"
@@ -537,6 +675,7 @@ void TestDynBuffer() {
 }
 
 #include "Threading/SyncObjects.h"
+#include "Threading/LockProfile.h"
 
 struct Integer {
 	int value;
@@ -560,6 +699,55 @@ bool operator==(Integer const &A, Integer const &B) {
 
 typedef TSyncObj<Integer> TSyncInteger;
 
+template<class L>
+void TestSpinLock(LPCTSTR Name) {
+	_LOG(_T("--- Spin lock (%s)"), Name);
+	TSyncObj<Integer, L> A;
+	{
+		auto SA(A.Pickup());
+		_LOG(_T("Pickup : %s"), SA.toString().c_str());
+		_LOG(_T("Try pickup while locked (Expect failure)"));
+		if (A.TryPickup(16)) FAIL(_T("Acquired lock (concurrency violation)"));
+		_LOG(_T("Pickup while locked (Expect timeout in 0.1 sec)"));
+		if (A.Pickup(100)) FAIL(_T("Acquired lock (concurrency violation)"));
+	}
+	_LOG(_T("Try pickup after release (Expect success)"));
+	if (!A.TryPickup()) FAIL(_T("Unable to acquire lock"));
+	_LOG(_T("A++ : %d"), (*A.Pickup())++);
+
+	_LOG(_T("Timed pickup under contention (Not fair, expect some timeouts)"));
+	{
+		class TestContend : public TRunnable {
+		protected:
+			TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncInt) override {
+				TSyncObj<Integer, L>* Ctr = static_cast<TSyncObj<Integer, L>*>(*pSyncInt);
+				for (int i = 0; i < 100000; i++) (*Ctr->Pickup())++;
+				return {};
+			}
+		};
+
+		ExtAllocator NullAlloc;
+		int Initial = A.Pickup()->value;
+		std::vector<MRWorkerThread> Threads;
+		for (int i = 0; i < 4; i++) {
+			Threads.emplace_back(TWorkerThread::Create(TStringCast(_T("Contender") << i),
+				{ DEFAULT_NEW(TestContend), CONSTRUCTION::HANDOFF }), CONSTRUCTION::HANDOFF);
+			Threads.back()->Start({ &A, sizeof(void*), NullAlloc });
+		}
+		int Acquired = 0, TimedOut = 0;
+		for (int i = 0; i < 1000; i++) {
+			auto SA(A.Pickup(1));
+			if (SA) {
+				(*SA)++;
+				Acquired++;
+			} else TimedOut++;
+		}
+		for (auto &Thread : Threads) Thread->WaitFor();
+		_LOG(_T("Timed pickups : %d acquired, %d timed out"), Acquired, TimedOut);
+		if (A.Pickup()->value != Initial + 4 * 100000 + Acquired) FAIL(_T("Lost update (concurrency violation)"));
+	}
+}
+
 void TestSyncObj_1(void) {
 	_LOG(_T("*** Test SyncObj (Non-threading correctness)"));
 	TSyncInteger A;
@@ -608,6 +796,73 @@ void TestSyncObj_1(void) {
 	_LOG(_T("A <=50=> D : %d"), A.Pickup()->CompareAndSwap(50, D));
 	_LOG(_T("A : %d"), A.Pickup()->value);
 	_LOG(_T("D : %d"), D.value);
+
+	TestSpinLock<TLockableTTAS>(_T("TTAS"));
+	TestSpinLock<TLockableTicket>(_T("Ticket"));
+	TestSpinLock<TLockableMCS>(_T("MCS"));
+
+	_LOG(_T("--- Distributed reader-writer lock"));
+	{
+		TSyncObj<Integer, TLockableDRW> B;
+		{
+			auto SB1(B.Pickup_Read());
+			auto SB2(B.TryPickup_Read());
+			_LOG(_T("Shared pickup : %s, %s"), SB1.toString().c_str(), SB2.toString().c_str());
+			_LOG(_T("Pickup while shared (Expect timeout in 0.1 sec)"));
+			if (B.Pickup(100)) FAIL(_T("Acquired lock (concurrency violation)"));
+		}
+		{
+			auto SB(B.Pickup());
+			_LOG(_T("B++ : %d"), (*SB)++);
+			_LOG(_T("Shared pickup while locked (Expect timeout in 0.1 sec)"));
+			if (B.Pickup_Read(100)) FAIL(_T("Acquired lock (concurrency violation)"));
+		}
+		_LOG(_T("B : %d"), B.Pickup_Read()->value);
+	}
+
+	_LOG(_T("--- Sequence lock"));
+	{
+		struct TPair { int X, Y; };
+		TSeqLockObj<TPair> C(TPair{ 1, 2 });
+		{
+			auto SC(C.Pickup());
+			SC->X = 3;
+			SC->Y = 4;
+		}
+		TPair P = C.Read();
+		_LOG(_T("Snapshot : %d, %d"), P.X, P.Y);
+		if (P.X != 3 || P.Y != 4) FAIL(_T("Unexpected snapshot"));
+	}
+
+	_LOG(_T("--- Read-copy-update"));
+	{
+		TRCUObj<std::vector<int>> C(std::vector<int>({ 1, 2 }));
+		auto S(C.Read());
+		{
+			auto SC(C.Pickup());
+			SC->push_back(3);
+		}
+		_LOG(_T("Old snapshot : %d items"), (int)S->size());
+		if (S->size() != 2) FAIL(_T("Unexpected snapshot"));
+		_LOG(_T("New snapshot : %d items"), (int)C.Read()->size());
+		if (C.Read()->size() != 3) FAIL(_T("Unexpected snapshot"));
+	}
+
+	_LOG(_T("--- Lock profile"));
+	{
+		TLockableProfiled<TLockableCS> C(_T("Test"));
+		for (int i = 0; i < 3; i++) C.Lock();
+		TLockProfile::Dump();
+		if (C.Profile().Stats().Acquired != 3) FAIL(_T("Unexpected acquisition count"));
+
+		TLockableProfiled<TLockableSRW> R(_T("Test Shared"));
+		{
+			auto Reader1 = R.Lock_Read();
+			auto Reader2 = R.TryLock_Read();
+			if (!Reader2) FAIL(_T("Shared lock should be available"));
+		}
+		if (R.Profile().Stats().Acquired != 2) FAIL(_T("Unexpected shared acquisition count"));
+	}
 }
 
 #include "Threading/WorkerThread.h"
@@ -1172,9 +1427,9 @@ void TestSyncQueue(bool Profiling) {
 				TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncIntQueue) override {
 					TSyncIntQueue& Q = *static_cast<TSyncIntQueue*>(*pSyncIntQueue);
 					int COUNT = 10000000;
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					for (int i = 0; i < COUNT; i++) Q.Push_Back(i);
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Enqueue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1187,13 +1442,13 @@ void TestSyncQueue(bool Profiling) {
 				TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncIntQueue) override {
 					TSyncIntQueue& Q = *static_cast<TSyncIntQueue*>(*pSyncIntQueue);
 					int COUNT = 10000000;
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					int j = -1;
 					for (int i = 0; i < COUNT; i++) {
 						Q.Pop_Front(j);
 						if (i != j) FAIL(_T("Expect %d, got %d"), i, j);
 					}
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Dequeue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1218,9 +1473,9 @@ void TestSyncQueue(bool Profiling) {
 				TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncIntQueue) override {
 					TSyncIntQueue& Q = *static_cast<TSyncIntQueue*>(*pSyncIntQueue);
 					int COUNT = 10000000;
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					for (int i = 0; i < COUNT; i++) Q.Push_Back(i);
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Enqueue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1233,13 +1488,13 @@ void TestSyncQueue(bool Profiling) {
 				TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncIntQueue) override {
 					TSyncIntQueue& Q = *static_cast<TSyncIntQueue*>(*pSyncIntQueue);
 					int COUNT = 10000000;
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					int j = -1;
 					for (int i = 0; i < COUNT; i++) {
 						Q.Pop_Front(j);
 						if (i != j) FAIL(_T("Expect %d, got %d"), i, j);
 					}
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Dequeue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1264,9 +1519,9 @@ void TestSyncQueue(bool Profiling) {
 				TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncIntQueue) override {
 					TSyncIntQueue& Q = *static_cast<TSyncIntQueue*>(*pSyncIntQueue);
 					int COUNT = 10000000;
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					for (int i = 0; i < COUNT; i++) Q.Push_Back(i);
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Enqueue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1279,13 +1534,13 @@ void TestSyncQueue(bool Profiling) {
 				TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncIntQueue) override {
 					TSyncIntQueue& Q = *static_cast<TSyncIntQueue*>(*pSyncIntQueue);
 					int COUNT = 10000000;
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					int j = -1;
 					for (int i = 0; i < COUNT; i++) {
 						Q.Pop_Front(j);
 						if (i != j) FAIL(_T("Expect %d, got %d"), i, j);
 					}
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Dequeue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1310,9 +1565,9 @@ void TestSyncQueue(bool Profiling) {
 				TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncIntQueue) override {
 					TSyncIntQueue& Q = *static_cast<TSyncIntQueue*>(*pSyncIntQueue);
 					int COUNT = 10000000;
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					for (int i = 0; i < COUNT; i++) Q.Push_Back(i);
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Enqueue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1325,13 +1580,13 @@ void TestSyncQueue(bool Profiling) {
 				TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncIntQueue) override {
 					TSyncIntQueue& Q = *static_cast<TSyncIntQueue*>(*pSyncIntQueue);
 					int COUNT = 10000000;
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					int j = -1;
 					for (int i = 0; i < COUNT; i++) {
 						Q.Pop_Front(j);
 						if (i != j) FAIL(_T("Expect %d, got %d"), i, j);
 					}
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Dequeue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1356,9 +1611,9 @@ void TestSyncQueue(bool Profiling) {
 				TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncIntQueue) override {
 					TSyncIntQueue& Q = *static_cast<TSyncIntQueue*>(*pSyncIntQueue);
 					int COUNT = 10000000;
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					for (int i = 0; i < COUNT; i++) Q.Push_Back(i);
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Enqueue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1371,13 +1626,13 @@ void TestSyncQueue(bool Profiling) {
 				TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncIntQueue) override {
 					TSyncIntQueue& Q = *static_cast<TSyncIntQueue*>(*pSyncIntQueue);
 					int COUNT = 10000000;
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					int j = -1;
 					for (int i = 0; i < COUNT; i++) {
 						Q.Pop_Front(j);
 						if (i != j) FAIL(_T("Expect %d, got %d"), i, j);
 					}
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Dequeue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1421,6 +1676,17 @@ void TestSyncQueue(bool Profiling) {
 			} else {
 				FAIL(_T("Failed to lock empty queue (unexpected)"));
 			}
+
+			_LOG(_T("Pop -> A (Deadline 0.5 seconds, expect cancellation after 0.1 seconds)"));
+			TCancelToken Cancel;
+			auto Canceller = TAlarmClock::Create(TimeSpan(100, TimeUnit::MSEC), [&](TimeStamp const &) { Cancel.Cancel(); });
+			TDeadline Deadline(500);
+			if (TestQueue.Pop_Front(A, Deadline, &Cancel)) {
+				FAIL(_T("Should not reach"));
+			} else if (Deadline.Expired()) {
+				FAIL(_T("Cancellation not observed (unexpected)"));
+			} else { _LOG(_T("Cancelled dequeue (expected, %u ms left)"), Deadline.Remaining()); }
+			_LOG(_T("Cancelled token wait : %s"), WaitResultToString(Cancel.WaitFor(0)).c_str());
 		}
 
 		_LOG(_T("*** Test SyncQueue (Threading correctness)"));
@@ -1441,9 +1707,9 @@ void TestSyncQueue(bool Profiling) {
 #else
 					int COUNT = 50000000;
 #endif
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					for (int i = 0; i < COUNT; i++) Q.push(i);
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Enqueue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1460,13 +1726,13 @@ void TestSyncQueue(bool Profiling) {
 #else
 					int COUNT = 50000000;
 #endif
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					int j;
 					for (int i = 0; i < COUNT; i++) {
 						j = Q.pop();
 						if (i != j) FAIL(_T("Expect %d, got %d"), i, j);
 					}
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Dequeue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1487,7 +1753,7 @@ void TestSyncQueue(bool Profiling) {
 				}
 
 		{
-			typedef TSyncBlockingDeque<int> TSyncIntQueue;
+			typedef TSyncBlockingDeque<int, TSDQPolicy_SharedIter> TSyncIntQueue;
 			class TestQueuePut : public TRunnable {
 			protected:
 				TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &pSyncIntQueue) override {
@@ -1497,9 +1763,9 @@ void TestSyncQueue(bool Profiling) {
 #else
 					int COUNT = 50000000;
 #endif
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					for (int i = 0; i < COUNT; i++) Q.Push_Back(i);
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Enqueue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1516,13 +1782,13 @@ void TestSyncQueue(bool Profiling) {
 #else
 					int COUNT = 50000000;
 #endif
-					TimeStamp StartTime = TimeStamp::Now();
+					TMonotonicStamp StartTime = TMonotonicStamp::Now();
 					int j = -1;
 					for (int i = 0; i < COUNT; i++) {
 						Q.Pop_Front(j);
 						if (i != j) FAIL(_T("Expect %d, got %d"), i, j);
 					}
-					TimeStamp EndTime = TimeStamp::Now();
+					TMonotonicStamp EndTime = TMonotonicStamp::Now();
 
 					double TimeSpan = (double)EndTime.From(StartTime).GetValue(TimeUnit::NSEC) / (unsigned long long)TimeUnit::SEC;
 					_LOG(_T("Dequeue done! (%d ops in %.2f sec, %.2f ops/sec)"), COUNT, TimeSpan, COUNT / TimeSpan);
@@ -1551,7 +1817,6 @@ void TestSyncQueue(bool Profiling) {
 				TDelayWaitable WaitASec(2000);
 				WaitASec.WaitFor(FOREVER);
 			}
-#ifdef __SDQ_ITERATORS
 			{
 				_LOG(_T("Trying to grab push-pop lock..."));
 				TSyncIntQueue::MRLock PPLock(CONSTRUCTION::EMPLACE, Queue.Lock());
@@ -1571,7 +1836,6 @@ void TestSyncQueue(bool Profiling) {
 				_LOG(_T("Current queue length: %d"), Queue.Length());
 				_LOG(_T("Releasing push-pop lock..."));
 			}
-#endif
 			{
 				_LOG(_T("Trying to grab empty lock..."));
 				auto ELock = Queue.DrainAndLock();
@@ -1587,7 +1851,6 @@ void TestSyncQueue(bool Profiling) {
 				TDelayWaitable WaitASec(2000);
 				WaitASec.WaitFor(FOREVER);
 			}
-#ifdef __SDQ_ITERATORS
 			{
 				_LOG(_T("Trying to grab push-pop lock..."));
 				TSyncIntQueue::MRLock PPLock(CONSTRUCTION::EMPLACE, Queue.Lock());
@@ -1607,7 +1870,6 @@ void TestSyncQueue(bool Profiling) {
 				_LOG(_T("Current queue length: %d"), Queue.Length());
 				_LOG(_T("Releasing push-pop lock..."));
 			}
-#endif
 			{
 				_LOG(_T("Trying to grab empty lock..."));
 				auto ELock = Queue.DrainAndLock();
@@ -1618,7 +1880,6 @@ void TestSyncQueue(bool Profiling) {
 				Queue.Deflate();
 				_LOG(_T("Releasing empty lock..."));
 			}
-#ifdef __SDQ_MUTABLE_ITERATORS
 			{
 				_LOG(_T("Sleep for 2 sec..."));
 				TDelayWaitable WaitASec(2000);
@@ -1710,7 +1971,6 @@ void TestSyncQueue(bool Profiling) {
 					IterThread->Start(TFixedBuffer::Unmanaged(&Queue));
 					Sleep(1000);
 
-#ifdef __SDQ_CONCURRENT_CONST_ITERATORS
 					{
 						_LOG(_T("---- #2.1 Starting parallel const iteration..."));
 						_LOG(_T("Trying to grab push-pop lock..."));
@@ -1752,7 +2012,6 @@ void TestSyncQueue(bool Profiling) {
 						}
 						_LOG(_T("---- #2.2 Parallel mutable iteration finished..."));
 					}
-#endif
 
 					IterThread->WaitFor();
 					auto IterExcept = IterThread->FatalException(true);
@@ -1767,14 +2026,43 @@ void TestSyncQueue(bool Profiling) {
 				_LOG(_T("Getter crashed (expected):"));
 				GetExcept->Show();
 			} else FAIL(_T("Getter did not observe queue modification!"));
-#else
-			GetThread2->WaitFor();
-#endif
 			_LOG(_T("--- Finished All Queue Operation..."));
 			}
 				}
 			}
 
+#include "Threading/Reactor.h"
+
+void TestReactor(void) {
+	_LOG(_T("*** Test Reactor"));
+	TReactor Reactor;
+	TSyncBlockingDeque<int> Queue;
+	int Sum = 0;
+
+	Reactor.WatchContent(Queue, [&] {
+		int Entry;
+		while (Queue.Length() && Queue.Pop_Front(Entry, 0)) {
+			_LOG(_T("Popped %d"), Entry);
+			if ((Sum += Entry) == 6) Reactor.Stop();
+		}
+	});
+	for (int i = 1; i <= 3; i++) {
+		Reactor.Schedule(TimeSpan(i * 50), [&, i](TimeStamp const &DueTS) {
+			_LOG(_T("Timer #%d due %s"), i, DueTS.toString().c_str());
+			Queue.Push_Back(i);
+		});
+	}
+	auto Cancelled = Reactor.Schedule(TimeSpan(10), [&](TimeStamp const &) {
+		FAIL(_T("Cancelled timer fired"));
+	});
+	Reactor.Cancel(Cancelled);
+	Reactor.Post([&] { _LOG(_T("Posted closure running")); });
+
+	Reactor.Run();
+	_LOG(_T("Reactor stopped, sum = %d"), Sum);
+	if (Sum != 6) FAIL(_T("Unexpected sum"));
+}
+
 #include "Comm/NamedPipe.h"
 
 #define NAMEDPIPE_TEST		_T("ZWUtils-Test")
@@ -1933,3 +2221,135 @@ void TestNamedPipe(void) {
 		}
 	}
 }
+
+#include "Debug/LogFile.h"
+#include "Debug/FlightRecorder.h"
+
+void TestAsyncLog(void) {
+	class TestLogRunnable : public TRunnable {
+	protected:
+		TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &Arg) override {
+			for (int i = 0; i < 200; i++) _LOG(_T("Message #%d from %s"), i, WorkerThread.Name.c_str());
+			return {};
+		}
+	};
+
+	_LOG(_T("*** Test Asynchronous Logging (count drops, small rings)"));
+	STARTASYNCLOG(TLogOverflow::Count, 0x1000);
+	{
+		std::vector<MRWorkerThread> Threads;
+		for (int i = 0; i < 4; i++) {
+			Threads.emplace_back(TWorkerThread::Create(TStringCast(_T("Logger") << i),
+				{ DEFAULT_NEW(TestLogRunnable), CONSTRUCTION::HANDOFF }), CONSTRUCTION::HANDOFF);
+			Threads.back()->Start();
+		}
+		for (auto &Thread : Threads) Thread->WaitFor();
+	}
+	FLUSHASYNCLOG();
+	STOPASYNCLOG();
+
+	_LOG(_T("*** Test Asynchronous Logging (block)"));
+	STARTASYNCLOG(TLogOverflow::Block, 0x1000);
+	for (int i = 0; i < 200; i++) _LOG(_T("Message #%d"), i);
+	STOPASYNCLOG();
+	_LOG(_T("Back to synchronous logging"));
+
+	_LOG(_T("*** Test Deferred Logging"));
+	_DLOG(_T("Synchronous: %d, %lld, %.2f, %s, %S, %p"), 1, 2LL, 3.0, _T("four"), "five", (void*)nullptr);
+	STARTASYNCLOG();
+	for (int i = 0; i < 10; i++) _DLOG(_T("Asynchronous #%d: %s"), i, (i & 1) ? _T("odd") : _T("even"));
+	FLUSHASYNCLOG();
+
+	FILE *Binary;
+	if (tmpfile_s(&Binary) != 0) FAIL(_T("Unable to create temporary file"));
+	SETDEFERLOGTARGET(Binary);
+	for (int i = 0; i < 10; i++) _DLOG(_T("Binary #%d: %s"), i, (PCTCHAR)nullptr);
+	SETDEFERLOGTARGET(nullptr);
+	STOPASYNCLOG();
+	rewind(Binary);
+	_LOG(_T("Decoded %Iu records"), DECODEDEFERLOG(Binary, stderr));
+	fclose(Binary);
+
+	_LOG(_T("*** Test Runtime Log Levels"));
+	SETLOGLEVELS(_T("VeryVerbose,SyncDQ=Off"));
+	if (GETLOGLEVEL(_T("SyncDQ")) != TLogLevel::Off) FAIL(_T("SyncDQ level not applied"));
+	if (GETLOGLEVEL(_T("WThread")) != TLogLevel::VeryVerbose) FAIL(_T("Global level not applied"));
+	LOG(_T("Visible at level VeryVerbose"));
+	SETLOGLEVEL(TLogLevel::Off);
+	LOG(_T("ERROR: Should not be visible at level Off"));
+	RESETLOGLEVEL(_T("SyncDQ"));
+	SETLOGLEVEL(LOGLEVEL_DEFAULT);
+	if (GETLOGLEVEL(_T("SyncDQ")) != LOGLEVEL_DEFAULT) FAIL(_T("SyncDQ level not reset"));
+	SETLOGTARGETLEVEL(LOGTARGET_CONSOLE, TLogLevel::Off);
+	_LOG(_T("ERROR: Should not be visible on console target at level Off"));
+	SETLOGTARGETLEVEL(LOGTARGET_CONSOLE, TLogLevel::VeryVerbose);
+	_LOG(_T("Console target restored"));
+
+	_LOG(_T("*** Test Throttled Logging"));
+	for (int i = 0; i < 20; i++) {
+		LOG_EVERY_N(5, _T("Every 5th: #%d"), i);
+		LOG_FIRST_N(3, _T("First 3: #%d"), i);
+		LOG_SAMPLED(0.2, _T("Sampled: #%d"), i);
+	}
+	for (int i = 0; i < 40; i++) {
+		// Expecting 10 in each second, with a summary of 10 suppressed
+		LOG_RATE_LIMITED(10, _T("Rate limited: #%d"), i);
+		if (i == 19) Sleep(1000);
+	}
+
+	_LOG(_T("*** Test Closing Log Target While Logging"));
+	{
+		class TestCloseRunnable : public TRunnable {
+		protected:
+			bool volatile _Stop = false;
+
+		public:
+			TFixedBuffer Run(TWorkerThread &WorkerThread, TFixedBuffer &Arg) override {
+				TString const Target(_T(".Closing"));
+				for (int i = 0; !_Stop; i++) _TLOG(&Target, _T("Closing target message #%d"), i);
+				return {};
+			}
+
+			void StopNotify(TWorkerThread &WorkerThread) override {
+				_Stop = true;
+			}
+		};
+
+		MRWorkerThread Logger(TWorkerThread::Create(_T("CloseLogger"),
+			{ DEFAULT_NEW(TestCloseRunnable), CONSTRUCTION::HANDOFF }), CONSTRUCTION::HANDOFF);
+		Logger->Start();
+		for (int i = 0; i < 100; i++) {
+			// The target must not be written to after SETLOGTARGET returns, so it is safe to close right away
+			FILE *Target;
+			if (tmpfile_s(&Target) != 0) FAIL(_T("Unable to create temporary file"));
+			SETLOGTARGET(_T(".Closing"), Target);
+			Sleep(1);
+			SETLOGTARGET(_T(".Closing"), nullptr);
+			fclose(Target);
+		}
+		Logger->SignalTerminate();
+		Logger->WaitFor();
+	}
+
+	_LOG(_T("*** Test Rotating Log File"));
+	TCHAR TempDir[MAX_PATH];
+	if (!GetTempPath(MAX_PATH, TempDir)) SYSFAIL(_T("Unable to get temporary directory"));
+	TString LogPath = TStringCast(TempDir << _T("ZWUtils-Test.log"));
+	SETLOGFILETARGET(_T("TestFile"), LogPath, TLogRotation(0x1000, TimeSpan(LOGFILE_MAXAGE), 2));
+	for (int r = 0; r < 4; r++) {
+		// Expecting one rotation per round, keeping only 2 compressed segments
+		for (int i = 0; i < 100; i++) _LOG(_T("Rotating #%d-%d"), r, i);
+		Sleep(1500);
+	}
+	SETLOGFILETARGET(_T("TestFile"), EMPTY_TSTRING());
+	_LOG(_T("Log segments at '%s.*'"), LogPath.c_str());
+
+	_LOG(_T("*** Test Flight Recorder"));
+	TString RecPath = TStringCast(TempDir << _T("ZWUtils-Test.rec"));
+	STARTFLIGHTRECORDER(RecPath, 4, 16);
+	for (int i = 0; i < 20; i++) {
+		// Expecting only the last 16 events
+		FLIGHTREC("Test Event", i, i * 2);
+	}
+	_LOG(_T("Dumped %Iu events"), DUMPFLIGHTRECORDER(RecPath, stderr));
+}